@@ -6,6 +6,18 @@
 #include "Helpers/DHT11.h"
 #include "Helpers/SBRp1IO.h"
 #include "Helpers/SBRP1Pwm.h"
+#include "Helpers/RP1Waveform.h"
+#include "Helpers/SBDelay.h"
+#include "Helpers/SBRealtime.h"
+#include "Helpers/RP1Capture.h"
+#include "Helpers/RP1Stream.h"
+#include "Helpers/RP1Decode.h"
+#include "Helpers/RP1Port.h"
+#include "Helpers/RP1Clock.h"
+#include "Helpers/RP1EdgeDetector.h"
+#include "Helpers/RP1PwmStream.h"
+#include "Helpers/RP1PwmTransaction.h"
+#include "Helpers/RP1Wavetable.h"
 #include "Tracer/cfunctracer.h"
 #include "Tracer/ctracer.h"
 
@@ -17,6 +29,8 @@
 #include <unordered_map>
 #include <vector>
 #include <exception>
+#include <functional>
+#include <thread>
 #include <readline/readline.h>
 #include <readline/history.h>
 
@@ -29,6 +43,9 @@ std::shared_ptr<CFileTracer> tracer = std::make_shared<CFileTracer>("./", "cliAp
 std::unique_ptr<SB::RPI5::RP1IO> GpioRegisters = nullptr;
 std::unique_ptr<SB::RPI5::RP1PWM> PwmRegisters = nullptr;
 int pinNr = -1;
+std::unique_ptr<SB::RPI5::RP1Snapshot_t> LastSnapshot = nullptr;
+bool RealtimeAll = false;
+SB::RPI5::SBRealtimeConfig_t RealtimeConfig = SB::RPI5::SBRealtime::defaultConfig();
 SB::RPI5::SBPio ioPin(tracer);
 
 enum class eCmd
@@ -54,6 +71,17 @@ enum class eCmd
     eGetPAD,
     eFastClk,
     ePinSetFunction,
+    eGpioDump,
+    eWaveform,
+    eRtMode,
+    eCapture,
+    eStream,
+    eStreamRead,
+    eDecode,
+    ePort,
+    eEdges,
+    eLoadProfile,
+    ePwmStream,
 
     // PWM Commands
     ePwmGetRegGlobal,
@@ -62,6 +90,7 @@ enum class eCmd
     ePwmSetClk,
     ePwmSetRangeDutyPhase,
     ePwmSetFrequencyDuty,
+    ePwmCommit,
     ePwmEnable,
     ePwmDisable,
     ePwmSetMode,
@@ -118,6 +147,38 @@ void LogErrors(std::vector<std::string>& errors)
 
 }
 
+// --pins=a,b,c as a RIO bank 0 mask; a pin that is not a number or not
+// below 28 is reported in errors
+bool ParsePinMask(const std::string& text, uint32_t& mask, std::vector<std::string>& errors)
+{
+    mask = 0;
+    for (const auto& pin : string_ext::split(text, ','))
+    {
+        size_t used = 0;
+        unsigned long nr = SB::RPI5::RP1_BANK_PINS[0];
+        try
+        {
+            nr = std::stoul(pin, &used);
+        }
+        catch(const std::exception&)
+        {
+            used = 0;
+        }
+        if ((used == 0) || (used != pin.size()) || (nr >= SB::RPI5::RP1_BANK_PINS[0]))
+        {
+            errors.emplace_back(std::format("SYNTAX-ERROR : pin '{}' should be 0..{}", pin, SB::RPI5::RP1_BANK_PINS[0] - 1));
+            return false;
+        }
+        mask |= 1u << nr;
+    }
+    if (mask == 0)
+    {
+        errors.emplace_back("SYNTAX-ERROR : no pins given");
+        return false;
+    }
+    return true;
+}
+
 eCmd GetCommand(std::string& command)
 {
 	CFuncTracer trace("GetCommands", tracer, false);
@@ -142,6 +203,17 @@ eCmd GetCommand(std::string& command)
     if (sLower.find("getrpioinsync") != std::string::npos) return eCmd::eGetRpioInSync;
     if (sLower.find("getrpioin") != std::string::npos) return eCmd::eGetRpioIn;
     if (sLower.find("getpad") != std::string::npos) return eCmd::eGetPAD;
+    if (sLower.find("gpiodump") != std::string::npos) return eCmd::eGpioDump;
+    if (sLower.find("waveform") != std::string::npos) return eCmd::eWaveform;
+    if (sLower.find("rtmode") != std::string::npos) return eCmd::eRtMode;
+    if (sLower.find("capture") != std::string::npos) return eCmd::eCapture;
+    if (sLower.find("pwmstream") != std::string::npos) return eCmd::ePwmStream;
+    if (sLower.find("streamread") != std::string::npos) return eCmd::eStreamRead;
+    if (sLower.find("stream") != std::string::npos) return eCmd::eStream;
+    if (sLower.find("decode") != std::string::npos) return eCmd::eDecode;
+    if (sLower.find("port") != std::string::npos) return eCmd::ePort;
+    if (sLower.find("edges") != std::string::npos) return eCmd::eEdges;
+    if (sLower.find("loadprofile") != std::string::npos) return eCmd::eLoadProfile;
     if (sLower.find("fastclk") != std::string::npos) return eCmd::eFastClk;
     if (sLower.find("pwmgetregglobal") != std::string::npos) return eCmd::ePwmGetRegGlobal;
     if (sLower.find("pwmgetreg") != std::string::npos) return eCmd::ePwmGetReg;
@@ -149,6 +221,7 @@ eCmd GetCommand(std::string& command)
     if (sLower.find("pwmsetclk") != std::string::npos) return eCmd::ePwmSetClk;
     if (sLower.find("pwmsetrange") != std::string::npos) return eCmd::ePwmSetRangeDutyPhase;
     if (sLower.find("pwmsetfreq") != std::string::npos) return eCmd::ePwmSetFrequencyDuty;
+    if (sLower.find("pwmcommit") != std::string::npos) return eCmd::ePwmCommit;
     if (sLower.find("pwmenable") != std::string::npos) return eCmd::ePwmEnable;
     if (sLower.find("pwmdisable") != std::string::npos) return eCmd::ePwmDisable;
     if (sLower.find("pwmsetmode") != std::string::npos) return eCmd::ePwmSetMode;
@@ -170,13 +243,13 @@ void Usage(const std::vector<std::string>& errors)
     cout << "    - setHigh : set the pin high (mandatory --pin)" << endl;
     cout << "    - setLow  : set the pin low (mandatory --pin)" << endl;
     cout << "    - getinput : gets the input of the pin" << endl;
-    cout << "    - setpulse : generates a positive or negative pulse on a GPIO (min 180µs) (mandatory --pin, --width)" << endl;
+    cout << "    - setpulse : generates a positive or negative pulse on a GPIO (mandatory --pin, --width)" << endl;
     cout << "                 (optional -listen)" << endl;
     cout << "    - ispinfree : checks if pin is free (mandatory --pin)" << endl;
-    cout << "    - measrc  : measure the time that a capa is loaded when the io pin is released (mandatory --pin)" << endl;
+    cout << "    - measrc  : measure the time that a capa is loaded when the io pin is released (mandatory --pin, optional -rio)" << endl;
 	cout << "    - enumschips : enumerate the chips" << endl;
 	cout << "    - testparameterparsing: logs the parameters given with this command" << endl;
-    cout << "    - readdht11 : reads the temperature and humidity" << endl;
+    cout << "    - readdht11 : reads the temperature and humidity (mandatory --pin, -rio takes the edges from the RIO edge detector)" << endl;
     cout << "    - getgpiostatus : get the status register of specific GPIO pin (mandatory --pin)" << endl;
     cout << "    - getgpiocntrl : get the control register of specific GPIO pin (mandatory --pin)" << endl;
     cout << "    - getrpioout : get the RIO_OUT register for all IO pins" << endl;
@@ -185,39 +258,84 @@ void Usage(const std::vector<std::string>& errors)
     cout << "    - getrpioin : get the RIO_IN register for all IO pins" << endl;
     cout << "    - getpad : get the PAD register of specific GPIO pin (mandatory --pin)" << endl;
     cout << "    - setfunction: set the pad and function for a specific pin (mandatory --pin, --pad, --func)" << endl;
-    cout << "    - fastclk : generates a fast clk (mandatory --pin, --periods)" << endl;
+    cout << "    - gpiodump : GPIO/PAD/RIO state of all 54 pins in one table (optional -diff)" << endl;
+    cout << "    - fastclk : generates a fast clk (mandatory --pin, --periods) or a timer paced clock (mandatory --pin(s), --freq, optional --duty, --phase, --duration)" << endl;
+    cout << "    - capture : logic analyser on RIO inputs (mandatory --pins, optional --pre, --post, --trigger, --timeout, --vcd, -insync, -rt)" << endl;
+    cout << "    - stream : continuous capture of RIO input changes to a file (mandatory --pins, --file, optional --duration, --block, --flush, --rtcpu, --rtprio, -insync)" << endl;
+    cout << "    - streamread : reads a stream file, seeking by time (mandatory --file, optional --from, --to)" << endl;
+    cout << "    - decode : decodes uart, spi, i2c or 1-wire from a stream file (mandatory --file, --proto, --pins, optional --baud, --bits, --parity, --mode, --from, --to, -lsb)" << endl;
+    cout << "    - port : reads or writes an ordered set of RIO pins as one value (mandatory --pins, optional --value)" << endl;
+    cout << "    - edges : prints the edges on RIO pins, found by polling RIO_INSYNC on a pinned core (mandatory --pins, optional --count, --timeout)" << endl;
+    cout << "    - loadprofile : validates a pin profile and applies it in one pass, shows what changed (mandatory --file, -check only shows the plan)" << endl;
+    cout << "    - rtmode : real-time mode for setpulse, fastclk, measrc, readdht11 and waveform for all commands (-on/-off, optional --rtcpu, --rtprio)" << endl;
+    cout << "    - waveform : bit-bangs a timed pattern on a RIO pin and reports the timing (mandatory --pin, --pattern, optional --repeat)" << endl;
     cout << "    - pwmgetregglobal: get pwm global registers (optional --base)" << endl;
     cout << "    - pwmgetreg: get pwm registrs (mandatory --pin, optional --base)" << endl;
-    cout << "    - pwmgetclk: get the pwm clock registers" << endl;
+    cout << "    - pwmgetclk: get the pwm clock registers (optional --base)" << endl;
     cout << "    - pwmsetclk: set the pwm clock (mandatory --div, --pin and --frac)" << endl;
     cout << "    - pwmsetrange: set the range/phase/duty of the pwm signal (mandatory --pin, --range, --duty and --phase)" << endl;
-    cout << "    - pwmsetfreq: set the frequency of the pwm signal (mandatory --pin, --freq and --duty)" << endl;
+    cout << "    - pwmsetfreq: set the frequency of the pwm signal, solving clock divider and range (mandatory --pin, --freq and --duty, optional --steps)" << endl;
+    cout << "    - pwmcommit: sets range/duty/phase of several pwm pins, switching together on one update (mandatory --set)" << endl;
     cout << "    - pwmenable: enable the pwm (mandatory --pin)" << endl;
     cout << "    - pwmdisable: disable the pwm (mandatory --pin)" << endl;
     cout << "    - pwmsetmode: set the mode of the pwm (mandatory --pin, --pwmmode)" << endl;
     cout << "    - pwmsetinvert: invert the pwm signal (mandatory --pin)" << endl;
     cout << "    - pwmclearinvert: clear the inversion of the signal (mandatory --pin)" << endl;
+    cout << "    - pwmstream: plays a wavetable through the pwm duty fifo (mandatory --pin, optional --rate, --wave, --freq, --duration)" << endl;
     cout << "options:" << endl;
     cout << "    --pin=<number> : give the pin you want to perform the actions" << endl;
-    cout << "    --pad=<padvalue> : gives the hw configuration for specicif pin" << endl;
+    cout << "    --pad=<padvalue> : gives the hw configuration for specicif pin (PAD register: bit0 slewfast, 1 schmitt, 2 pulldown, 3 pullup, 4-5 drive, 6 input enable, 7 output disable)" << endl;
     cout << "    --func=<a-value> : is the a value (0-8) you can give" << endl;
     cout << "    --width=time   : set the width time in us." << endl;
     cout << "    --leadtime=time : is the time that the level is initial set before the pulse is generated" << endl;
     cout << "    --posttime=time : is the time that the level is kept after the pulse is generated" << endl;
     cout << "    --periods=periods : is the number of periods that are generated" << endl;
+    cout << "    --pattern=v:ns,v:ns,... : waveform steps, level 0/1 and the time it is held in ns" << endl;
+    cout << "    --repeat=count : number of times the waveform pattern is played" << endl;
+    cout << "    --pins=p1,p2,... : bank 0 pins that are captured or streamed; for port the pins in bit order" << endl;
+    cout << "    --pre=samples / --post=samples : capture depth before and from the trigger (default 1000 / 10000)" << endl;
+    cout << "    --trigger=cond : none, rising:<pin>, falling:<pin>, edge:<pin> or pattern:<mask>:<value>" << endl;
+    cout << "    --timeout=ms : maximum wait for the capture trigger (default 5000) or for the edges (default 1000)" << endl;
+    cout << "    --count=n : number of edges that are printed (default 100)" << endl;
+    cout << "    --vcd=file : write the capture as value change dump (PulseView, GTKWave)" << endl;
+    cout << "    --file=path : stream file (stream, streamread) or pin profile (loadprofile)" << endl;
+    cout << "    --duration=s : stream duration in seconds (default 10), fastclk and pwmstream run time in seconds (default 1)" << endl;
+    cout << "    --block=records : changes per stream block (default 65536)" << endl;
+    cout << "    --flush=ms : a partly filled stream block is written after this time (default 100)" << endl;
+    cout << "    --from=ms / --to=ms : time range read from a stream file" << endl;
+    cout << "    --value=n : port value, bit i goes to the i-th pin of --pins (decimal or 0x...)" << endl;
+    cout << "    --proto=name : uart, spi, i2c or onewire" << endl;
+    cout << "    --pins for decode : uart rx | spi sck,mosi[,miso[,cs]] | i2c scl,sda | onewire dq ('-' skips a pin)" << endl;
+    cout << "    --baud=rate / --bits=n / --parity=n|e|o : uart settings (default 115200 8N1); --bits is also the spi word size" << endl;
+    cout << "    --mode=0..3 : spi mode (cpol << 1 | cpha, default 0)" << endl;
+    cout << "    --rtcpu=cpu : cpu for the real-time section (default: first isolated cpu, else the last one)" << endl;
+    cout << "    --rtprio=prio : SCHED_FIFO priority of the real-time section (1-99, default 80)" << endl;
     cout << "    --div=divider : this gives the divider value for the pwm clock" << endl;
     cout << "    --frac=fraction : this give the fraction for the pwm clock" << endl;
-    cout << "    --freq=freq : this gives the frequency of the signal" << endl;
+    cout << "    --freq=freq : this gives the frequency of the signal (pwm and fastclk, Hz)" << endl;
     cout << "    --range=range: is the period range of the pwm signal" << endl;
-    cout << "    --duty=duty : is the duty in precent that the pwm signal should take" << endl;
-    cout << "    --phase=phase : is the phase that the pwm signal should take" << endl;
+    cout << "    --duty=duty : is the duty in precent that the pwm signal (or fastclk) should take" << endl;
+    cout << "    --set=pin:range:duty[:phase],... : pwmcommit channel values, phase defaults to 0" << endl;
+    cout << "    --steps=n : pwmsetfreq minimum duty resolution, range + 1 (default 100)" << endl;
+    cout << "    --phase=phase : is the phase that the pwm signal should take; for fastclk degrees per pin (0,90,...)" << endl;
     cout << "    --pwmmode=mode : set the mode of the pwm (zero, trailing, edging, phasecorrect, pde, ppm, msb, lsb)" << endl;
+    cout << "    --rate=Hz : pwmstream sample rate, one duty word per pwm period (default 48000)" << endl;
+    cout << "    --wave=name : pwmstream wavetable, sine or ramp (default sine); --freq is the tone (default 440)" << endl;
     cout << "    --base=baseNr: pwm of the rp1 contains two different pwm channels pwm0 (0) and pwm1 (1)" << endl;
+    cout << "    --backend=name : RP1 register backend (auto, devmem, gpiomem, sim), given when starting the application" << endl;
     cout << "flags:" << endl;
     cout << "     -positive : positive pulse/edge" << endl;
     cout << "     -negative : negative pulse/edge" << endl;
     cout << "     -listen : goto input mode after pulse" << endl;
     cout << "     -registry: use the Rp1 registers" << endl;
+    cout << "     -rt : run the timing critical part on a pinned SCHED_FIFO thread with locked memory" << endl;
+    cout << "     -insync : capture and stream sample RIO_INSYNC instead of RIO_IN" << endl;
+    cout << "     -on / -off : switch rtmode on or off" << endl;
+    cout << "     -lsb : spi words are sent LSB first" << endl;
+    cout << "     -rio : readdht11 polls RIO_INSYNC for the sensor edges instead of waiting for kernel gpio events," << endl;
+    cout << "            measrc waits on RIO_INSYNC (spin, then back-off) instead of 1 ms ioctl polls" << endl;
+    cout << "     -check : loadprofile validates and plans the profile without writing" << endl;
+    cout << "     -diff : gpiodump only shows what changed since the previous gpiodump" << endl;
     cout << endl;
     cout << "**********************************************************************************************" << endl;
     cout << "  copyright @ 2025 - MOW Vlaanderen" << endl;
@@ -315,10 +433,12 @@ bool cmdPwmGetRegisters(const std::unordered_map<std::string, std::string>& opti
 			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the pin option"));
 			return false;
 		}
+        int pin = std::stoi(itPin->second);
+        // a pin's own block unless --base looks at the same channel of the other one
+        base = std::max(PwmRegisters->getPwmBlock(pin), 0);
         if (bHasBase)
             base = std::stoi(itBase->second);
 
-        int pin = std::stoi(itPin->second);
         uint32_t control = PwmRegisters->getPWMReg_cntrl(pin, base);
         uint32_t range = PwmRegisters->getPWMReg_range(pin, base);
         uint32_t phase = PwmRegisters->getPWMReg_phase(pin, base);
@@ -345,15 +465,20 @@ bool cmdPwmGetClockRegisters(const std::unordered_map<std::string, std::string>&
         if (PwmRegisters == nullptr)
             PwmRegisters = std::make_unique<SB::RPI5::RP1PWM>(tracer);
 
-        uint32_t control = PwmRegisters->getPwmClockReg_cntrl();
-        uint32_t divFrac = PwmRegisters->getPwmClockReg_divFrac();
-        uint32_t divInt = PwmRegisters->getPwmClockReg_divInt();
-        uint32_t sel = PwmRegisters->getPwmClockReg_Sel();
+        int base = 0;
+        auto itBase = options.find("base");
+        if (itBase != options.end())
+            base = std::stoi(itBase->second);
+
+        uint32_t control = PwmRegisters->getPwmClockReg_cntrl(base);
+        uint32_t divFrac = PwmRegisters->getPwmClockReg_divFrac(base);
+        uint32_t divInt = PwmRegisters->getPwmClockReg_divInt(base);
+        uint32_t sel = PwmRegisters->getPwmClockReg_Sel(base);
     
-        logRegister(control,    std::format("PWM{0} control", 0));
-        logRegister(sel,        std::format("PWM{0} sel    ", 0));
-        logRegister(divFrac,    std::format("PWM{0} divFrac", 0));
-        logRegister(divInt,     std::format("PWM{0} divInt ", 0));
+        logRegister(control,    std::format("PWM{0} control", base));
+        logRegister(sel,        std::format("PWM{0} sel    ", base));
+        logRegister(divFrac,    std::format("PWM{0} divFrac", base));
+        logRegister(divInt,     std::format("PWM{0} divInt ", base));
         return true;
     }
     catch(const std::exception& e)
@@ -395,11 +520,29 @@ bool cmdPwmSetFrequency(const std::unordered_map<std::string, std::string>&optio
 		}
 
         int pin = std::stoi(itPin->second);
-        int freq = std::stoi(itFreq->second);
-        int duty = std::stoi(itDuty->second);
+        double freq = std::stod(itFreq->second);
+        double duty = std::stod(itDuty->second);
+        auto itSteps = options.find("steps");
+        uint32_t steps = (itSteps != options.end()) ? std::stoul(itSteps->second) : SB::RPI5::RP1PWM::DEFAULT_DUTY_STEPS;
+        if (!(freq > 0.0))
+        {
+            errors.emplace_back(std::format("SYNTAX-ERROR : --freq must be above 0"));
+            return false;
+        }
 
-        bool bok = PwmRegisters->setFrequencyDuty(pin, freq, duty);
-        return bok;
+        SB::RPI5::RP1PwmClockSolution_t achieved;
+        bool bok = PwmRegisters->setFrequencyDuty(pin, freq, duty, steps, achieved);
+        if (!bok)
+        {
+            errors.emplace_back(std::format("no clock setting gives {} Hz with {} duty steps", freq, steps));
+            return false;
+        }
+        cout << std::format("GPIO{}: {:.3f} Hz asked, {:.6f} Hz read back ({:+.3f} ppm){}", pin, freq, achieved.frequency,
+                            achieved.errorPpm, achieved.cached ? ", cached" : "") << endl;
+        cout << std::format("  aux source {} ({} Hz) / {:.5f} (int {}, frac {}/65536), range {} ({} steps)", achieved.auxSrc,
+                            achieved.sourceHz, achieved.divInt + achieved.divFrac / 65536.0, achieved.divInt, achieved.divFrac,
+                            achieved.range, static_cast<uint64_t>(achieved.range) + 1) << endl;
+        return true;
     }
     catch(const std::exception& e)
     {
@@ -462,6 +605,53 @@ bool cmdPwmSetRange(const std::unordered_map<std::string, std::string>& options,
     return false;
     
 }
+bool cmdPwmCommit(const std::unordered_map<std::string, std::string>& options, std::vector<std::string>& errors)
+{
+    CFuncTracer trace("cmdPwmCommit", tracer);
+    try
+    {
+        if (PwmRegisters == nullptr)
+            PwmRegisters = std::make_unique<SB::RPI5::RP1PWM>(tracer);
+
+        auto itSet = options.find("set");
+        if (itSet == options.end())
+        {
+            errors.emplace_back(std::format("SYNTAX-ERROR : should contain the set option"));
+            return false;
+        }
+
+        SB::RPI5::RP1PwmTransaction tx(*PwmRegisters);
+        for (const auto& entry : string_ext::split(itSet->second, ','))
+        {
+            auto fields = string_ext::split(entry, ':');
+            if ((fields.size() < 3) || (fields.size() > 4))
+            {
+                errors.emplace_back(std::format("SYNTAX-ERROR : '{}' should be pin:range:duty[:phase]", entry));
+                return false;
+            }
+            uint32_t pin = std::stoul(fields[0]);
+            int block = PwmRegisters->getPwmBlock(pin);
+            int channel = PwmRegisters->getPwmIndex(pin);
+            uint32_t phase = (fields.size() == 4) ? std::stoul(fields[3]) : 0;
+            if ((channel < 0) || !tx.set(block, channel, std::stoul(fields[1]), std::stoul(fields[2]), phase))
+            {
+                errors.emplace_back(std::format("GPIO{} has no PWM channel or PWM is not mapped", pin));
+                return false;
+            }
+        }
+
+        uint64_t start = SB::RPI5::SBDelay::nowNs();
+        uint32_t writes = tx.commit();
+        uint64_t end = SB::RPI5::SBDelay::nowNs();
+        cout << std::format("{} register writes, one update, {} ns", writes, end - start) << endl;
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+        trace.Error("Exception occurred : %s", e.what());
+    }
+    return false;
+}
 bool cmdPwmEnable(const std::unordered_map<std::string, std::string>&options, std::vector<std::string>& errors)
 {
     CFuncTracer trace("cmdPwmEnable", tracer);
@@ -623,14 +813,84 @@ bool cmdPwmClearInvert(const std::unordered_map<std::string, std::string>& optio
     return false;
 }
 
-bool cmdFastClock(const std::unordered_map<std::string, std::string>& options, std::vector<std::string>& errors)
+// Runs fn directly, or in real-time mode (-rt flag or rtmode -on): own thread
+// pinned to a cpu, SCHED_FIFO, memory locked, tracer quiet. What could not be
+// granted is printed and the command runs without it.
+bool RunCritical(const std::unordered_map<std::string, std::string>& options, const std::unordered_set<std::string>& flags,
+                 const std::function<bool()>& fn)
+{
+    CFuncTracer trace("RunCritical", tracer);
+    bool bRealtime = RealtimeAll || (flags.find("rt") != flags.end());
+    if (!bRealtime)
+        return fn();
+
+    SB::RPI5::SBRealtimeConfig_t config = RealtimeConfig;
+    auto itCpu = options.find("rtcpu");
+    auto itPrio = options.find("rtprio");
+    if (itCpu != options.end()) config.cpu = std::stoi(itCpu->second);
+    if (itPrio != options.end()) config.priority = std::stoi(itPrio->second);
+    std::string error;
+    if (!SB::RPI5::SBRealtime::validate(config, error))
+    {
+        cerr << FRed << "ERROR - " << error << FWhite << endl;
+        return false;
+    }
+
+    SB::RPI5::SBRealtime rt(tracer);
+    SB::RPI5::SBRealtimeReport_t report;
+    bool bok = rt.run(config, fn, report);
+    cout << SB::RPI5::SBRealtime::formatReport(report);
+    return bok;
+}
+
+bool cmdRtMode(const std::unordered_map<std::string, std::string>& options, std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
+{
+    CFuncTracer trace("cmdRtMode", tracer);
+    try
+    {
+        auto itCpu = options.find("rtcpu");
+        auto itPrio = options.find("rtprio");
+        // Parse into a copy: a rejected value leaves the current settings alone
+        SB::RPI5::SBRealtimeConfig_t config = RealtimeConfig;
+        if (itCpu != options.end()) config.cpu = std::stoi(itCpu->second);
+        if (itPrio != options.end()) config.priority = std::stoi(itPrio->second);
+        std::string error;
+        if (!SB::RPI5::SBRealtime::validate(config, error))
+        {
+            errors.emplace_back("SYNTAX-ERROR : " + error);
+            return false;
+        }
+        RealtimeConfig = config;
+        if (flags.find("on") != flags.end()) RealtimeAll = true;
+        if (flags.find("off") != flags.end()) RealtimeAll = false;
+
+        int isolated = SB::RPI5::SBRealtime::isolatedCpu();
+        cout << "rtmode    : " << (RealtimeAll ? "on (all timing commands)" : "off (per command with -rt)") << endl;
+        cout << "cpu       : " << ((RealtimeConfig.cpu < 0) ? std::string("auto") : std::to_string(RealtimeConfig.cpu))
+             << ", isolated cpu : " << ((isolated < 0) ? std::string("none") : std::to_string(isolated)) << endl;
+        cout << "priority  : SCHED_FIFO " << RealtimeConfig.priority << endl;
+        trace.Info("rtmode %d, cpu %d, prio %d", RealtimeAll, RealtimeConfig.cpu, RealtimeConfig.priority);
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdRtMode: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
+
+bool cmdFastClock(const std::unordered_map<std::string, std::string>& options, std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
 {
     CFuncTracer trace("cmdFastClock", tracer);
     try
     {
         auto itPin = options.find("pin");
+        auto itPins = options.find("pins");
         auto itPeriods = options.find("periods");
-        bool bHasPin = (itPin != options.end());
+        auto itFreq = options.find("freq");
+        bool bHasPin = (itPin != options.end()) || ((itFreq != options.end()) && (itPins != options.end()));
         bool bHasPeriods = (itPeriods != options.end());
 
 		if (!bHasPin)
@@ -639,18 +899,61 @@ bool cmdFastClock(const std::unordered_map<std::string, std::string>& options, s
 			return false;
 		}
 
-        if (!bHasPeriods)
+        if (!bHasPeriods && (itFreq == options.end()))
         {
-			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the periods option"));
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the periods or the freq option"));
 			return false;
         }
 
         if (GpioRegisters == nullptr)
             GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
 
+        if (itFreq != options.end())
+        {
+            // Timer paced clock on one or more pins, each with its own phase
+            auto itDuty = options.find("duty");
+            auto itPhase = options.find("phase");
+            auto itDuration = options.find("duration");
+            SB::RPI5::RP1ClockConfig_t config = {};
+            config.frequencyHz = std::stod(itFreq->second);
+            config.duty = ((itDuty != options.end()) ? std::stod(itDuty->second) : 50.0) / 100.0;
+            config.durationNs = static_cast<uint64_t>(((itDuration != options.end()) ? std::stod(itDuration->second) : 1.0) * 1e9);
+            std::vector<std::string> phases;
+            if (itPhase != options.end())
+                phases = string_ext::split(itPhase->second, ',');
+            size_t idx = 0;
+            for (const auto& pin : string_ext::split((itPins != options.end()) ? itPins->second : itPin->second, ','))
+            {
+                double phase = (idx < phases.size()) ? std::stod(phases[idx]) : 0.0;
+                config.pins.push_back({ static_cast<uint32_t>(std::stoul(pin)), phase });
+                ++idx;
+            }
+
+            SB::RPI5::RP1Clock clock(tracer);
+            if (!clock.prepare(config))
+            {
+                errors.emplace_back("RUNTIME ERROR - invalid clock settings");
+                return false;
+            }
+            SB::RPI5::RP1IO::Fast io = GpioRegisters->fast(clock.mask());
+            if (!io.valid())
+            {
+                errors.emplace_back(std::format("RUNTIME ERROR - cannot drive pins 0x{:08x}", clock.mask()));
+                return false;
+            }
+            io.output(clock.mask());
+            if (!RunCritical(options, flags, [&]() { return clock.run(io); }))
+            {
+                errors.emplace_back(std::format("RUNTIME ERROR - FastClock failed"));
+                return false;
+            }
+            cout << clock.formatStats();
+            return true;
+        }
+
         int pin = std::stoi(itPin->second);
         int period = std::stoi(itPeriods->second);
-        bool bok = GpioRegisters->FastClock(pin, period);
+        bool bok = RunCritical(options, flags, [&]() { return GpioRegisters->FastClock(pin, period); });
         if (!bok)
         {
             errors.emplace_back(std::format("RUNTIME ERROR - FastClock failed"));
@@ -877,7 +1180,28 @@ bool cmdGetRioInSync(const std::unordered_map<std::string, std::string>& options
     return false;    
 }
 
-bool cmdReadDHT11(const std::unordered_map<std::string,std::string>& options, std::vector<std::string>& errors)
+// Edge detector on its own pinned thread, --rtcpu / --rtprio override rtmode
+std::shared_ptr<SB::RPI5::RP1EdgeDetector> StartEdgeDetector(const std::unordered_map<std::string, std::string>& options, uint32_t mask)
+{
+    SB::RPI5::RP1EdgeDetectorConfig_t config = {};
+    config.mask = mask;
+    config.queueEdges = 65536;
+    config.realtime = RealtimeConfig;
+    auto itCpu = options.find("rtcpu");
+    auto itPrio = options.find("rtprio");
+    if (itCpu != options.end()) config.realtime.cpu = std::stoi(itCpu->second);
+    if (itPrio != options.end()) config.realtime.priority = std::stoi(itPrio->second);
+
+    if (GpioRegisters == nullptr)
+        GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
+    SB::RPI5::RP1IO::Fast io = GpioRegisters->fast(mask);
+    auto edges = std::make_shared<SB::RPI5::RP1EdgeDetector>(tracer);
+    if (!io.valid() || !edges->start(config, io))
+        return nullptr;
+    return edges;
+}
+
+bool cmdReadDHT11(const std::unordered_map<std::string,std::string>& options, std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
 {
     CFuncTracer trace("cmdReadDHT11", tracer);
     try
@@ -893,9 +1217,31 @@ bool cmdReadDHT11(const std::unordered_map<std::string,std::string>& options, st
 			return false;
 		}
 		int pin = std::stoi(it->second);
+        if ((pin < 0) || (pin >= static_cast<int>(SB::RPI5::RP1_BANK_PINS[0])))
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : pin '{}' should be 0..{}", it->second, SB::RPI5::RP1_BANK_PINS[0] - 1));
+			return false;
+        }
         SB::RPI5::Sensors::CDhct11 sensor(tracer, pin);
 
-        bool bok = sensor.Read(temperature, humidity, errors);
+        // The edge detector is the real-time part with -rio, reading the
+        // queue needs no pinned thread of its own
+        bool bok = false;
+        if (flags.find("rio") != flags.end())
+        {
+            auto edges = StartEdgeDetector(options, 1u << pin);
+            if (edges == nullptr)
+            {
+                errors.emplace_back(std::format("RUNTIME ERROR - cannot watch GPIO{} on RIO", pin));
+                return false;
+            }
+            sensor.UseEdgeDetector(edges);
+            bok = sensor.Read(temperature, humidity, errors);
+            edges->stop();
+            trace.Info("%s", SB::RPI5::RP1EdgeDetector::formatStats(edges->stats()).c_str());
+        }
+        else
+            bok = RunCritical(options, flags, [&]() { return sensor.Read(temperature, humidity, errors); });
         if (!bok)
         {
             errors.emplace_back("Read DHCT11 chip data failed");
@@ -1111,7 +1457,9 @@ bool cmdSetPulse(const std::unordered_map<std::string, std::string>& options, st
                 ioPin.ReleasePin(pinNr, errors);
             pinNr = pin;
 
-            bok = ioPin.SetPulse(pinNr, width, leadTime, postTime, (bPositive)? SB::RPI5::PulseType::ePositive: SB::RPI5::PulseType::eNegative, bListen, errors);
+            bok = RunCritical(options, flags, [&]() {
+                return ioPin.SetPulse(pinNr, width, leadTime, postTime, (bPositive)? SB::RPI5::PulseType::ePositive: SB::RPI5::PulseType::eNegative, bListen, errors);
+            });
             if (!bok)
                 errors.emplace_back(std::format("RUNTIME-ERROR : could not generate pulse on pin {0}", pin));
         }
@@ -1119,7 +1467,9 @@ bool cmdSetPulse(const std::unordered_map<std::string, std::string>& options, st
         {
             if (GpioRegisters == nullptr)
                 GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
-            bok = GpioRegisters->SetPulse(pin, width, leadTime, postTime, (bPositive)? SB::RPI5::eRp1IoPulseType::ePositive : SB::RPI5::eRp1IoPulseType::eNegative, bListen);
+            bok = RunCritical(options, flags, [&]() {
+                return GpioRegisters->SetPulse(pin, width, leadTime, postTime, (bPositive)? SB::RPI5::eRp1IoPulseType::ePositive : SB::RPI5::eRp1IoPulseType::eNegative, bListen);
+            });
             if (!bok)
                 errors.emplace_back(std::format("RUNTIME-ERROR : Could not generate pulse on pin {0}", pin));
         }
@@ -1180,95 +1530,777 @@ bool cmdPinSetFunction(const std::unordered_map<std::string, std::string>& optio
 
 
 
-bool cmdMeasRC(const std::unordered_map<std::string, std::string>& options,
-               std::vector<std::string>& errors)
+bool cmdGpioDump([[maybe_unused]] const std::unordered_map<std::string, std::string>& options, std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
 {
-	CFuncTracer trace("cmdSetPinLow", tracer);
+    CFuncTracer trace("cmdGpioDump", tracer);
     try
     {
-		auto it = options.find("pin");
-		bool bHasPin = (it != options.end());
-		if (!bHasPin)
-		{
-			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the pin option"));
-			return false;
-		}
-		int pin = std::stoi(it->second);
-        if (pinNr != -1)
-            ioPin.ReleasePin(pinNr, errors);
-		pinNr = pin;
-        int time = ioPin.MeasRC(pinNr, errors);
-		if (time < 0)
+        bool bDiff = (flags.find("diff") != flags.end());
+
+        if (GpioRegisters == nullptr)
+            GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
+
+        auto snap = std::make_unique<SB::RPI5::RP1Snapshot_t>();
+        if (!GpioRegisters->snapshot(*snap))
         {
-			errors.emplace_back(std::format("RUNTIME-ERROR : could not measRC at pin {0} high", pin));
+            errors.emplace_back("RUNTIME_ERROR : could not capture the GPIO banks");
             return false;
         }
 
-        cout << "RC time : " << time << " ms." << endl;
-        trace.Info("time = %ld ms", time);
+        if (bDiff && (LastSnapshot != nullptr))
+        {
+            auto changes = SB::RPI5::RP1Snapshot::diff(*LastSnapshot, *snap);
+            cout << SB::RPI5::RP1Snapshot::formatDiff(changes);
+            cout << std::format("captured {} pins in {:.2f} us", SB::RPI5::RP1_PIN_COUNT, snap->durationNs / 1000.0) << endl;
+        }
+        else
+        {
+            if (bDiff)
+                cout << "no previous gpiodump, showing the full table" << endl;
+            cout << SB::RPI5::RP1Snapshot::formatTable(*snap);
+        }
+        LastSnapshot = std::move(snap);
         return true;
     }
-    catch (const std::exception& ex)
+    catch(const std::exception& e)
     {
 		cerr << FRed;
-        cerr << "ERROR - exception in cmdSetPinHigh: " << ex.what() << endl;
+        cerr << "ERROR - exception in cmdGpioDump: " << e.what() << endl;
 		cerr << FWhite;
     }
     return false;
 }
 
-bool cmdEnumChips(std::vector<std::string> errors)
+bool cmdWaveform(const std::unordered_map<std::string, std::string>& options, std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
 {
-	CFuncTracer trace("cmdEnumChips", tracer);
-	try
-	{
-		SB::RPI5::SBPio pio(tracer);
+    CFuncTracer trace("cmdWaveform", tracer);
+    try
+    {
+        auto itPin = options.find("pin");
+        auto itPattern = options.find("pattern");
+        auto itRepeat = options.find("repeat");
+        if ((itPin == options.end()) || (itPattern == options.end()))
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the pin and pattern option"));
+			return false;
+        }
+        uint32_t mask = 0;
+        if (!ParsePinMask(itPin->second, mask, errors))
+            return false;
+        const std::string& pin = itPin->second;
+        uint32_t repeat = (itRepeat != options.end()) ? static_cast<uint32_t>(std::stoul(itRepeat->second)) : 1;
 
-        auto chips = pio.enumChips(errors);
-        for(auto chip : chips)
-            cout << "chip: " << chip.name << ", label: " << chip.label << ", lines: " << chip.lines << endl;
-        LogErrors(errors);
+        std::vector<SB::RPI5::RP1WaveStep_t> steps;
+        if (!SB::RPI5::RP1Waveform::parse(itPattern->second, mask, steps))
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : pattern should be v:ns,v:ns,... with ns < 2^32 ({})", itPattern->second));
+			return false;
+        }
+
+        // Everything is checked and compiled before the pin becomes an output
+        SB::RPI5::RP1Waveform wave(tracer);
+        for (const auto& step : steps)
+            wave.add(step);
+        if (!wave.compile(repeat))
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - cannot compile the waveform for pin {}", pin));
+            return false;
+        }
+
+        if (GpioRegisters == nullptr)
+            GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
+        GpioRegisters->setDirOutMask(mask);
+        SB::RPI5::RP1IO::Fast io = GpioRegisters->fast(mask);
+        if (!RunCritical(options, flags, [&]() { return wave.run(io); }))
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - waveform on pin {} failed", pin));
+            return false;
+        }
+        cout << wave.formatReport();
         return true;
-	}
-	catch(const std::exception& e)
-	{
-		trace.Error("Exception occurred : %s", e.what());
-	}
-	return false;
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdWaveform: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
 }
 
-bool Shell()
+bool cmdCapture(const std::unordered_map<std::string, std::string>& options, std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
 {
-    bool bStop = false;
-    char cCmdLine[1024] = {0};
-
+    CFuncTracer trace("cmdCapture", tracer);
     try
     {
-          using_history();
+        auto itPins = options.find("pins");
+        if (itPins == options.end())
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the pins option"));
+			return false;
+        }
+        SB::RPI5::RP1CaptureConfig_t config = {};
+        if (!ParsePinMask(itPins->second, config.mask, errors))
+            return false;
 
-        // Make sure arrow keys work even if terminfo/keymaps are missing
-        rl_bind_keyseq("\\e[A", rl_get_previous_history); // Up
-        rl_bind_keyseq("\\e[B", rl_get_next_history);     // Down
-        rl_bind_keyseq("\\e[C", rl_forward_char);         // Right (optional)
-        rl_bind_keyseq("\\e[D", rl_backward_char);        // Left  (optional)
+        auto itPre = options.find("pre");
+        auto itPost = options.find("post");
+        auto itTrigger = options.find("trigger");
+        auto itTimeout = options.find("timeout");
+        auto itVcd = options.find("vcd");
+        config.preSamples = (itPre != options.end()) ? std::stoul(itPre->second) : 1000;
+        config.postSamples = (itPost != options.end()) ? std::stoul(itPost->second) : 10000;
+        config.timeoutNs = ((itTimeout != options.end()) ? std::stoull(itTimeout->second) : 5000) * 1000000ull;
+        config.useInSync = (flags.find("insync") != flags.end());
+        if ((itTrigger != options.end()) && !SB::RPI5::RP1Capture::parseTrigger(itTrigger->second, config.trigger))
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : unknown trigger {}", itTrigger->second));
+			return false;
+        }
 
-        std::vector<std::string> errors;
+        if (GpioRegisters == nullptr)
+            GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
+        SB::RPI5::RP1IO::Fast io = GpioRegisters->fast(config.mask);
+        SB::RPI5::RP1Capture capture(tracer);
+        if (!io.valid() || !capture.prepare(config))
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - cannot capture pins 0x{:08x}", config.mask));
+            return false;
+        }
+        if (!RunCritical(options, flags, [&]() { return capture.run(io); }))
+        {
+            errors.emplace_back("RUNTIME ERROR - capture not triggered (timeout)");
+            return false;
+        }
+        cout << capture.formatStats();
 
+        if (itVcd != options.end())
+        {
+            if (!capture.writeVcd(itVcd->second))
+            {
+                errors.emplace_back(std::format("RUNTIME ERROR - could not write {}", itVcd->second));
+                return false;
+            }
+            cout << "written to " << itVcd->second << endl;
+        }
+        else
+        {
+            // Without a file: the first transitions around the trigger
+            uint32_t last = capture.value(0);
+            int shown = 0;
+            cout << std::format("{:>12} 0x{:08x}", capture.offsetNs(0), last & config.mask) << endl;
+            for (size_t i = 1; (i < capture.size()) && (shown < 20); ++i)
+            {
+                uint32_t v = capture.value(i) & config.mask;
+                if (v != last)
+                {
+                    cout << std::format("{:>12} 0x{:08x}", capture.offsetNs(i), v) << endl;
+                    last = v;
+                    ++shown;
+                }
+            }
+        }
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdCapture: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
 
-        do
+bool cmdStream(const std::unordered_map<std::string, std::string>& options, std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
+{
+    CFuncTracer trace("cmdStream", tracer);
+    try
+    {
+        auto itPins = options.find("pins");
+        auto itFile = options.find("file");
+        if ((itPins == options.end()) || (itFile == options.end()))
         {
-            std::cout << std::endl;
-            char* line = readline("Command : ");
-            if (!line)
-                break;
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the pins and file option"));
+			return false;
+        }
+        SB::RPI5::RP1StreamConfig_t config = {};
+        if (!ParsePinMask(itPins->second, config.mask, errors))
+            return false;
+        config.path = itFile->second;
+
+        auto itDuration = options.find("duration");
+        auto itBlock = options.find("block");
+        auto itFlush = options.find("flush");
+        auto itCpu = options.find("rtcpu");
+        auto itPrio = options.find("rtprio");
+        uint64_t durationSec = (itDuration != options.end()) ? std::stoull(itDuration->second) : 10;
+        config.blockRecords = (itBlock != options.end()) ? std::stoul(itBlock->second) : 65536;
+        config.flushNs = ((itFlush != options.end()) ? std::stoull(itFlush->second) : 100) * 1000000ull;
+        config.useInSync = (flags.find("insync") != flags.end());
+        config.realtime = RealtimeConfig;
+        if (itCpu != options.end()) config.realtime.cpu = std::stoi(itCpu->second);
+        if (itPrio != options.end()) config.realtime.priority = std::stoi(itPrio->second);
 
-            std::string sCmdLine(line);
-            free(line);
-            if (sCmdLine.empty())
-                continue;
+        if (GpioRegisters == nullptr)
+            GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
+        SB::RPI5::RP1IO::Fast io = GpioRegisters->fast(config.mask);
+        SB::RPI5::RP1Stream stream(tracer);
+        if (!io.valid() || !stream.start(config, io))
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - cannot stream pins 0x{:08x} to {}", config.mask, config.path));
+            return false;
+        }
 
-            // Add the in-memory history (enables up/down navigation)
-            add_history(sCmdLine.c_str());
+        // Live counters once a second, rates over the last second
+        auto prev = stream.stats();
+        for (uint64_t sec = 0; (sec < durationSec) && !stream.failed(); ++sec)
+        {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            auto st = stream.stats();
+            double dt = (st.elapsedNs > prev.elapsedNs) ? (st.elapsedNs - prev.elapsedNs) / 1e9 : 1.0;
+            cout << std::format("{:>5} s {:>8.2f} MS/s {:>10.0f} changes/s {:>10} dropped {:>9.2f} MiB/s {:>10.2f} MiB",
+                                sec + 1, (st.polls - prev.polls) / dt / 1e6, (st.records - prev.records) / dt,
+                                st.droppedRecords, (st.bytesWritten - prev.bytesWritten) / dt / 1048576.0,
+                                st.bytesWritten / 1048576.0) << endl;
+            prev = st;
+        }
+        bool bok = stream.stop();
+        cout << SB::RPI5::SBRealtime::formatReport(stream.realtimeReport());
+        cout << SB::RPI5::RP1Stream::formatStats(stream.stats());
+        if (!bok)
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - writing {} failed", config.path));
+            return false;
+        }
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdStream: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
+
+bool cmdStreamRead(const std::unordered_map<std::string, std::string>& options, [[maybe_unused]] std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
+{
+    CFuncTracer trace("cmdStreamRead", tracer);
+    try
+    {
+        auto itFile = options.find("file");
+        if (itFile == options.end())
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the file option"));
+			return false;
+        }
+        SB::RPI5::RP1StreamReader reader(tracer);
+        if (!reader.open(itFile->second))
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - cannot read {}", itFile->second));
+            return false;
+        }
+        auto itFrom = options.find("from");
+        auto itTo = options.find("to");
+        uint64_t fromNs = ((itFrom != options.end()) ? std::stoull(itFrom->second) : 0) * 1000000ull;
+        uint64_t toNs = (itTo != options.end()) ? std::stoull(itTo->second) * 1000000ull : reader.durationNs() + 1;
+
+        const auto& header = reader.header();
+        cout << std::format("{} : pins 0x{:08x} ({}), {:.3f} s, {} blocks{}", itFile->second, header.mask,
+                            header.useInSync ? "InSync" : "In", reader.durationNs() / 1e9, reader.index().size(),
+                            reader.indexRebuilt() ? " (no index, rebuilt)" : "") << endl;
+
+        std::vector<SB::RPI5::RP1StreamRecord_t> records;
+        auto t0 = std::chrono::steady_clock::now();
+        if (!reader.read(fromNs, toNs, records))
+        {
+            errors.emplace_back("RUNTIME ERROR - stream file is corrupt");
+            return false;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        cout << std::format("{} changes between {} and {} ms (seek + decode {} us)", records.size(), fromNs / 1000000,
+                            toNs / 1000000, std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count()) << endl;
+        if (reader.dropped() > 0)
+            cout << FRed << std::format("{} changes were dropped while streaming this range", reader.dropped()) << FWhite << endl;
+        for (size_t i = 0; (i < records.size()) && (i < 50); ++i)
+            cout << std::format("{:>15} ns 0x{:08x} {:>10} polls", reader.toNs(records[i].ticks), records[i].state, records[i].polls) << endl;
+        if (records.size() > 50)
+            cout << "..." << endl;
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdStreamRead: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
+
+bool cmdDecode(const std::unordered_map<std::string, std::string>& options, std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
+{
+    CFuncTracer trace("cmdDecode", tracer);
+    try
+    {
+        auto itFile = options.find("file");
+        auto itProto = options.find("proto");
+        auto itPins = options.find("pins");
+        if ((itFile == options.end()) || (itProto == options.end()) || (itPins == options.end()))
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the file, proto and pins option"));
+			return false;
+        }
+        SB::RPI5::RP1DecodeConfig_t config;
+        if (!SB::RPI5::RP1Decode::parseProtocol(itProto->second, config))
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : unknown protocol {}", itProto->second));
+			return false;
+        }
+        size_t idx = 0;
+        for (const auto& pin : string_ext::split(itPins->second, ','))
+        {
+            if (idx < 4)
+                config.pins[idx++] = (pin == "-") ? SB::RPI5::RP1_DECODE_NOPIN : static_cast<uint32_t>(std::stoul(pin));
+        }
+        auto itBaud = options.find("baud");
+        auto itBits = options.find("bits");
+        auto itParity = options.find("parity");
+        auto itMode = options.find("mode");
+        if (itBaud != options.end()) config.baud = static_cast<uint32_t>(std::stoul(itBaud->second));
+        if (itBits != options.end()) config.dataBits = static_cast<uint32_t>(std::stoul(itBits->second));
+        if (itParity != options.end()) config.parity = itParity->second.empty() ? 'n' : itParity->second[0];
+        if (itMode != options.end()) config.spiMode = static_cast<uint32_t>(std::stoul(itMode->second));
+        config.lsbFirst = (flags.find("lsb") != flags.end());
+
+        SB::RPI5::RP1StreamReader reader(tracer);
+        if (!reader.open(itFile->second))
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - cannot read {}", itFile->second));
+            return false;
+        }
+        auto itFrom = options.find("from");
+        auto itTo = options.find("to");
+        uint64_t fromNs = ((itFrom != options.end()) ? std::stoull(itFrom->second) : 0) * 1000000ull;
+        uint64_t toNs = (itTo != options.end()) ? std::stoull(itTo->second) * 1000000ull : reader.durationNs() + 1;
+        std::vector<SB::RPI5::RP1StreamRecord_t> records;
+        if (!reader.read(fromNs, toNs, records))
+        {
+            errors.emplace_back("RUNTIME ERROR - stream file is corrupt");
+            return false;
+        }
+
+        // Only the changes on the protocol pins
+        const uint32_t mask = SB::RPI5::RP1Decode::pinMask(config);
+        std::vector<SB::RPI5::RP1Edge_t> edges;
+        edges.reserve(records.size());
+        for (const auto& r : records)
+        {
+            if (edges.empty() || ((edges.back().state ^ r.state) & mask))
+                edges.push_back({ reader.toNs(r.ticks), r.state & mask });
+        }
+
+        SB::RPI5::RP1Decode decoder(tracer);
+        std::vector<SB::RPI5::RP1Frame_t> frames;
+        auto t0 = std::chrono::steady_clock::now();
+        if (!decoder.decode(config, edges, std::min(toNs, reader.durationNs()), frames))
+        {
+            errors.emplace_back("RUNTIME ERROR - invalid decoder settings");
+            return false;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        size_t flagged = 0;
+        for (const auto& frame : frames)
+            if (frame.flags & (SB::RPI5::RP1_FRAME_FRAMING | SB::RPI5::RP1_FRAME_PARITY | SB::RPI5::RP1_FRAME_INCOMPLETE))
+                ++flagged;
+        cout << std::format("{} frames ({} with errors) from {} changes in {} us", frames.size(), flagged, edges.size(),
+                            std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count()) << endl;
+        for (size_t i = 0; (i < frames.size()) && (i < 100); ++i)
+            cout << SB::RPI5::RP1Decode::formatFrame(config, frames[i]) << endl;
+        if (frames.size() > 100)
+            cout << "..." << endl;
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdDecode: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
+
+bool cmdPort(const std::unordered_map<std::string, std::string>& options, [[maybe_unused]] std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
+{
+    CFuncTracer trace("cmdPort", tracer);
+    try
+    {
+        auto itPins = options.find("pins");
+        if (itPins == options.end())
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the pins option"));
+			return false;
+        }
+        std::vector<uint32_t> pins;
+        for (const auto& pin : string_ext::split(itPins->second, ','))
+            pins.push_back(static_cast<uint32_t>(std::stoul(pin)));
+
+        if (GpioRegisters == nullptr)
+            GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
+        SB::RPI5::RP1Port port = GpioRegisters->port(pins);
+        if (!port.valid())
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - {} is not a valid port", itPins->second));
+            return false;
+        }
+
+        // With --value the pins become outputs and get the value, without
+        // it the port is read
+        auto itValue = options.find("value");
+        if (itValue != options.end())
+        {
+            uint32_t value = static_cast<uint32_t>(std::stoul(itValue->second, nullptr, 0));
+            port.output();
+            port.write(value);
+            cout << std::format("port ({} pins, mask 0x{:08x}) <- 0x{:x}", port.width(), port.mask(), value) << endl;
+        }
+        else
+        {
+            uint32_t value = port.read();
+            std::string bits;
+            for (size_t i = port.width(); i > 0; --i)
+                bits += ((value >> (i - 1)) & 1u) ? '1' : '0';
+            cout << std::format("port ({} pins, mask 0x{:08x}) = 0x{:x} ({})", port.width(), port.mask(), value, bits) << endl;
+        }
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdPort: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
+
+bool cmdEdges(const std::unordered_map<std::string, std::string>& options, [[maybe_unused]] std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
+{
+    CFuncTracer trace("cmdEdges", tracer);
+    try
+    {
+        auto itPins = options.find("pins");
+        if (itPins == options.end())
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the pins option"));
+			return false;
+        }
+        uint32_t mask = 0;
+        if (!ParsePinMask(itPins->second, mask, errors))
+            return false;
+        auto itCount = options.find("count");
+        auto itTimeout = options.find("timeout");
+        int count = (itCount != options.end()) ? std::stoi(itCount->second) : 100;
+        int timeoutMs = (itTimeout != options.end()) ? std::stoi(itTimeout->second) : 1000;
+
+        auto edges = StartEdgeDetector(options, mask);
+        if (edges == nullptr)
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - cannot watch pins 0x{:08x}", mask));
+            return false;
+        }
+
+        // --timeout is the longest quiet time between two edges
+        std::vector<std::string> waitErrors;
+        SB::RPI5::RP1EdgeEvent_t edge = {};
+        uint64_t prevNs = 0;
+        int found = 0;
+        for (; found < count; ++found)
+        {
+            if (edges->WaitNextEdgeUs(timeoutMs * 1000, &edge, waitErrors) < 0)
+                break;
+            uint64_t ns = edges->toNs(edge.ticks);
+            cout << std::format("{:>12} ns  (+{:>10} ns)  GPIO{:<2} {}", ns, (found > 0) ? ns - prevNs : 0, edge.pin,
+                                edge.rising ? "rising" : "falling") << endl;
+            prevNs = ns;
+        }
+        edges->stop();
+        if (found < count)
+            cout << std::format("no edge within {} ms after {} edges", timeoutMs, found) << endl;
+        cout << SB::RPI5::RP1EdgeDetector::formatStats(edges->stats());
+        for (const auto& w : edges->realtimeReport().warnings)
+            cout << "  warning: " << w << endl;
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdEdges: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
+
+bool cmdLoadProfile(const std::unordered_map<std::string, std::string>& options, std::unordered_set<std::string>& flags, std::vector<std::string>& errors)
+{
+    CFuncTracer trace("cmdLoadProfile", tracer);
+    try
+    {
+        auto itFile = options.find("file");
+        if (itFile == options.end())
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the file option"));
+			return false;
+        }
+        bool bCheck = (flags.find("check") != flags.end());
+
+        auto t0 = std::chrono::steady_clock::now();
+        SB::RPI5::RP1PinProfile_t profile;
+        if (!SB::RPI5::RP1PinProfile::load(itFile->second, profile, errors))
+            return false;
+        auto parseNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+
+        if (GpioRegisters == nullptr)
+            GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
+        auto result = std::make_unique<SB::RPI5::RP1ProfileResult_t>();
+        if (!GpioRegisters->applyProfile(profile, *result, !bCheck, errors))
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - profile {} is not applied", profile.name));
+            return false;
+        }
+
+        if (bCheck)
+        {
+            cout << std::format("profile {} ({} pins) would change:", profile.name, profile.pins.size()) << endl;
+            cout << SB::RPI5::RP1Snapshot::formatDiff(SB::RPI5::RP1Snapshot::diff(result->before, result->target));
+            cout << std::format("parse {:.1f} us, validate + plan {:.1f} us", parseNs / 1000.0, result->planNs / 1000.0) << endl;
+            return true;
+        }
+
+        cout << std::format("profile {} ({} pins) changed:", profile.name, profile.pins.size()) << endl;
+        cout << SB::RPI5::RP1Snapshot::formatDiff(SB::RPI5::RP1Snapshot::diff(result->before, result->after));
+        cout << std::format("parse {:.1f} us, validate + plan {:.1f} us, apply {} register writes in {:.2f} us",
+                            parseNs / 1000.0, result->planNs / 1000.0, result->writes, result->writeNs / 1000.0) << endl;
+        if (!result->mismatches.empty())
+        {
+            cout << FRed << "registers that do not hold the profile:" << endl;
+            cout << SB::RPI5::RP1Snapshot::formatDiff(result->mismatches) << FWhite;
+        }
+        // The next gpiodump -diff compares against the state after the profile
+        LastSnapshot = std::make_unique<SB::RPI5::RP1Snapshot_t>(result->after);
+        return result->mismatches.empty();
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdLoadProfile: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
+
+bool cmdPwmStream(const std::unordered_map<std::string, std::string>& options, std::vector<std::string>& errors)
+{
+    CFuncTracer trace("cmdPwmStream", tracer);
+    try
+    {
+        auto itPin = options.find("pin");
+        if (itPin == options.end())
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the pin option"));
+			return false;
+        }
+        auto itRate = options.find("rate");
+        auto itWave = options.find("wave");
+        auto itFreq = options.find("freq");
+        auto itDuration = options.find("duration");
+        auto itCpu = options.find("rtcpu");
+        auto itPrio = options.find("rtprio");
+        SB::RPI5::RP1PwmStreamConfig_t config = {};
+        config.pin = std::stoul(itPin->second);
+        config.sampleRate = (itRate != options.end()) ? std::stoul(itRate->second) : 48000;
+        config.queueSamples = 8192;
+        config.threshold = SB::RPI5::PwmFifoCtrl::DEPTH / 2;
+        config.realtime = RealtimeConfig;
+        if (itCpu != options.end()) config.realtime.cpu = std::stoi(itCpu->second);
+        if (itPrio != options.end()) config.realtime.priority = std::stoi(itPrio->second);
+        double freq = (itFreq != options.end()) ? std::stod(itFreq->second) : 440.0;
+        double seconds = (itDuration != options.end()) ? std::stod(itDuration->second) : 1.0;
+        std::string wave = (itWave != options.end()) ? itWave->second : "sine";
+        if ((wave != "sine") && (wave != "ramp"))
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : unknown wave {0} (sine, ramp)", wave));
+			return false;
+        }
+        if ((freq <= 0.0) || (freq * 2.0 >= config.sampleRate))
+        {
+			errors.emplace_back(std::format("SYNTAX-ERROR : --freq must be between 0 and half the sample rate ({0} Hz)", config.sampleRate));
+			return false;
+        }
+
+        if (PwmRegisters == nullptr)
+            PwmRegisters = std::make_unique<SB::RPI5::RP1PWM>(tracer);
+        SB::RPI5::RP1PwmStream stream(tracer);
+        if (!stream.start(config, *PwmRegisters))
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - cannot stream to GPIO{0}", config.pin));
+            return false;
+        }
+
+        // The producer renders a quarter of the queue at a time and sleeps
+        // while the queue is fuller than that
+        const auto& table = (wave == "sine") ? SB::RPI5::RP1_SINE_Q16 : SB::RPI5::RP1_RAMP_Q16;
+        SB::RPI5::RP1WavetableOsc osc(table.data(), SB::RPI5::RP1_WAVETABLE_BITS, freq, config.sampleRate);
+        std::vector<uint32_t> chunk(config.queueSamples / 4);
+        const uint64_t total = static_cast<uint64_t>(seconds * config.sampleRate);
+        const uint64_t chunkNs = chunk.size() * 1000000000ull / config.sampleRate;
+        uint64_t produced = 0;
+        uint64_t progressNs = SB::RPI5::SBDelay::nowNs();
+        bool bStalled = false;
+        while (produced < total)
+        {
+            if (stream.space() < chunk.size())
+            {
+                // The PWM stopped taking words (e.g. the channel is not running)
+                if (SB::RPI5::SBDelay::nowNs() - progressNs > 1000000000ull)
+                {
+                    bStalled = true;
+                    break;
+                }
+                SB::RPI5::SBDelay::ns(chunkNs / 2);
+                continue;
+            }
+            size_t n = static_cast<size_t>(std::min<uint64_t>(chunk.size(), total - produced));
+            osc.render(chunk.data(), n, stream.range());
+            produced += stream.push(chunk.data(), n);
+            progressNs = SB::RPI5::SBDelay::nowNs();
+        }
+        bool bDrained = !bStalled && stream.drain(1000000000ull);
+        auto st = stream.stats();
+        stream.stop();
+
+        cout << std::format("GPIO{0}: {1} {2} Hz at {3} Hz, range {4}{5}", config.pin, wave, freq, config.sampleRate,
+                            stream.range(), bDrained ? "" : " (not drained)") << endl;
+        cout << SB::RPI5::RP1PwmStream::formatStats(st) << endl;
+        for (const auto& w : stream.realtimeReport().warnings)
+            cout << "  warning: " << w << endl;
+        if (bStalled)
+        {
+            errors.emplace_back(std::format("RUNTIME ERROR - the pwm did not take duty words for 1 s after {0} samples", st.samples));
+            return false;
+        }
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdPwmStream: " << e.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
+
+bool cmdMeasRC(const std::unordered_map<std::string, std::string>& options,
+               std::unordered_set<std::string>& flags,
+               std::vector<std::string>& errors)
+{
+	CFuncTracer trace("cmdSetPinLow", tracer);
+    try
+    {
+		auto it = options.find("pin");
+		bool bHasPin = (it != options.end());
+		if (!bHasPin)
+		{
+			errors.emplace_back(std::format("SYNTAX-ERROR : should contain the pin option"));
+			return false;
+		}
+		int pin = std::stoi(it->second);
+        if (pinNr != -1)
+            ioPin.ReleasePin(pinNr, errors);
+		pinNr = pin;
+        int time = -1;
+        if (flags.find("rio") != flags.end())
+        {
+            // Register wait on RIO_INSYNC instead of 1 ms ioctl polls
+            if (GpioRegisters == nullptr)
+                GpioRegisters = std::make_unique<SB::RPI5::RP1IO>(tracer);
+            SB::RPI5::RP1WaitResult_t result = {};
+            RunCritical(options, flags, [&]() { time = GpioRegisters->measRC(pin, 50000, 500000, result, errors); return time >= 0; });
+            if (time >= 0)
+                cout << std::format("{0} reads, {1} back-offs ({2})", result.reads, result.backoffs,
+                                    SB::RPI5::RP1Wait::formatPolicy(SB::RPI5::RP1Wait::defaultPolicy())) << endl;
+        }
+        else
+            RunCritical(options, flags, [&]() { time = ioPin.MeasRC(pinNr, errors); return time >= 0; });
+		if (time < 0)
+        {
+			errors.emplace_back(std::format("RUNTIME-ERROR : could not measRC at pin {0} high", pin));
+            return false;
+        }
+
+        cout << "RC time : " << time << " us." << endl;
+        trace.Info("time = %ld us", time);
+        return true;
+    }
+    catch (const std::exception& ex)
+    {
+		cerr << FRed;
+        cerr << "ERROR - exception in cmdSetPinHigh: " << ex.what() << endl;
+		cerr << FWhite;
+    }
+    return false;
+}
+
+bool cmdEnumChips(std::vector<std::string> errors)
+{
+	CFuncTracer trace("cmdEnumChips", tracer);
+	try
+	{
+		SB::RPI5::SBPio pio(tracer);
+
+        auto chips = pio.enumChips(errors);
+        for(auto chip : chips)
+            cout << "chip: " << chip.name << ", label: " << chip.label << ", lines: " << chip.lines << endl;
+        LogErrors(errors);
+        return true;
+	}
+	catch(const std::exception& e)
+	{
+		trace.Error("Exception occurred : %s", e.what());
+	}
+	return false;
+}
+
+bool Shell()
+{
+    bool bStop = false;
+    char cCmdLine[1024] = {0};
+
+    try
+    {
+          using_history();
+
+        // Make sure arrow keys work even if terminfo/keymaps are missing
+        rl_bind_keyseq("\\e[A", rl_get_previous_history); // Up
+        rl_bind_keyseq("\\e[B", rl_get_next_history);     // Down
+        rl_bind_keyseq("\\e[C", rl_forward_char);         // Right (optional)
+        rl_bind_keyseq("\\e[D", rl_backward_char);        // Left  (optional)
+
+        std::vector<std::string> errors;
+
+
+        do
+        {
+            std::cout << std::endl;
+            char* line = readline("Command : ");
+            if (!line)
+                break;
+
+            std::string sCmdLine(line);
+            free(line);
+            if (sCmdLine.empty())
+                continue;
+
+            // Add the in-memory history (enables up/down navigation)
+            add_history(sCmdLine.c_str());
 
             // optional: persistent
             // write_history(".cli_history");
@@ -1320,7 +2352,7 @@ bool Shell()
 
                     case eCmd::eMeasRC:
                     {
-                        bool ok = cmdMeasRC(pars.options, errors);
+                        bool ok = cmdMeasRC(pars.options, pars.flags, errors);
                         if (!ok)
                         {
                             errors.emplace_back("cmdMeasRC failed!");
@@ -1372,7 +2404,7 @@ bool Shell()
 
                     case eCmd::readDHT11:
                     {
-                        bool bok = cmdReadDHT11(pars.options, errors);
+                        bool bok = cmdReadDHT11(pars.options, pars.flags, errors);
                         if (!bok)
                         {
                             errors.emplace_back("cmdReadDHT11 failed");
@@ -1452,7 +2484,7 @@ bool Shell()
                     break;
                     case eCmd::eFastClk:
                     {
-                        bool bok = cmdFastClock(pars.options, errors);
+                        bool bok = cmdFastClock(pars.options, pars.flags, errors);
                         if (!bok)
                         {
                             errors.emplace_back("cmdFastClock failed");
@@ -1461,6 +2493,127 @@ bool Shell()
                     }
                     break;
 
+                    case eCmd::eCapture:
+                    {
+                        bool bok = cmdCapture(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdCapture failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::eStream:
+                    {
+                        bool bok = cmdStream(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdStream failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::eStreamRead:
+                    {
+                        bool bok = cmdStreamRead(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdStreamRead failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::eDecode:
+                    {
+                        bool bok = cmdDecode(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdDecode failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::ePort:
+                    {
+                        bool bok = cmdPort(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdPort failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::eEdges:
+                    {
+                        bool bok = cmdEdges(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdEdges failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::eLoadProfile:
+                    {
+                        bool bok = cmdLoadProfile(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdLoadProfile failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::ePwmStream:
+                    {
+                        bool bok = cmdPwmStream(pars.options, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdPwmStream failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::eRtMode:
+                    {
+                        bool bok = cmdRtMode(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdRtMode failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::eWaveform:
+                    {
+                        bool bok = cmdWaveform(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdWaveform failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
+                    case eCmd::eGpioDump:
+                    {
+                        bool bok = cmdGpioDump(pars.options, pars.flags, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdGpioDump failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
                     case eCmd::ePinSetFunction:
                     {
                         bool bok = cmdPinSetFunction(pars.options, errors);
@@ -1589,6 +2742,17 @@ bool Shell()
                     }
                     break;
 
+                    case eCmd::ePwmCommit:
+                    {
+                        bool bok = cmdPwmCommit(pars.options, errors);
+                        if (!bok)
+                        {
+                            errors.emplace_back("cmdPwmCommit failed");
+                            Usage(errors);
+                        }
+                    }
+                    break;
+
                     case eCmd::eUnknown:
                     default:
                     {
@@ -1634,6 +2798,21 @@ int main(int argc, char* argv[])
 
     LogParameters(pars);
 
+    auto itBackend = pars.options.find("backend");
+    if (itBackend != pars.options.end())
+    {
+        SB::RPI5::eRp1Backend backend = SB::RPI5::eRp1Backend::Auto;
+        if (SB::RPI5::RP1Mapping::parseBackend(itBackend->second, backend))
+            SB::RPI5::RP1Mapping::setDefaultBackend(backend);
+        else
+        {
+            errors.emplace_back(std::format("SYNTAX ERROR - unknown backend : {}", itBackend->second));
+            LogErrors(errors);
+            errors.clear();
+        }
+    }
+    trace.Info("RP1 backend : %s", SB::RPI5::RP1Mapping::backendName(SB::RPI5::RP1Mapping::getDefaultBackend()));
+
     if (argc < 2)
     {
         errors.emplace_back(
@@ -0,0 +1,170 @@
+#include "Helpers/CLIParameters.h"
+#include "Helpers/RP1Fields.h"
+#include "Helpers/RP1Mapping.h"
+#include "Tracer/ctracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// aliasLatencyBench - per-operation latency of PAD / GPIO ctrl updates done
+// the old way (read-modify-write cycles) and through the atomic SET/CLR
+// aliases (write only).
+//
+//   aliasLatencyBench run [--backend=auto|devmem|gpiomem|sim] [--pin=N]
+//                         [--samples=N] [--format=json|table]
+//
+// Use a pin that is not connected to anything: its pulls, drive strength and
+// function are rewritten (and restored at the end). On the Pi every register
+// read is a PCIe round trip to the RP1, which is what the alias variants save.
+//
+//   rmw2  : the pre-field code, clear and set as two read-modify-writes
+//   rmw   : one read-modify-write (rp1_modify)
+//   alias : SET/CLR alias writes only (rp1_apply / setFunction)
+
+using namespace SB::RPI5;
+
+namespace
+{
+    struct Variant
+    {
+        const char* op;
+        const char* variant;
+        std::function<void(uint32_t)> fn;
+    };
+
+    std::string OptionOr(const std::unordered_map<std::string, std::string>& options,
+                         const std::string& key, const std::string& def)
+    {
+        auto it = options.find(key);
+        return (it == options.end()) ? def : it->second;
+    }
+
+    double Percentile(const std::vector<double>& sorted, double p)
+    {
+        size_t idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto pars = MOW::Application::CLI::Parse(argc, argv);
+    if (!pars.errors.empty() || pars.command != "run")
+    {
+        std::cerr << "usage: aliasLatencyBench run [--backend=auto|devmem|gpiomem|sim] [--pin=N]" << std::endl;
+        std::cerr << "                             [--samples=N] [--format=json|table]" << std::endl;
+        for (const auto& e : pars.errors)
+            std::cerr << "  - " << e << std::endl;
+        return 2;
+    }
+
+    eRp1Backend backend = eRp1Backend::Auto;
+    if (!RP1Mapping::parseBackend(OptionOr(pars.options, "backend", "auto"), backend))
+    {
+        std::cerr << "unknown backend" << std::endl;
+        return 2;
+    }
+    uint32_t pin = static_cast<uint32_t>(std::stoul(OptionOr(pars.options, "pin", "27")));
+    size_t samples = std::max<size_t>(16, std::stoull(OptionOr(pars.options, "samples", "100000")));
+    bool bTable = OptionOr(pars.options, "format", "json") == "table";
+    if (pin >= RP1_BANK_PINS[0])
+    {
+        std::cerr << "--pin must be a bank 0 pin (0.." << RP1_BANK_PINS[0] - 1 << ")" << std::endl;
+        return 2;
+    }
+
+    auto tracer = std::make_shared<CFileTracer>("./", "aliasLatencyBench.log", TracerLevel::TRACER_ERROR_LEVEL);
+    auto mapping = RP1Mapping::acquire(tracer, backend);
+    if (!mapping || !mapping->isValid())
+    {
+        std::cerr << "RP1 registers could not be mapped (see aliasLatencyBench.log)" << std::endl;
+        return 1;
+    }
+
+    volatile uint32_t *pad = mapping->window(eRp1Window::Pad) + 1;   // skip VOLTAGE_SELECT
+    volatile uint32_t *gpio = mapping->window(eRp1Window::Gpio);
+    volatile uint32_t *padReg = Pad::Reg::at(pad, pin);
+    volatile uint32_t *ctrlReg = GpioCtrl::Reg::at(gpio, pin);
+
+    const uint32_t savedPad = rp1_read(padReg);
+    const uint32_t savedCtrl = rp1_read(ctrlReg);
+    const uint32_t func = GpioCtrl::FuncSel::decode(savedCtrl);
+
+    std::vector<Variant> variants = {
+        { "pad_pullup", "rmw2", [&](uint32_t i) {
+              rp1_write(padReg, rp1_read(padReg) & ~0xCu);
+              rp1_write(padReg, rp1_read(padReg) | ((i & 1) ? 0x8u : 0x4u)); } },
+        { "pad_pullup", "rmw", [&](uint32_t i) {
+              rp1_modify(pad, pin, Pad::PullUp::val(i & 1) | Pad::PullDown::val(~i & 1)); } },
+        { "pad_pullup", "alias", [&](uint32_t i) {
+              rp1_apply(pad, pin, Pad::PullUp::val(i & 1) | Pad::PullDown::val(~i & 1)); } },
+
+        { "pad_drive", "rmw2", [&](uint32_t i) {
+              rp1_write(padReg, rp1_read(padReg) & ~0x30u);
+              rp1_write(padReg, rp1_read(padReg) | ((i & 3) << 4)); } },
+        { "pad_drive", "rmw", [&](uint32_t i) { rp1_modify(pad, pin, Pad::Drive::val(i & 3)); } },
+        { "pad_drive", "alias", [&](uint32_t i) { rp1_apply(pad, pin, Pad::Drive::val(i & 3)); } },
+
+        { "pad_slew", "rmw2", [&](uint32_t i) {
+              rp1_write(padReg, rp1_read(padReg) & ~0x01u);
+              if (i & 1) rp1_write(padReg, rp1_read(padReg) | 0x01u); } },
+        { "pad_slew", "rmw", [&](uint32_t i) { rp1_modify(pad, pin, Pad::SlewFast::val(i & 1)); } },
+        { "pad_slew", "alias", [&](uint32_t i) { rp1_apply(pad, pin, Pad::SlewFast::val(i & 1)); } },
+
+        // funcsel keeps the current function; only the access pattern differs
+        { "funcsel", "rmw", [&](uint32_t) {
+              rp1_modify(gpio, pin, GpioCtrl::FuncSel::val(func)); } },
+        { "funcsel", "alias", [&](uint32_t) {
+              rp1_set_bits(ctrlReg, GpioCtrl::FuncSel::mask);
+              uint32_t clear = GpioCtrl::FuncSel::mask & ~GpioCtrl::FuncSel::encode(func);
+              if (clear != 0)
+                  rp1_clr_bits(ctrlReg, clear); } },
+    };
+
+    if (bTable)
+        std::cout << std::left << std::setw(12) << "op" << std::setw(8) << "variant" << std::setw(10) << "mean ns"
+                  << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << "max ns" << std::endl;
+
+    std::vector<double> lat(samples);
+    for (const auto& v : variants)
+    {
+        for (uint32_t i = 0; i < 64; ++i)      // warm up
+            v.fn(i);
+
+        for (size_t i = 0; i < samples; ++i)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            v.fn(static_cast<uint32_t>(i));
+            rp1_mb();       // the op is finished when its writes have left the core
+            auto t1 = std::chrono::steady_clock::now();
+            lat[i] = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        }
+        double mean = 0.0;
+        for (double x : lat) mean += x;
+        mean /= static_cast<double>(samples);
+        std::vector<double> sorted = lat;
+        std::sort(sorted.begin(), sorted.end());
+
+        if (bTable)
+            std::cout << std::left << std::setw(12) << v.op << std::setw(8) << v.variant << std::fixed << std::setprecision(1)
+                      << std::setw(10) << mean << std::setw(10) << Percentile(sorted, 0.50)
+                      << std::setw(10) << Percentile(sorted, 0.99) << sorted.back() << std::endl;
+        else
+            std::cout << std::format("{{\"op\":\"{}\",\"variant\":\"{}\",\"backend\":\"{}\",\"samples\":{},"
+                                     "\"mean_ns\":{:.1f},\"p50_ns\":{:.1f},\"p99_ns\":{:.1f},\"max_ns\":{:.1f}}}",
+                                     v.op, v.variant, RP1Mapping::backendName(mapping->backend()), samples,
+                                     mean, Percentile(sorted, 0.50), Percentile(sorted, 0.99), sorted.back())
+                      << std::endl;
+    }
+
+    rp1_write(padReg, savedPad);
+    rp1_write(ctrlReg, savedCtrl);
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include "Helpers/CLIParameters.h"
+#include "Helpers/SBRp1IO.h"
+#include "Helpers/RP1Port.h"
+#include "Tracer/ctracer.h"
+
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// busParallelBench - cost of writing a value to a parallel bus of RIO pins
+// with and without the RIO Out shadow.
+//
+//   busParallelBench run [--backend=auto|devmem|gpiomem|sim] [--base=N] [--width=N]
+//                        [--iterations=N] [--tracelevel=debug|error|off]
+//                        [--format=json|table]
+//
+// The bus is pins base .. base+width-1 of bank 0; they are switched to RIO
+// outputs for the run and restored afterwards. Every op writes the next
+// counter value to the bus.
+//
+//   read+xor : read RIO Out over PCIe, then one XOR alias write (the old path)
+//   shadow   : XOR alias write computed from the process-local shadow
+//   set+clr  : two alias writes, no read and no shadow (RP1IO::Fast::write)
+//   port     : RP1Port over the bus pins in order (shift, then set+clr)
+//   port-lut : RP1Port over the bus pins even first, then odd; the value is
+//              scattered through the lookup tables, then set+clr
+//
+// The rp1io rows go through the traced RP1IO API, the raw rows are the bare
+// register accesses.
+
+using namespace SB::RPI5;
+
+namespace
+{
+    struct Variant
+    {
+        const char* api;
+        const char* op;
+        std::function<void()> setup;
+        std::function<void(uint32_t)> fn;
+        std::function<uint32_t(uint32_t)> bus;     // expected Out bits for a value; empty: value << base
+    };
+
+    std::string OptionOr(const std::unordered_map<std::string, std::string>& options,
+                         const std::string& key, const std::string& def)
+    {
+        auto it = options.find(key);
+        return (it == options.end()) ? def : it->second;
+    }
+
+    bool ParseLevel(const std::string& name, TracerLevel& level)
+    {
+        if (name == "debug") level = TracerLevel::TRACER_DEBUG_LEVEL;
+        else if (name == "error") level = TracerLevel::TRACER_ERROR_LEVEL;
+        else if (name == "off") level = TracerLevel::TRACER_OFF_LEVEL;
+        else return false;
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto pars = MOW::Application::CLI::Parse(argc, argv);
+    if (!pars.errors.empty() || pars.command != "run")
+    {
+        std::cerr << "usage: busParallelBench run [--backend=auto|devmem|gpiomem|sim] [--base=N] [--width=N]" << std::endl;
+        std::cerr << "                            [--iterations=N] [--tracelevel=debug|error|off] [--format=json|table]" << std::endl;
+        for (const auto& e : pars.errors)
+            std::cerr << "  - " << e << std::endl;
+        return 2;
+    }
+
+    eRp1Backend backend = eRp1Backend::Auto;
+    TracerLevel level = TracerLevel::TRACER_OFF_LEVEL;
+    if (!RP1Mapping::parseBackend(OptionOr(pars.options, "backend", "auto"), backend) ||
+        !ParseLevel(OptionOr(pars.options, "tracelevel", "off"), level))
+    {
+        std::cerr << "unknown backend or trace level" << std::endl;
+        return 2;
+    }
+    uint32_t base = static_cast<uint32_t>(std::stoul(OptionOr(pars.options, "base", "16")));
+    uint32_t width = static_cast<uint32_t>(std::stoul(OptionOr(pars.options, "width", "8")));
+    uint64_t iterations = std::max<uint64_t>(1000, std::stoull(OptionOr(pars.options, "iterations", "1000000")));
+    bool bTable = OptionOr(pars.options, "format", "json") == "table";
+    if ((width == 0) || (base + width > RP1_BANK_PINS[0]))
+    {
+        std::cerr << "--base/--width must select bank 0 pins (0.." << RP1_BANK_PINS[0] - 1 << ")" << std::endl;
+        return 2;
+    }
+
+    auto tracer = std::make_shared<CFileTracer>("./", "busParallelBench.log", level);
+    RP1IO io(tracer, backend);
+    if (io.RIOBase() == nullptr)
+    {
+        std::cerr << "RP1 registers could not be mapped (see busParallelBench.log)" << std::endl;
+        return 1;
+    }
+
+    const uint32_t mask = ((width == 32) ? 0xffffffffu : ((1u << width) - 1)) << base;
+    std::vector<uint32_t> savedCtrl, savedPad;
+    for (uint32_t pin = base; pin < base + width; ++pin)
+    {
+        savedCtrl.push_back(io.getGpioCntrl(pin));
+        savedPad.push_back(io.getPad(pin));
+        io.setFunction(pin, GPIO_FUNC_RIO, savedPad.back());
+    }
+    const uint32_t savedOE = io.getRioOutputEnable() & mask;
+    io.setDirOutMask(mask);
+
+    RP1IO::Fast fast = io.fast(mask);
+    std::vector<uint32_t> inOrder, interleaved;
+    for (uint32_t pin = base; pin < base + width; ++pin)
+        inOrder.push_back(pin);
+    for (uint32_t pin = base; pin < base + width; pin += 2)
+        interleaved.push_back(pin);
+    for (uint32_t pin = base + 1; pin < base + width; pin += 2)
+        interleaved.push_back(pin);
+    RP1Port port = io.port(inOrder);
+    RP1Port portLut = io.port(interleaved);
+    volatile uint32_t *rio = io.RIOBase();
+    uint32_t shadow = 0;
+
+    std::vector<Variant> variants = {
+        { "rp1io", "read+xor", [&]() { io.disableShadow(); },
+          [&](uint32_t v) { io.setGpioPinMasked(mask, v << base); }, nullptr },
+        { "rp1io", "shadow", [&]() { io.enableShadow(mask); },
+          [&](uint32_t v) { io.setGpioPinMasked(mask, v << base); }, nullptr },
+        { "raw", "read+xor", []() {},
+          [&](uint32_t v) { rp1_xor_bits(Rio::Out::at(rio), (Rio::Out::read(rio) ^ (v << base)) & mask); }, nullptr },
+        { "raw", "shadow", [&]() { shadow = Rio::Out::read(rio); },
+          [&](uint32_t v) {
+              uint32_t diff = (shadow ^ (v << base)) & mask;
+              rp1_xor_bits(Rio::Out::at(rio), diff);
+              shadow ^= diff; }, nullptr },
+        { "raw", "set+clr", []() {},
+          [&](uint32_t v) { fast.write(mask, v << base); }, nullptr },
+        { "raw", "port", []() {},
+          [&](uint32_t v) { port.write(v); }, nullptr },
+        { "raw", "port-lut", []() {},
+          [&](uint32_t v) { portLut.write(v); }, [&](uint32_t v) { return portLut.scatter(v); } },
+    };
+
+    if (bTable)
+        std::cout << std::left << std::setw(8) << "api" << std::setw(10) << "op" << std::setw(12) << "ns/write"
+                  << std::setw(12) << "Mwrite/s" << std::setw(10) << "speedup" << "bus ok" << std::endl;
+
+    double nsBaseline[2] = { 0.0, 0.0 };
+    for (const auto& v : variants)
+    {
+        v.setup();
+        for (uint32_t i = 0; i < 64; ++i)      // warm up
+            v.fn(i);
+
+        uint32_t value = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            value = static_cast<uint32_t>(i) & (mask >> base);
+            v.fn(value);
+        }
+        rp1_mb();
+        auto t1 = std::chrono::steady_clock::now();
+
+        // The bus must hold the last value, whatever path wrote it
+        bool bOk = (Rio::Out::read(rio) & mask) == (v.bus ? v.bus(value) : (value << base));
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(iterations);
+        double& baseline = nsBaseline[std::string(v.api) == "raw" ? 1 : 0];
+        if (baseline == 0.0)
+            baseline = ns;
+        double mwps = (ns > 0.0) ? 1000.0 / ns : 0.0;
+        double speedup = (ns > 0.0) ? baseline / ns : 0.0;
+
+        if (bTable)
+            std::cout << std::left << std::setw(8) << v.api << std::setw(10) << v.op << std::fixed << std::setprecision(2)
+                      << std::setw(12) << ns << std::setw(12) << mwps << std::setw(10) << speedup
+                      << (bOk ? "yes" : "NO") << std::endl;
+        else
+            std::cout << std::format("{{\"api\":\"{}\",\"op\":\"{}\",\"backend\":\"{}\",\"width\":{},\"iterations\":{},"
+                                     "\"ns_per_write\":{:.2f},\"mwrite_per_s\":{:.3f},\"speedup\":{:.2f},\"bus_ok\":{}}}",
+                                     v.api, v.op, RP1Mapping::backendName(backend), width, iterations,
+                                     ns, mwps, speedup, bOk)
+                      << std::endl;
+    }
+
+    io.disableShadow();
+    io.clearGpioMask(mask);
+    if (savedOE != mask)
+        io.setDirInMask(mask & ~savedOE);
+    for (uint32_t pin = base; pin < base + width; ++pin)
+        io.setFunction(pin, GpioCtrl::FuncSel::decode(savedCtrl[pin - base]), savedPad[pin - base]);
+    return 0;
+}
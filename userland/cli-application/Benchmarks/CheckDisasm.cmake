@@ -0,0 +1,67 @@
+# userland/cli-application/Benchmarks/CheckDisasm.cmake
+#
+# cmake -DOBJDUMP=<objdump> -DBINARY=<exe> -DPREFIX=rfb_ -P CheckDisasm.cmake
+#
+# Compares <PREFIX>hand_<op> with <PREFIX>field_<op> in the disassembly of
+# BINARY and fails when the field version needs more instructions (or more
+# loads/stores) than the hand-written one.
+
+if (NOT OBJDUMP OR NOT BINARY OR NOT PREFIX)
+    message(FATAL_ERROR "CheckDisasm.cmake needs OBJDUMP, BINARY and PREFIX")
+endif()
+
+execute_process(
+    COMMAND ${OBJDUMP} -d --no-show-raw-insn ${BINARY}
+    OUTPUT_VARIABLE DISASM
+    RESULT_VARIABLE RES)
+if (NOT RES EQUAL 0)
+    message(FATAL_ERROR "objdump failed on ${BINARY}")
+endif()
+
+string(REPLACE "\n" ";" LINES "${DISASM}")
+
+set(CURRENT "")
+set(FUNCS "")
+foreach(LINE IN LISTS LINES)
+    if (LINE MATCHES "^[0-9a-f]+ <(${PREFIX}[a-z_]+)>:$")
+        set(CURRENT ${CMAKE_MATCH_1})
+        list(APPEND FUNCS ${CURRENT})
+        set(COUNT_${CURRENT} 0)
+        set(MEM_${CURRENT} 0)
+    elseif (LINE STREQUAL "")
+        set(CURRENT "")
+    elseif (CURRENT AND LINE MATCHES "^ +[0-9a-f]+:\t([a-z][a-z0-9.]*)(.*)$")
+        set(MNEMONIC ${CMAKE_MATCH_1})
+        set(OPERANDS "${CMAKE_MATCH_2}")
+        if (MNEMONIC MATCHES "^(nop|endbr64|int3|xchg)")
+            continue()
+        endif()
+        math(EXPR COUNT_${CURRENT} "${COUNT_${CURRENT}} + 1")
+        # aarch64: ldr/str family; x86: any instruction with a memory operand
+        if (MNEMONIC MATCHES "^(ldr|str|ldp|stp)" OR (NOT MNEMONIC MATCHES "^(lea|nop)" AND OPERANDS MATCHES "\\("))
+            math(EXPR MEM_${CURRENT} "${MEM_${CURRENT}} + 1")
+        endif()
+    endif()
+endforeach()
+
+set(FAILED 0)
+foreach(FUNC IN LISTS FUNCS)
+    if (FUNC MATCHES "^${PREFIX}hand_(.*)$")
+        set(OP ${CMAKE_MATCH_1})
+        set(FIELD ${PREFIX}field_${OP})
+        if (NOT DEFINED COUNT_${FIELD})
+            message(SEND_ERROR "disasm: ${FIELD} not found")
+            set(FAILED 1)
+            continue()
+        endif()
+        message(STATUS "disasm ${OP}: hand ${COUNT_${FUNC}} insn / ${MEM_${FUNC}} mem, field ${COUNT_${FIELD}} insn / ${MEM_${FIELD}} mem")
+        if (COUNT_${FIELD} GREATER COUNT_${FUNC} OR MEM_${FIELD} GREATER MEM_${FUNC})
+            message(SEND_ERROR "disasm: ${FIELD} is more expensive than ${FUNC}")
+            set(FAILED 1)
+        endif()
+    endif()
+endforeach()
+
+if (FAILED)
+    message(FATAL_ERROR "register field layer is not zero-cost")
+endif()
@@ -0,0 +1,314 @@
+#include "Helpers/CLIParameters.h"
+#include "Helpers/RP1Decode.h"
+#include "Tracer/ctracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// decodeBench - throughput of the protocol decoders on one core.
+//
+//   decodeBench run [--samples=N] [--rate=MS/s] [--format=json|table]
+//
+// For UART (1 Mbaud 8N1), SPI (mode 0, 1 MHz, cs), I2C (400 kHz) and 1-Wire
+// an ideal signal with idle stretches is generated and sampled into a packed
+// buffer of N 32-bit RIO words at --rate (default 16M samples at 10 MS/s).
+// Reported per protocol:
+//
+//   scalar    : change detection one sample at a time
+//   vector    : RP1Decode::changes, 8 samples per step
+//   decode    : RP1Decode::decode on the change list
+//   total     : samples per second through vector + decode
+//
+// The decoded bytes are checked against what was generated.
+
+using namespace SB::RPI5;
+
+namespace
+{
+    constexpr uint32_t UART_RX = 5;
+    constexpr uint32_t SPI_SCK = 6, SPI_MOSI = 7, SPI_MISO = 8, SPI_CS = 9;
+    constexpr uint32_t I2C_SCL = 2, I2C_SDA = 3;
+    constexpr uint32_t OW_DQ = 4;
+
+    std::string OptionOr(const std::unordered_map<std::string, std::string>& options,
+                         const std::string& key, const std::string& def)
+    {
+        auto it = options.find(key);
+        return (it == options.end()) ? def : it->second;
+    }
+
+    // Ideal signal as a change list
+    struct Generator
+    {
+        uint64_t t = 1000;
+        uint32_t state = 0;
+        std::vector<RP1Edge_t> edges;
+        std::vector<uint32_t> sent;
+        std::vector<uint64_t> sentEndNs;
+
+        explicit Generator(uint32_t idle) : state(idle) { edges.push_back({ 0, state }); }
+        void set(uint32_t pin, bool level)
+        {
+            uint32_t next = level ? (state | (1u << pin)) : (state & ~(1u << pin));
+            if (next == state)
+                return;
+            state = next;
+            if (edges.back().ns == t)
+                edges.back().state = state;
+            else
+                edges.push_back({ t, state });
+        }
+        void wait(uint64_t ns) { t += ns; }
+        void sentByte(uint32_t byte)
+        {
+            sent.push_back(byte);
+            sentEndNs.push_back(t);
+        }
+    };
+
+    void Uart(Generator& g, uint64_t endNs)
+    {
+        const uint64_t bit = 1000;
+        for (uint32_t n = 0; g.t < endNs; ++n)
+        {
+            uint32_t byte = n & 0xff;
+            g.set(UART_RX, false);
+            g.wait(bit);
+            for (int b = 0; b < 8; ++b)
+            {
+                g.set(UART_RX, (byte >> b) & 1u);
+                g.wait(bit);
+            }
+            g.set(UART_RX, true);
+            g.wait(bit);
+            g.sentByte(byte);
+            g.wait(((n % 64) == 63) ? 200000 : 2 * bit);
+        }
+    }
+
+    void Spi(Generator& g, uint64_t endNs)
+    {
+        const uint64_t half = 500;
+        for (uint32_t n = 0; g.t < endNs; n += 4)
+        {
+            g.set(SPI_CS, false);
+            g.wait(half);
+            for (uint32_t w = 0; w < 4; ++w)
+            {
+                uint32_t byte = (n + w) & 0xff;
+                for (int b = 7; b >= 0; --b)
+                {
+                    g.set(SPI_MOSI, (byte >> b) & 1u);
+                    g.set(SPI_MISO, !((byte >> b) & 1u));
+                    g.wait(half);
+                    g.set(SPI_SCK, true);
+                    g.wait(half);
+                    g.set(SPI_SCK, false);
+                }
+                g.sentByte(byte);
+            }
+            g.wait(half);
+            g.set(SPI_CS, true);
+            g.wait(20000);
+        }
+    }
+
+    void I2cBit(Generator& g, bool level)
+    {
+        const uint64_t quarter = 625;
+        g.set(I2C_SDA, level);
+        g.wait(quarter);
+        g.set(I2C_SCL, true);
+        g.wait(2 * quarter);
+        g.set(I2C_SCL, false);
+        g.wait(quarter);
+    }
+
+    void I2c(Generator& g, uint64_t endNs)
+    {
+        for (uint32_t n = 0; g.t < endNs; n += 4)
+        {
+            g.set(I2C_SDA, false);          // START
+            g.wait(600);
+            g.set(I2C_SCL, false);
+            g.wait(600);
+            for (uint32_t w = 0; w < 5; ++w)
+            {
+                uint32_t byte = (w == 0) ? (0x50u << 1) : ((n + w - 1) & 0xff);
+                for (int b = 7; b >= 0; --b)
+                    I2cBit(g, (byte >> b) & 1u);
+                I2cBit(g, false);           // ACK
+                if (w > 0)
+                    g.sentByte(byte);
+            }
+            g.set(I2C_SDA, false);          // STOP
+            g.wait(600);
+            g.set(I2C_SCL, true);
+            g.wait(600);
+            g.set(I2C_SDA, true);
+            g.wait(50000);
+        }
+    }
+
+    void OneWire(Generator& g, uint64_t endNs)
+    {
+        for (uint32_t n = 0; g.t < endNs; n += 8)
+        {
+            g.set(OW_DQ, false);            // reset + presence
+            g.wait(480000);
+            g.set(OW_DQ, true);
+            g.wait(30000);
+            g.set(OW_DQ, false);
+            g.wait(120000);
+            g.set(OW_DQ, true);
+            g.wait(300000);
+            for (uint32_t w = 0; w < 8; ++w)
+            {
+                uint32_t byte = (n + w) & 0xff;
+                for (int b = 0; b < 8; ++b)
+                {
+                    bool one = (byte >> b) & 1u;
+                    g.set(OW_DQ, false);
+                    g.wait(one ? 6000 : 60000);
+                    g.set(OW_DQ, true);
+                    g.wait(one ? 64000 : 10000);
+                }
+                g.sentByte(byte);
+            }
+            g.wait(100000);
+        }
+    }
+
+    void Sample(const std::vector<RP1Edge_t>& edges, uint64_t periodNs, std::vector<uint32_t>& samples)
+    {
+        size_t e = 0;
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            const uint64_t t = i * periodNs;
+            while ((e + 1 < edges.size()) && (edges[e + 1].ns <= t))
+                ++e;
+            samples[i] = edges[e].state;
+        }
+    }
+
+    size_t ScalarChanges(const uint32_t* samples, size_t n, uint32_t mask, uint64_t periodNs, std::vector<RP1Edge_t>& edges)
+    {
+        edges.clear();
+        uint32_t prev = samples[0] & mask;
+        edges.push_back({ 0, prev });
+        for (size_t i = 1; i < n; ++i)
+        {
+            uint32_t v = samples[i] & mask;
+            if (v != prev)
+            {
+                edges.push_back({ i * periodNs, v });
+                prev = v;
+            }
+        }
+        return edges.size();
+    }
+
+    template <typename Fn>
+    double Seconds(Fn fn)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto pars = MOW::Application::CLI::Parse(argc, argv);
+    if (!pars.errors.empty() || pars.command != "run")
+    {
+        std::cerr << "usage: decodeBench run [--samples=N] [--rate=MS/s] [--format=json|table]" << std::endl;
+        for (const auto& e : pars.errors)
+            std::cerr << "  - " << e << std::endl;
+        return 2;
+    }
+    const size_t n = std::max<size_t>(1024, std::stoull(OptionOr(pars.options, "samples", "16777216")));
+    const uint64_t periodNs = std::max<uint64_t>(1, 1000 / std::max<uint64_t>(1, std::stoull(OptionOr(pars.options, "rate", "10"))));
+    const bool bTable = OptionOr(pars.options, "format", "json") == "table";
+    auto tracer = std::make_shared<CFileTracer>("./", "decodeBench.log", TracerLevel::TRACER_OFF_LEVEL);
+    RP1Decode decoder(tracer);
+
+    struct Case
+    {
+        const char* name;
+        std::function<void(Generator&, uint64_t)> generate;
+        uint32_t idle;
+        RP1DecodeConfig_t config;
+    };
+    std::vector<Case> cases;
+    RP1DecodeConfig_t config;
+    RP1Decode::parseProtocol("uart", config);
+    config.pins[0] = UART_RX;
+    config.baud = 1000000;
+    cases.push_back({ "uart", Uart, 1u << UART_RX, config });
+    RP1Decode::parseProtocol("spi", config);
+    config.pins[0] = SPI_SCK; config.pins[1] = SPI_MOSI; config.pins[2] = SPI_MISO; config.pins[3] = SPI_CS;
+    cases.push_back({ "spi", Spi, 1u << SPI_CS, config });
+    RP1Decode::parseProtocol("i2c", config);
+    config.pins[0] = I2C_SCL; config.pins[1] = I2C_SDA;
+    cases.push_back({ "i2c", I2c, (1u << I2C_SCL) | (1u << I2C_SDA), config });
+    RP1Decode::parseProtocol("onewire", config);
+    config.pins[0] = OW_DQ;
+    cases.push_back({ "onewire", OneWire, 1u << OW_DQ, config });
+
+    if (bTable)
+        std::cout << std::left << std::setw(9) << "proto" << std::setw(10) << "changes" << std::setw(13) << "scalar MS/s"
+                  << std::setw(13) << "vector MS/s" << std::setw(15) << "decode Mchg/s" << std::setw(13) << "total MS/s"
+                  << std::setw(8) << "frames" << "check" << std::endl;
+
+    std::vector<uint32_t> samples(n);
+    std::vector<RP1Edge_t> edges;
+    std::vector<RP1Frame_t> frames;
+    for (const auto& c : cases)
+    {
+        Generator g(c.idle);
+        c.generate(g, n * periodNs);
+        Sample(g.edges, periodNs, samples);
+        const uint32_t mask = RP1Decode::pinMask(c.config);
+
+        double tScalar = Seconds([&]() { ScalarChanges(samples.data(), n, mask, periodNs, edges); });
+        const size_t scalarEdges = edges.size();
+        double tVector = Seconds([&]() { RP1Decode::changes(samples.data(), n, mask, periodNs, edges); });
+        double tDecode = Seconds([&]() { decoder.decode(c.config, edges, n * periodNs, frames); });
+
+        size_t matched = 0, data = 0;
+        bool bOk = (scalarEdges == edges.size());
+        for (const auto& f : frames)
+        {
+            if ((f.type != eRp1FrameType::eData) || (f.flags & RP1_FRAME_INCOMPLETE))
+                continue;
+            if ((data < g.sent.size()) && (f.data == g.sent[data]) && (f.flags == 0))
+                ++matched;
+            ++data;
+        }
+        // every byte that was complete inside the buffer is decoded
+        const size_t complete = std::count_if(g.sentEndNs.begin(), g.sentEndNs.end(), [&](uint64_t t) { return t <= n * periodNs; });
+        bOk = bOk && (data > 0) && (matched == data) && (data >= complete);
+
+        const double ms = static_cast<double>(n) / 1e6;
+        if (bTable)
+            std::cout << std::left << std::fixed << std::setprecision(1) << std::setw(9) << c.name << std::setw(10) << edges.size()
+                      << std::setw(13) << ms / tScalar << std::setw(13) << ms / tVector
+                      << std::setw(15) << edges.size() / 1e6 / tDecode << std::setw(13) << ms / (tVector + tDecode)
+                      << std::setw(8) << frames.size() << (bOk ? "ok" : "MISMATCH") << std::endl;
+        else
+            std::cout << std::format("{{\"proto\":\"{}\",\"samples\":{},\"changes\":{},\"scalar_msps\":{:.1f},\"vector_msps\":{:.1f},"
+                                     "\"decode_mchps\":{:.1f},\"total_msps_per_core\":{:.1f},\"frames\":{},\"ok\":{}}}",
+                                     c.name, n, edges.size(), ms / tScalar, ms / tVector, edges.size() / 1e6 / tDecode,
+                                     ms / (tVector + tDecode), frames.size(), bOk ? "true" : "false")
+                      << std::endl;
+    }
+    return 0;
+}
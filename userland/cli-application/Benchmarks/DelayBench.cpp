@@ -0,0 +1,118 @@
+#include "Helpers/CLIParameters.h"
+#include "Helpers/SBDelay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// delayBench - accuracy of the delay primitives for delays from 1 us to 100 ms.
+//
+//   delayBench run [--samples=N] [--threshold=ns] [--format=json|table]
+//
+// For every delay and method the error (achieved - requested) is measured
+// with CLOCK_MONOTONIC and reported as mean / p50 / p99 / max. Long delays use
+// fewer samples so one method takes at most about two seconds.
+//
+//   sleep_for : std::this_thread::sleep_for (what the helpers used before)
+//   nanosleep : clock_nanosleep relative
+//   sbdelay   : SBDelay::ns, sleep + calibrated spin
+//
+// --threshold overrides the calibrated sleep/spin switch-over.
+
+using namespace SB::RPI5;
+
+namespace
+{
+    struct Method
+    {
+        const char* name;
+        std::function<void(uint64_t)> fn;
+    };
+
+    std::string OptionOr(const std::unordered_map<std::string, std::string>& options,
+                         const std::string& key, const std::string& def)
+    {
+        auto it = options.find(key);
+        return (it == options.end()) ? def : it->second;
+    }
+
+    double Percentile(const std::vector<double>& sorted, double p)
+    {
+        size_t idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto pars = MOW::Application::CLI::Parse(argc, argv);
+    if (!pars.errors.empty() || pars.command != "run")
+    {
+        std::cerr << "usage: delayBench run [--samples=N] [--threshold=ns] [--format=json|table]" << std::endl;
+        for (const auto& e : pars.errors)
+            std::cerr << "  - " << e << std::endl;
+        return 2;
+    }
+    size_t samples = std::max<size_t>(10, std::stoull(OptionOr(pars.options, "samples", "1000")));
+    bool bTable = OptionOr(pars.options, "format", "json") == "table";
+
+    auto cal = SBDelay::calibrate();
+    if (pars.options.count("threshold"))
+        SBDelay::setThresholdNs(std::stoull(pars.options.at("threshold")));
+    std::cerr << std::format("wakeup latency mean {} ns, p99 {} ns, max {} ns; spin threshold {} ns",
+                             cal.meanWakeupNs, cal.p99WakeupNs, cal.maxWakeupNs, SBDelay::thresholdNs())
+              << std::endl;
+
+    std::vector<Method> methods = {
+        { "sleep_for", [](uint64_t ns) { std::this_thread::sleep_for(std::chrono::nanoseconds(ns)); } },
+        { "nanosleep", [](uint64_t ns) {
+              timespec ts { static_cast<time_t>(ns / 1000000000ull), static_cast<long>(ns % 1000000000ull) };
+              clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, nullptr); } },
+        { "sbdelay", [](uint64_t ns) { SBDelay::ns(ns); } },
+    };
+    const uint64_t delaysNs[] = { 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+    if (bTable)
+        std::cout << std::left << std::setw(12) << "delay us" << std::setw(11) << "method" << std::setw(8) << "n"
+                  << std::setw(12) << "mean err" << std::setw(12) << "p50 err" << std::setw(12) << "p99 err"
+                  << "max err (ns)" << std::endl;
+
+    for (uint64_t delay : delaysNs)
+    {
+        size_t n = std::clamp<size_t>(static_cast<size_t>(2000000000ull / delay), 10, samples);
+        for (const auto& m : methods)
+        {
+            std::vector<double> err(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                uint64_t t0 = SBDelay::nowNs();
+                m.fn(delay);
+                uint64_t t1 = SBDelay::nowNs();
+                err[i] = static_cast<double>(t1 - t0) - static_cast<double>(delay);
+            }
+            double mean = 0.0;
+            for (double e : err) mean += e;
+            mean /= static_cast<double>(n);
+            std::sort(err.begin(), err.end());
+
+            if (bTable)
+                std::cout << std::left << std::setw(12) << delay / 1000 << std::setw(11) << m.name << std::setw(8) << n
+                          << std::fixed << std::setprecision(0) << std::setw(12) << mean << std::setw(12) << Percentile(err, 0.50)
+                          << std::setw(12) << Percentile(err, 0.99) << err.back() << std::endl;
+            else
+                std::cout << std::format("{{\"delay_ns\":{},\"method\":\"{}\",\"samples\":{},\"threshold_ns\":{},"
+                                         "\"mean_err_ns\":{:.0f},\"p50_err_ns\":{:.0f},\"p99_err_ns\":{:.0f},\"max_err_ns\":{:.0f}}}",
+                                         delay, m.name, n, SBDelay::thresholdNs(), mean,
+                                         Percentile(err, 0.50), Percentile(err, 0.99), err.back())
+                          << std::endl;
+        }
+    }
+    return 0;
+}
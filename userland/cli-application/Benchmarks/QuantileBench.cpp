@@ -0,0 +1,332 @@
+#include "Helpers/CLIParameters.h"
+#include "Helpers/Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// quantileBench - accuracy and throughput of the streaming quantile estimators.
+//
+//   quantileBench run  [--samples=N] [--seed=S] [--repeat=R] [--dist=name|all]
+//                      [--backend=name|all] [--format=json|table] [--maxrankerr=E]
+//   quantileBench list
+//
+// Every (backend, distribution, quantile) combination produces one JSON object
+// per line on stdout. Errors are reported against the exact quantile of the
+// same sample stream (nearest rank). rank_err is the distance, in quantile
+// units, between the requested p and the fraction of samples <= estimate; it
+// is scale free and therefore the number to gate on (--maxrankerr).
+
+using namespace MOW::Statistics;
+
+namespace
+{
+    constexpr double kQuantiles[] = { 0.50, 0.95, 0.99 };
+
+    // ----------------------------------------------------------------
+    // Backends: a backend is a struct with reset/add/quantile and a name.
+    // To evaluate a new estimator add a struct here and a line in Backends().
+    // ----------------------------------------------------------------
+    struct P2EstimatorBackend
+    {
+        static constexpr const char* name = "P2Estimator";
+        P2Estimator est[3]{ P2Estimator(0.50), P2Estimator(0.95), P2Estimator(0.99) };
+
+        void reset() { est[0].init(0.50); est[1].init(0.95); est[2].init(0.99); }
+        void add(double x) { for (auto& e : est) e.addSample(x); }
+        double quantile(double p) const
+        {
+            for (const auto& e : est)
+                if (e.p == p) return e.estimate();
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        std::size_t stateBytes() const { return sizeof(est); }
+    };
+
+    struct P2SetBackend
+    {
+        static constexpr const char* name = "P2Set";
+        P2Set set{};
+
+        void reset() { set.init(); }
+        void add(double x) { set.addSample(x); }
+        double quantile(double p) const
+        {
+            if (p == 0.50) return set.P50();
+            if (p == 0.95) return set.P95();
+            if (p == 0.99) return set.P99();
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        std::size_t stateBytes() const { return sizeof(set); }
+    };
+
+    struct MetricValueBackend
+    {
+        static constexpr const char* name = "MetricValue";
+        MetricValue metric{};
+
+        void reset() { metric.reset(); }
+        void add(double x) { metric.addValue(x); }
+        double quantile(double p) const
+        {
+            if (p == 0.50) return metric.getP50();
+            if (p == 0.95) return metric.getP95();
+            if (p == 0.99) return metric.getP99();
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        std::size_t stateBytes() const { return sizeof(metric); }
+    };
+
+    struct BenchResult
+    {
+        std::string backend;
+        double nsPerSample = 0.0;
+        std::size_t stateBytes = 0;
+        double estimates[std::size(kQuantiles)]{};
+    };
+
+    template <class Backend>
+    BenchResult RunBackend(const std::vector<double>& samples, int repeat)
+    {
+        BenchResult res;
+        res.backend = Backend::name;
+        res.nsPerSample = std::numeric_limits<double>::max();
+
+        auto backend = std::make_unique<Backend>();
+        for (int r = 0; r < repeat; ++r)
+        {
+            backend->reset();
+            auto t0 = std::chrono::steady_clock::now();
+            for (double x : samples)
+                backend->add(x);
+            auto t1 = std::chrono::steady_clock::now();
+
+            double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+            res.nsPerSample = std::min(res.nsPerSample, ns / static_cast<double>(samples.size()));
+        }
+
+        for (std::size_t i = 0; i < std::size(kQuantiles); ++i)
+            res.estimates[i] = backend->quantile(kQuantiles[i]);
+        res.stateBytes = backend->stateBytes();
+        return res;
+    }
+
+    struct BackendEntry
+    {
+        const char* name;
+        BenchResult (*run)(const std::vector<double>&, int);
+    };
+
+    const std::vector<BackendEntry>& Backends()
+    {
+        static const std::vector<BackendEntry> backends = {
+            { P2EstimatorBackend::name, &RunBackend<P2EstimatorBackend> },
+            { P2SetBackend::name,       &RunBackend<P2SetBackend> },
+            { MetricValueBackend::name, &RunBackend<MetricValueBackend> },
+        };
+        return backends;
+    }
+
+    // ----------------------------------------------------------------
+    // Synthetic distributions
+    // ----------------------------------------------------------------
+    struct DistEntry
+    {
+        const char* name;
+        const char* description;
+        void (*generate)(std::vector<double>&, std::mt19937_64&);
+    };
+
+    const std::vector<DistEntry>& Distributions()
+    {
+        static const std::vector<DistEntry> dists = {
+            { "uniform", "uniform [0, 1000)",
+              [](std::vector<double>& v, std::mt19937_64& rng) {
+                  std::uniform_real_distribution<double> d(0.0, 1000.0);
+                  for (auto& x : v) x = d(rng);
+              } },
+            { "normal", "normal(100, 15)",
+              [](std::vector<double>& v, std::mt19937_64& rng) {
+                  std::normal_distribution<double> d(100.0, 15.0);
+                  for (auto& x : v) x = d(rng);
+              } },
+            { "lognormal", "log-normal(0, 1), latency-like",
+              [](std::vector<double>& v, std::mt19937_64& rng) {
+                  std::lognormal_distribution<double> d(0.0, 1.0);
+                  for (auto& x : v) x = d(rng);
+              } },
+            { "bimodal", "80% normal(50, 5) + 20% normal(200, 20), hit/miss-like",
+              [](std::vector<double>& v, std::mt19937_64& rng) {
+                  std::normal_distribution<double> fast(50.0, 5.0);
+                  std::normal_distribution<double> slow(200.0, 20.0);
+                  std::bernoulli_distribution pickSlow(0.20);
+                  for (auto& x : v) x = pickSlow(rng) ? slow(rng) : fast(rng);
+              } },
+            { "pareto", "pareto(xm = 1, alpha = 1.5), heavy tail",
+              [](std::vector<double>& v, std::mt19937_64& rng) {
+                  std::uniform_real_distribution<double> u(0.0, 1.0);
+                  for (auto& x : v) x = 1.0 / std::pow(1.0 - u(rng), 1.0 / 1.5);
+              } },
+            { "sorted-asc", "uniform [0, 1000) presented in ascending order",
+              [](std::vector<double>& v, std::mt19937_64& rng) {
+                  std::uniform_real_distribution<double> d(0.0, 1000.0);
+                  for (auto& x : v) x = d(rng);
+                  std::sort(v.begin(), v.end());
+              } },
+            { "sorted-desc", "uniform [0, 1000) presented in descending order",
+              [](std::vector<double>& v, std::mt19937_64& rng) {
+                  std::uniform_real_distribution<double> d(0.0, 1000.0);
+                  for (auto& x : v) x = d(rng);
+                  std::sort(v.begin(), v.end(), std::greater<double>());
+              } },
+            { "sawtooth", "repeated ascending ramps of 1000 samples",
+              [](std::vector<double>& v, std::mt19937_64&) {
+                  for (std::size_t i = 0; i < v.size(); ++i) v[i] = static_cast<double>(i % 1000);
+              } },
+            { "step", "normal(100, 15) then normal(1000, 15) halfway (regime change)",
+              [](std::vector<double>& v, std::mt19937_64& rng) {
+                  std::normal_distribution<double> before(100.0, 15.0);
+                  std::normal_distribution<double> after(1000.0, 15.0);
+                  for (std::size_t i = 0; i < v.size(); ++i)
+                      v[i] = (i < v.size() / 2) ? before(rng) : after(rng);
+              } },
+        };
+        return dists;
+    }
+
+    double ExactQuantile(const std::vector<double>& sorted, double p)
+    {
+        // nearest rank: smallest value with at least p*n samples <= value
+        std::size_t rank = static_cast<std::size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+        if (rank == 0) rank = 1;
+        return sorted[std::min(rank, sorted.size()) - 1];
+    }
+
+    double RankOf(const std::vector<double>& sorted, double value)
+    {
+        auto it = std::upper_bound(sorted.begin(), sorted.end(), value);
+        return static_cast<double>(it - sorted.begin()) / static_cast<double>(sorted.size());
+    }
+
+    std::string OptionOr(const std::unordered_map<std::string, std::string>& options,
+                         const std::string& key, const std::string& def)
+    {
+        auto it = options.find(key);
+        return (it == options.end()) ? def : it->second;
+    }
+
+    void List()
+    {
+        std::cout << "backends:" << std::endl;
+        for (const auto& b : Backends())
+            std::cout << "    - " << b.name << std::endl;
+        std::cout << "distributions:" << std::endl;
+        for (const auto& d : Distributions())
+            std::cout << "    - " << std::left << std::setw(12) << d.name << " : " << d.description << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto pars = MOW::Application::CLI::Parse(argc, argv);
+    if (!pars.errors.empty() || (pars.command != "run" && pars.command != "list"))
+    {
+        std::cerr << "usage: quantileBench run [--samples=N] [--seed=S] [--repeat=R] [--dist=name|all]" << std::endl;
+        std::cerr << "                         [--backend=name|all] [--format=json|table] [--maxrankerr=E]" << std::endl;
+        std::cerr << "       quantileBench list" << std::endl;
+        for (const auto& e : pars.errors)
+            std::cerr << "  - " << e << std::endl;
+        return 2;
+    }
+    if (pars.command == "list")
+    {
+        List();
+        return 0;
+    }
+
+    std::size_t samples = std::stoull(OptionOr(pars.options, "samples", "2000000"));
+    std::uint64_t seed = std::stoull(OptionOr(pars.options, "seed", "1"));
+    int repeat = std::max(1, std::stoi(OptionOr(pars.options, "repeat", "1")));
+    std::string distFilter = OptionOr(pars.options, "dist", "all");
+    std::string backendFilter = OptionOr(pars.options, "backend", "all");
+    bool bTable = OptionOr(pars.options, "format", "json") == "table";
+    double maxRankErr = std::stod(OptionOr(pars.options, "maxrankerr", "-1"));
+
+    if (samples < 5)
+    {
+        std::cerr << "--samples must be >= 5 (P2 warm-up)" << std::endl;
+        return 2;
+    }
+
+    if (bTable)
+    {
+        std::cout << std::left
+                  << std::setw(14) << "backend" << std::setw(13) << "dist" << std::setw(7) << "q"
+                  << std::setw(15) << "exact" << std::setw(15) << "estimate" << std::setw(13) << "rel_err"
+                  << std::setw(11) << "rank_err" << std::setw(10) << "ns/smp" << "bytes" << std::endl;
+    }
+
+    int failures = 0;
+    std::vector<double> stream(samples);
+    std::vector<double> sorted;
+    for (const auto& dist : Distributions())
+    {
+        if (distFilter != "all" && distFilter != dist.name)
+            continue;
+
+        std::mt19937_64 rng(seed);
+        dist.generate(stream, rng);
+        sorted = stream;
+        std::sort(sorted.begin(), sorted.end());
+
+        for (const auto& backend : Backends())
+        {
+            if (backendFilter != "all" && backendFilter != backend.name)
+                continue;
+
+            BenchResult res = backend.run(stream, repeat);
+            for (std::size_t i = 0; i < std::size(kQuantiles); ++i)
+            {
+                double p = kQuantiles[i];
+                double exact = ExactQuantile(sorted, p);
+                double est = res.estimates[i];
+                double absErr = std::fabs(est - exact);
+                double relErr = (exact != 0.0) ? absErr / std::fabs(exact) : absErr;
+                double rankErr = std::fabs(RankOf(sorted, est) - p);
+                bool bFail = (maxRankErr >= 0.0) && !(rankErr <= maxRankErr);
+                if (bFail) ++failures;
+
+                if (bTable)
+                {
+                    std::cout << std::left
+                              << std::setw(14) << res.backend << std::setw(13) << dist.name << std::setw(7) << p
+                              << std::setw(15) << exact << std::setw(15) << est << std::setw(13) << relErr
+                              << std::setw(11) << rankErr << std::setw(10) << std::setprecision(4) << res.nsPerSample
+                              << std::setprecision(6) << res.stateBytes << (bFail ? "  FAIL" : "") << std::endl;
+                }
+                else
+                {
+                    std::cout << std::format("{{\"backend\":\"{}\",\"dist\":\"{}\",\"samples\":{},\"seed\":{},\"q\":{},"
+                                             "\"exact\":{},\"estimate\":{},\"abs_err\":{},\"rel_err\":{},\"rank_err\":{},"
+                                             "\"ns_per_sample\":{},\"state_bytes\":{},\"exact_bytes\":{},\"pass\":{}}}",
+                                             res.backend, dist.name, samples, seed, p,
+                                             exact, est, absErr, relErr, rankErr,
+                                             res.nsPerSample, res.stateBytes, samples * sizeof(double),
+                                             bFail ? "false" : "true")
+                              << std::endl;
+                }
+            }
+        }
+    }
+
+    return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+#include "Helpers/CLIParameters.h"
+#include "Helpers/RP1Fields.h"
+
+#include <chrono>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// registerFieldBench - cost of the RP1Register/RP1Field layer against the
+// hand-written mask code it replaced.
+//
+//   registerFieldBench run [--iterations=N] [--format=json|table]
+//   registerFieldBench list
+//
+// Every operation exists twice, rfb_hand_<op> and rfb_field_<op>, as
+// non-inlined extern "C" functions so they are easy to find with objdump.
+// The build runs CheckDisasm.cmake on the binary and fails when a field
+// version has more instructions than its hand-written twin; this program
+// reports ns/op for both on a volatile memory image of the registers (same
+// code path as the Pi, without the PCIe latency).
+
+using namespace SB::RPI5;
+
+extern "C"
+{
+    // PAD: pull-up on, pull-down off (one RMW)
+    [[gnu::noinline]] void rfb_hand_pad_pullup(volatile uint32_t *pad, uint32_t pin)
+    {
+        uint32_t v = pad[pin];
+        pad[pin] = (v & ~0xCu) | 0x8u;
+    }
+    [[gnu::noinline]] void rfb_field_pad_pullup(volatile uint32_t *pad, uint32_t pin)
+    {
+        rp1_modify(pad, pin, Pad::PullUp::val(1) | Pad::PullDown::val(0));
+    }
+
+    // PAD: drive strength + slew + schmitt in one RMW, runtime drive value
+    [[gnu::noinline]] void rfb_hand_pad_multi(volatile uint32_t *pad, uint32_t pin, uint32_t drive)
+    {
+        uint32_t v = pad[pin];
+        pad[pin] = (v & ~0x33u) | ((drive << 4) & 0x30u) | 0x2u | 0x1u;
+    }
+    [[gnu::noinline]] void rfb_field_pad_multi(volatile uint32_t *pad, uint32_t pin, uint32_t drive)
+    {
+        rp1_modify(pad, pin, Pad::Drive::val(drive) | Pad::Schmitt::val(1) | Pad::SlewFast::val(1));
+    }
+
+    // PAD: decode the drive field
+    [[gnu::noinline]] uint32_t rfb_hand_pad_getdrive(const volatile uint32_t *pad, uint32_t pin)
+    {
+        return (pad[pin] & 0x30u) >> 4;
+    }
+    [[gnu::noinline]] uint32_t rfb_field_pad_getdrive(const volatile uint32_t *pad, uint32_t pin)
+    {
+        return Pad::Drive::get(pad, pin);
+    }
+
+    // GPIO ctrl: function select
+    [[gnu::noinline]] void rfb_hand_funcsel(volatile uint32_t *gpio, uint32_t pin, uint32_t func)
+    {
+        volatile uint32_t *ctrl = gpio + pin * 2 + 1;
+        uint32_t v = *ctrl;
+        *ctrl = (v & ~0x1fu) | (func & 0x1fu);
+    }
+    [[gnu::noinline]] void rfb_field_funcsel(volatile uint32_t *gpio, uint32_t pin, uint32_t func)
+    {
+        GpioCtrl::FuncSel::set(gpio, pin, func);
+    }
+
+    // PWM: enable channel + SET_UPDATE
+    [[gnu::noinline]] void rfb_hand_pwm_enable(volatile uint32_t *pwm, uint32_t channel)
+    {
+        uint32_t v = *pwm;
+        *pwm = v | (1u << channel) | 0x80000000u;
+    }
+    [[gnu::noinline]] void rfb_field_pwm_enable(volatile uint32_t *pwm, uint32_t channel)
+    {
+        rp1_modify(pwm, 0, PwmGlobal::ChanEnable::bitOn(channel) | PwmGlobal::SetUpdate::val(1));
+    }
+
+    // PWM: range/duty/phase of a channel (three plain stores), hand version as
+    // the old PWMRegs_t struct access
+    struct HandPwmChan { uint32_t cntrl; uint32_t range; uint32_t phase; uint32_t duty; };
+    [[gnu::noinline]] void rfb_hand_pwm_rdp(volatile uint32_t *pwm, uint32_t channel, uint32_t range, uint32_t duty)
+    {
+        volatile HandPwmChan *chan = reinterpret_cast<volatile HandPwmChan*>(pwm + 0x14 / 4);
+        chan[channel].range = range;
+        chan[channel].duty = duty;
+        chan[channel].phase = 0;
+    }
+    [[gnu::noinline]] void rfb_field_pwm_rdp(volatile uint32_t *pwm, uint32_t channel, uint32_t range, uint32_t duty)
+    {
+        PwmChan::Range::write(pwm, channel, range);
+        PwmChan::Duty::write(pwm, channel, duty);
+        PwmChan::Phase::write(pwm, channel, 0);
+    }
+
+    // RIO: n writes of the same mask to the XOR alias; none may be merged
+    [[gnu::noinline]] void rfb_hand_rio_toggle(volatile uint32_t *rioXor, uint32_t mask, int n)
+    {
+        for (int i = 0; i < n; ++i)
+            *rioXor = mask;
+    }
+    [[gnu::noinline]] void rfb_field_rio_toggle(volatile uint32_t *rioXor, uint32_t mask, int n)
+    {
+        for (int i = 0; i < n; ++i)
+            Rio::Out::write(rioXor, 0, mask);
+    }
+}
+
+namespace
+{
+    struct BenchResult
+    {
+        const char* op;
+        double nsHand;
+        double nsField;
+    };
+
+    template <typename Fn>
+    double TimeNs(uint64_t iterations, Fn&& fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            fn(i);
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(iterations);
+    }
+
+    std::string OptionOr(const std::unordered_map<std::string, std::string>& options,
+                         const std::string& key, const std::string& def)
+    {
+        auto it = options.find(key);
+        return (it == options.end()) ? def : it->second;
+    }
+
+    const char* kOps[] = { "pad_pullup", "pad_multi", "pad_getdrive", "funcsel", "pwm_enable", "pwm_rdp", "rio_toggle" };
+}
+
+int main(int argc, char* argv[])
+{
+    auto pars = MOW::Application::CLI::Parse(argc, argv);
+    if (!pars.errors.empty() || (pars.command != "run" && pars.command != "list"))
+    {
+        std::cerr << "usage: registerFieldBench run [--iterations=N] [--format=json|table]" << std::endl;
+        std::cerr << "       registerFieldBench list" << std::endl;
+        for (const auto& e : pars.errors)
+            std::cerr << "  - " << e << std::endl;
+        return 2;
+    }
+    if (pars.command == "list")
+    {
+        for (const char* op : kOps)
+            std::cout << "    - " << op << std::endl;
+        return 0;
+    }
+
+    uint64_t iterations = std::stoull(OptionOr(pars.options, "iterations", "20000000"));
+    bool bTable = OptionOr(pars.options, "format", "json") == "table";
+
+    // Register image: one RP1 block (GPIO/PAD/PWM layout all fit in it)
+    alignas(64) static volatile uint32_t block[0x4000 / 4] = {};
+    volatile uint32_t *regs = block;
+    volatile uint32_t sink = 0;
+
+    std::vector<BenchResult> results;
+    results.push_back({ "pad_pullup",
+        TimeNs(iterations, [&](uint64_t i) { rfb_hand_pad_pullup(regs, i & 15); }),
+        TimeNs(iterations, [&](uint64_t i) { rfb_field_pad_pullup(regs, i & 15); }) });
+    results.push_back({ "pad_multi",
+        TimeNs(iterations, [&](uint64_t i) { rfb_hand_pad_multi(regs, i & 15, i & 3); }),
+        TimeNs(iterations, [&](uint64_t i) { rfb_field_pad_multi(regs, i & 15, i & 3); }) });
+    results.push_back({ "pad_getdrive",
+        TimeNs(iterations, [&](uint64_t i) { sink = rfb_hand_pad_getdrive(regs, i & 15); }),
+        TimeNs(iterations, [&](uint64_t i) { sink = rfb_field_pad_getdrive(regs, i & 15); }) });
+    results.push_back({ "funcsel",
+        TimeNs(iterations, [&](uint64_t i) { rfb_hand_funcsel(regs, i & 15, 5); }),
+        TimeNs(iterations, [&](uint64_t i) { rfb_field_funcsel(regs, i & 15, 5); }) });
+    results.push_back({ "pwm_enable",
+        TimeNs(iterations, [&](uint64_t i) { rfb_hand_pwm_enable(regs, i & 3); }),
+        TimeNs(iterations, [&](uint64_t i) { rfb_field_pwm_enable(regs, i & 3); }) });
+    results.push_back({ "pwm_rdp",
+        TimeNs(iterations, [&](uint64_t i) { rfb_hand_pwm_rdp(regs, i & 3, 1000, 500); }),
+        TimeNs(iterations, [&](uint64_t i) { rfb_field_pwm_rdp(regs, i & 3, 1000, 500); }) });
+    results.push_back({ "rio_toggle",
+        TimeNs(iterations / 64, [&](uint64_t) { rfb_hand_rio_toggle(regs, 0x20, 64); }) / 64.0,
+        TimeNs(iterations / 64, [&](uint64_t) { rfb_field_rio_toggle(regs, 0x20, 64); }) / 64.0 });
+    (void)sink;
+
+    if (bTable)
+        std::cout << std::left << std::setw(14) << "op" << std::setw(12) << "hand ns" << std::setw(12) << "field ns" << "ratio" << std::endl;
+    for (const auto& r : results)
+    {
+        double ratio = (r.nsHand > 0.0) ? r.nsField / r.nsHand : 0.0;
+        if (bTable)
+            std::cout << std::left << std::setw(14) << r.op << std::setw(12) << std::setprecision(4) << r.nsHand
+                      << std::setw(12) << r.nsField << ratio << std::endl;
+        else
+            std::cout << std::format("{{\"op\":\"{}\",\"iterations\":{},\"hand_ns\":{},\"field_ns\":{},\"ratio\":{}}}",
+                                     r.op, iterations, r.nsHand, r.nsField, ratio)
+                      << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "Helpers/CLIParameters.h"
+#include "Helpers/SBRp1IO.h"
+#include "Tracer/ctracer.h"
+
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// toggleRateBench - how fast one RIO pin can be toggled through the traced
+// RP1IO API, through the RP1IO::Fast handle and through an RP1IO::Pin handle.
+//
+//   toggleRateBench run [--backend=auto|devmem|gpiomem|sim] [--pin=N]
+//                       [--iterations=N] [--tracelevel=debug|error|off]
+//                       [--format=json|table]
+//
+// The pin is switched to RIO output for the run and restored afterwards; use
+// one that is not connected to anything. --tracelevel is the level of the
+// tracer handed to RP1IO (the cli application runs with debug).
+
+using namespace SB::RPI5;
+
+namespace
+{
+    struct Variant
+    {
+        const char* api;
+        const char* op;
+        std::function<void(uint64_t)> fn;
+    };
+
+    std::string OptionOr(const std::unordered_map<std::string, std::string>& options,
+                         const std::string& key, const std::string& def)
+    {
+        auto it = options.find(key);
+        return (it == options.end()) ? def : it->second;
+    }
+
+    bool ParseLevel(const std::string& name, TracerLevel& level)
+    {
+        if (name == "debug") level = TracerLevel::TRACER_DEBUG_LEVEL;
+        else if (name == "error") level = TracerLevel::TRACER_ERROR_LEVEL;
+        else if (name == "off") level = TracerLevel::TRACER_OFF_LEVEL;
+        else return false;
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto pars = MOW::Application::CLI::Parse(argc, argv);
+    if (!pars.errors.empty() || pars.command != "run")
+    {
+        std::cerr << "usage: toggleRateBench run [--backend=auto|devmem|gpiomem|sim] [--pin=N] [--iterations=N]" << std::endl;
+        std::cerr << "                           [--tracelevel=debug|error|off] [--format=json|table]" << std::endl;
+        for (const auto& e : pars.errors)
+            std::cerr << "  - " << e << std::endl;
+        return 2;
+    }
+
+    eRp1Backend backend = eRp1Backend::Auto;
+    TracerLevel level = TracerLevel::TRACER_DEBUG_LEVEL;
+    if (!RP1Mapping::parseBackend(OptionOr(pars.options, "backend", "auto"), backend) ||
+        !ParseLevel(OptionOr(pars.options, "tracelevel", "debug"), level))
+    {
+        std::cerr << "unknown backend or trace level" << std::endl;
+        return 2;
+    }
+    uint32_t pin = static_cast<uint32_t>(std::stoul(OptionOr(pars.options, "pin", "27")));
+    uint64_t iterations = std::max<uint64_t>(1000, std::stoull(OptionOr(pars.options, "iterations", "1000000")));
+    bool bTable = OptionOr(pars.options, "format", "json") == "table";
+    if (pin >= RP1_BANK_PINS[0])
+    {
+        std::cerr << "--pin must be a bank 0 pin (0.." << RP1_BANK_PINS[0] - 1 << ")" << std::endl;
+        return 2;
+    }
+
+    auto tracer = std::make_shared<CFileTracer>("./", "toggleRateBench.log", level);
+    RP1IO io(tracer, backend);
+    if (io.RIOBase() == nullptr)
+    {
+        std::cerr << "RP1 registers could not be mapped (see toggleRateBench.log)" << std::endl;
+        return 1;
+    }
+
+    const uint32_t mask = 1u << pin;
+    const uint32_t savedCtrl = io.getGpioCntrl(pin);
+    const uint32_t savedPad = io.getPad(pin);
+    const uint32_t savedOE = io.getRioOutputEnable() & mask;
+    io.setFunction(pin, GPIO_FUNC_RIO, savedPad);
+    io.setDirOutMask(mask);
+
+    RP1IO::Fast fast = io.fast(mask);
+    if (!fast.valid())
+    {
+        std::cerr << "could not create the fast handle (see toggleRateBench.log)" << std::endl;
+        return 1;
+    }
+    RP1IO::Pin handle = io.pin(pin);
+    if (!handle.valid())
+    {
+        std::cerr << "could not create the pin handle (see toggleRateBench.log)" << std::endl;
+        return 1;
+    }
+
+    // Each op changes the pin level once
+    std::vector<Variant> variants = {
+        { "traced", "setGpioPin", [&](uint64_t i) { io.setGpioPin(static_cast<int>(pin), i & 1); } },
+        { "traced", "xorGpioMask", [&](uint64_t) { io.xorGpioMask(mask); } },
+        { "fast", "setPin", [&](uint64_t i) { fast.setPin(pin, i & 1); } },
+        { "fast", "toggle", [&](uint64_t) { fast.toggle(mask); } },
+        { "pin", "write", [&](uint64_t i) { handle.write(i & 1); } },
+        { "pin", "toggle", [&](uint64_t) { handle.toggle(); } },
+    };
+
+    if (bTable)
+        std::cout << std::left << std::setw(8) << "api" << std::setw(14) << "op" << std::setw(12) << "ns/op"
+                  << std::setw(14) << "Mtoggle/s" << "speedup" << std::endl;
+
+    double nsBaseline = 0.0;
+    for (const auto& v : variants)
+    {
+        for (uint64_t i = 0; i < 64; ++i)      // warm up
+            v.fn(i);
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            v.fn(i);
+        rp1_mb();
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(iterations);
+        if (nsBaseline == 0.0)
+            nsBaseline = ns;
+        double mtps = (ns > 0.0) ? 1000.0 / ns : 0.0;
+        double speedup = (ns > 0.0) ? nsBaseline / ns : 0.0;
+
+        if (bTable)
+            std::cout << std::left << std::setw(8) << v.api << std::setw(14) << v.op << std::fixed << std::setprecision(2)
+                      << std::setw(12) << ns << std::setw(14) << mtps << speedup << std::endl;
+        else
+            std::cout << std::format("{{\"api\":\"{}\",\"op\":\"{}\",\"backend\":\"{}\",\"iterations\":{},"
+                                     "\"ns_per_op\":{:.2f},\"mtoggle_per_s\":{:.3f},\"speedup\":{:.2f}}}",
+                                     v.api, v.op, RP1Mapping::backendName(backend),
+                                     iterations, ns, mtps, speedup)
+                      << std::endl;
+    }
+
+    fast.clear(mask);
+    if (savedOE == 0)
+        fast.input(mask);
+    io.setFunction(pin, GpioCtrl::FuncSel::decode(savedCtrl), savedPad);
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "Helpers/CLIParameters.h"
+#include "Helpers/RP1Timer.h"
+#include "Helpers/RP1Wait.h"
+#include "Helpers/SBDelay.h"
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// waitBench - detection latency vs. CPU use of the RP1Wait strategies.
+//
+//   waitBench run [--samples=N] [--sleep=ns] [--format=json|table]
+//
+// A second thread sets a bit in a word at a known time (SBDelay::until) and
+// records the generic timer right after the store; the waiting thread uses
+// RP1Wait::waitForBits on the same word. The word is ordinary memory, so the
+// numbers are the cost of the strategy, not of the RP1 bus (add one register
+// read, ~0.3 us on the Pi 5, for that).
+//
+//   latency : match timestamp - store timestamp (mean / p99 / max)
+//   cpu     : CPU time of the waiting thread / wall time of the wait
+//
+// Strategies: spin with yield, spin with wfe, spin then sched_yield, spin
+// then --sleep ns sleeps (the default policy), and 1 ms sleeps without a spin
+// phase, as MeasRC polled before.
+
+using namespace SB::RPI5;
+
+namespace
+{
+    struct Strategy
+    {
+        const char* name;
+        RP1WaitPolicy_t policy;
+    };
+
+    std::string OptionOr(const std::unordered_map<std::string, std::string>& options,
+                         const std::string& key, const std::string& def)
+    {
+        auto it = options.find(key);
+        return (it == options.end()) ? def : it->second;
+    }
+
+    double Percentile(const std::vector<double>& sorted, double p)
+    {
+        size_t idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+
+    uint64_t ThreadCpuNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto pars = MOW::Application::CLI::Parse(argc, argv);
+    if (!pars.errors.empty() || pars.command != "run")
+    {
+        std::cerr << "usage: waitBench run [--samples=N] [--sleep=ns] [--format=json|table]" << std::endl;
+        for (const auto& e : pars.errors)
+            std::cerr << "  - " << e << std::endl;
+        return 2;
+    }
+    size_t samples = std::max<size_t>(10, std::stoull(OptionOr(pars.options, "samples", "200")));
+    uint64_t sleepNs = std::stoull(OptionOr(pars.options, "sleep", "50000"));
+    bool bTable = OptionOr(pars.options, "format", "json") == "table";
+
+    SBDelay::calibrate();
+    const uint64_t spinNs = SBDelay::thresholdNs();
+    std::cerr << std::format("spin phase {} ns (SBDelay threshold)", spinNs) << std::endl;
+
+    std::vector<Strategy> strategies = {
+        { "spin", { RP1_WAIT_FOREVER, eRp1Relax::Yield, eRp1Backoff::None, 0 } },
+        { "spin-wfe", { RP1_WAIT_FOREVER, eRp1Relax::Wfe, eRp1Backoff::None, 0 } },
+        { "spin+yield", { spinNs, eRp1Relax::Yield, eRp1Backoff::Yield, 0 } },
+        { "spin+sleep", { spinNs, eRp1Relax::Yield, eRp1Backoff::Sleep, sleepNs } },
+        { "sleep-1ms", { 0, eRp1Relax::Yield, eRp1Backoff::Sleep, 1000000 } },
+    };
+    const uint64_t waitsNs[] = { 10000, 100000, 1000000, 10000000 };
+    const uint64_t freq = rp1_tick_freq();
+
+    if (bTable)
+        std::cout << std::left << std::setw(10) << "wait us" << std::setw(13) << "strategy" << std::setw(7) << "n"
+                  << std::setw(12) << "mean lat" << std::setw(12) << "p99 lat" << std::setw(12) << "max lat"
+                  << "cpu %" << std::endl;
+
+    for (uint64_t wait : waitsNs)
+    {
+        size_t n = std::clamp<size_t>(static_cast<size_t>(1000000000ull / wait), 10, samples);
+        for (const auto& s : strategies)
+        {
+            std::vector<double> latency;
+            uint64_t cpuNs = 0, wallNs = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                alignas(64) volatile uint32_t word = 0;
+                std::atomic<uint64_t> storeTicks { 0 };
+                const uint64_t target = SBDelay::nowNs() + wait;
+
+                std::thread setter([&]() {
+                    SBDelay::until(target);
+                    word = 1;
+                    storeTicks.store(rp1_ticks(), std::memory_order_release);
+                });
+
+                RP1WaitResult_t result;
+                const uint64_t cpu0 = ThreadCpuNs();
+                const uint64_t wall0 = SBDelay::nowNs();
+                bool bMatched = RP1Wait::waitForBits(&word, 1, 1, wait * 10 + 100000000ull, result, s.policy);
+                cpuNs += ThreadCpuNs() - cpu0;
+                wallNs += SBDelay::nowNs() - wall0;
+                setter.join();
+
+                if (bMatched)
+                {
+                    // The store's timestamp is taken after the store, so the
+                    // waiter can come in first; that counts as 0
+                    uint64_t stored = storeTicks.load(std::memory_order_acquire);
+                    latency.push_back((result.ticks > stored) ? static_cast<double>(rp1_ticks_to_ns(result.ticks - stored, freq)) : 0.0);
+                }
+            }
+            if (latency.empty())
+                latency.push_back(0.0);
+            double mean = 0.0;
+            for (double l : latency) mean += l;
+            mean /= static_cast<double>(latency.size());
+            std::sort(latency.begin(), latency.end());
+            double cpu = (wallNs > 0) ? 100.0 * static_cast<double>(cpuNs) / static_cast<double>(wallNs) : 0.0;
+
+            if (bTable)
+                std::cout << std::left << std::setw(10) << wait / 1000 << std::setw(13) << s.name << std::setw(7) << latency.size()
+                          << std::fixed << std::setprecision(0) << std::setw(12) << mean << std::setw(12) << Percentile(latency, 0.99)
+                          << std::setw(12) << latency.back() << std::setprecision(1) << cpu << std::endl;
+            else
+                std::cout << std::format("{{\"wait_ns\":{},\"strategy\":\"{}\",\"samples\":{},\"mean_lat_ns\":{:.0f},"
+                                         "\"p99_lat_ns\":{:.0f},\"max_lat_ns\":{:.0f},\"cpu_pct\":{:.1f}}}",
+                                         wait, s.name, latency.size(), mean, Percentile(latency, 0.99), latency.back(), cpu)
+                          << std::endl;
+        }
+    }
+    return 0;
+}
@@ -34,6 +34,12 @@ CDhct11::~CDhct11()
     }
 
 }
+int CDhct11::WaitNextEdgeUs(int timeoutus, gpioevent_data* outEv, std::vector<std::string>& errors)
+{
+    if (m_edges)
+        return m_edges->WaitNextEdgeUs(timeoutus, outEv, errors);
+    return m_pio->WaitNextEdgeUs(timeoutus, outEv, errors);
+}
 bool CDhct11::Read(int& temperature, int&humidity, std::vector<std::string>& errors)
 {
     CFuncTracer trace("CDhct11::Read", m_trace);
@@ -53,11 +59,20 @@ bool CDhct11::Read(int& temperature, int&humidity, std::vector<std::string>& err
             return false;
         }
 
-        bok = m_pio->InitEdge(m_pin, (GPIOEVENT_REQUEST_RISING_EDGE | GPIOEVENT_REQUEST_FALLING_EDGE), errors);
-        if (!bok)
+        if (m_edges)
         {
-            errors.emplace_back("Dhct11::Read - InitEdge failed");
-            return false;
+            // Edges of our own start pulse are still queued
+            m_edges->io().input(1u << m_pin);
+            m_edges->discard();
+        }
+        else
+        {
+            bok = m_pio->InitEdge(m_pin, (GPIOEVENT_REQUEST_RISING_EDGE | GPIOEVENT_REQUEST_FALLING_EDGE), errors);
+            if (!bok)
+            {
+                errors.emplace_back("Dhct11::Read - InitEdge failed");
+                return false;
+            }
         }
         
         gpioevent_data ev{};
@@ -66,7 +81,7 @@ bool CDhct11::Read(int& temperature, int&humidity, std::vector<std::string>& err
         int attempts = 3;
         for (; attempts > 0; --attempts)
         {
-            if (m_pio->WaitNextEdgeUs(2000, &ev, errors) < 0)
+            if (WaitNextEdgeUs(2000, &ev, errors) < 0)
                 errors.emplace_back("Dht11: missing first edge");
 
             if (ev.id == GPIOEVENT_EVENT_RISING_EDGE)
@@ -85,7 +100,7 @@ bool CDhct11::Read(int& temperature, int&humidity, std::vector<std::string>& err
         for (int i = 0; i < 40; ++i)
         {
             gpioevent_data fallEv{};
-            edgeTime = m_pio->WaitNextEdgeUs(2000, &fallEv, errors);
+            edgeTime = WaitNextEdgeUs(2000, &fallEv, errors);
             if ( edgeTime < 0 ||
                 fallEv.id != GPIOEVENT_EVENT_FALLING_EDGE)
             {
@@ -101,7 +116,7 @@ bool CDhct11::Read(int& temperature, int&humidity, std::vector<std::string>& err
 
             if (i < 39)
             {
-                edgeTime = m_pio->WaitNextEdgeUs(2000, &riseEv, errors);
+                edgeTime = WaitNextEdgeUs(2000, &riseEv, errors);
                 if (( edgeTime < 0) ||
                     riseEv.id != GPIOEVENT_EVENT_RISING_EDGE)
                 {
@@ -2,6 +2,7 @@
 #include <memory>
 #include "../Tracer/ctracer.h"
 #include "SBPio.h"
+#include "RP1EdgeDetector.h"
 
 namespace SB::RPI5::Sensors
 {
@@ -12,10 +13,16 @@ namespace SB::RPI5::Sensors
             virtual ~CDhct11();
 
             bool Read(int& temperature, int&humidity, std::vector<std::string>& errors);
+            // Take the edges from a started RIO edge detector watching the
+            // pin instead of from kernel GPIO events
+            void UseEdgeDetector(std::shared_ptr<RP1EdgeDetector> edges) { m_edges = edges; }
 
         private:
+            int WaitNextEdgeUs(int timeoutus, gpioevent_data* outEv, std::vector<std::string>& errors);
+
             std::shared_ptr<CTracer> m_trace;
             std::unique_ptr<SBPio>   m_pio;
+            std::shared_ptr<RP1EdgeDetector> m_edges;
             int m_pin;
     };
 }
\ No newline at end of file
@@ -1,19 +1,17 @@
 #include "RP1Base.h"
-#include <sys/mman.h>
-#include <fcntl.h>
-#include <errno.h>
-#include <unistd.h>
+#include "RP1Fields.h"
+#include "RP1Pins.h"
 #include <stdint.h>
 
 namespace SB::RPI5
 {
-    RP1Base::RP1Base(std::shared_ptr<CTracer> tracer)
+    RP1Base::RP1Base(std::shared_ptr<CTracer> tracer, eRp1Backend backend)
     : m_trace(tracer)
     {
         CFuncTracer trace("RP1Base::RP1Base", m_trace);
         try
         {
-            bool bOk = initialize();
+            bool bOk = initialize(backend);
             if (!bOk)
                 trace.Error("initialize failed");
         }
@@ -34,7 +32,6 @@ namespace SB::RPI5
         }
     }
 
-    uint32_t *RP1Base::PERIBase(){ return m_PERIBase;}
     RP1_GPIO_Regs_t *RP1Base::GPIOBase(){ return (RP1_GPIO_Regs_t*)m_GPIOBase;}
     uint32_t *RP1Base::RIOBase(){ return m_RIOBase;}
     uint32_t *RP1Base::PADBase(){ return m_PADBase;}
@@ -42,61 +39,29 @@ namespace SB::RPI5
     uint32_t *RP1Base::PWMBase(int pwmBase){ return (pwmBase == 0)? m_PWMBase0: m_PWMBase1;}
     uint32_t *RP1Base::PWMClockBase(){ return m_PWMClockBase;}
 
-    bool RP1Base::initialize()
+    bool RP1Base::initialize(eRp1Backend backend)
     {
         CFuncTracer trace("RP1Base::initialize", m_trace);
         try
         {
-            constexpr off_t RP1_BAR0_BASE = 0x1f00000000ULL;
-            constexpr size_t RP1_BAR0_SIZE = 0x00400000; // 4 MB
-
-            int memfd = open("/dev/mem", O_RDWR | O_SYNC);
-            uint32_t* map = (uint32_t*)mmap(
-                nullptr,
-                RP1_BAR0_SIZE,
-                (PROT_READ | PROT_WRITE),
-                MAP_SHARED,
-                memfd, 
-                RP1_BAR0_BASE); 
-            close(memfd);
-            m_PERIBase = map;
-            if (map == MAP_FAILED)
+            // The mapping is shared by every RP1 helper in the process; only the
+            // first one pays for open/mmap.
+            m_mapping = RP1Mapping::acquire(m_trace, backend);
+            if (!m_mapping || !m_mapping->isValid())
             {
-                trace.Info("opens gpiomem0 as fallback");
-                int memfd = open("/dev/gpiomem0", O_RDWR, O_SYNC);
-                uint32_t *map = (uint32_t *) mmap(
-                    nullptr,
-                    576 * 1024,
-                    (PROT_READ | PROT_WRITE),
-                    MAP_SHARED, 
-                    memfd,
-                    0x0);
-                close(memfd);
-                if (map == MAP_FAILED)
-                {
-                    trace.Error("mmap failed : %s", strerror(errno));
-                    return false;
-                }
-                m_PERIBase = map - 0xD0000 / 4;
+                trace.Error("RP1 mapping is not available");
+                return false;
             }
 
-            m_GPIOBase = m_PERIBase + 0xD0000 / 4;
-            m_RIOBase = m_PERIBase + 0xe0000 / 4;
-            m_PADBase = m_PERIBase + 0xf0000 / 4;
-            m_pad = m_PADBase + 1; // PADBase + 0 = Voltage select register
-            m_PWMBase0 = m_PERIBase + 0x98000 / 4;  // change 98000 to 9C000
-            m_PWMBase1 = m_PERIBase + 0x9c000 / 4;
-            m_PWMClockBase = m_PERIBase + 0x18000 / 4;
-
+            m_GPIOBase = m_mapping->window(eRp1Window::Gpio);
+            m_RIOBase = m_mapping->window(eRp1Window::Rio);
+            m_PADBase = m_mapping->window(eRp1Window::Pad);
+            m_pad = (m_PADBase)? m_PADBase + 1 : nullptr; // PADBase + 0 = Voltage select register
+            m_PWMBase0 = m_mapping->window(eRp1Window::Pwm0);
+            m_PWMBase1 = m_mapping->window(eRp1Window::Pwm1);
+            m_PWMClockBase = m_mapping->window(eRp1Window::Clocks);
 
-            trace.Info("PERIBase : %p", m_PERIBase);
-            trace.Info("GPIO_BASE : %p", m_GPIOBase);
-            trace.Info("RIO_BASE : %p", m_RIOBase);
-            trace.Info("PAD_BASE : %p", m_PADBase);
-            trace.Info("PAD : %p", m_pad);
-            trace.Info("PWM_BASE0 : %p", m_PWMBase0);
-            trace.Info("PWM_BASE1 : %p", m_PWMBase1);
-            trace.Info("PWM_CLOCK_BASE : %p", m_PWMClockBase);
+            trace.Info("RP1 mapping : %s (%s)", m_mapping->deviceName(), RP1Mapping::backendName(m_mapping->backend()));
             return true;
         }
         catch(const std::exception& e)
@@ -110,17 +75,33 @@ namespace SB::RPI5
         CFuncTracer trace("RP1PWM::setFunction", m_trace);
         try
         {
-            RP1_GPIO_Regs_t* GPIO = (RP1_GPIO_Regs_t*)m_GPIOBase;
-            if (GPIO == nullptr)
+            if ((m_GPIOBase == nullptr) || (m_pad == nullptr))
             {
                 trace.Error("PWM is not correctly initialized");
                 return false;
             }
-            m_pad[pin] = pad;
+            uint32_t bank = 0, index = 0;
+            if (!rp1_pin_location(pin, bank, index))
+            {
+                trace.Error("GPIO%u is not an RP1 pin", pin);
+                return false;
+            }
+            // Banks 1 and 2 sit one block (0x4000) further each, in GPIO and PAD alike
+            const size_t block = bank * (RP1_BLOCK_SIZE / 4);
+            if ((pad & ~PAD_MASK) != 0)
+            {
+                trace.Error("pad value 0x%08x has bits outside the PAD register", pad);
+                return false;
+            }
+            Pad::Reg::write(m_pad + block, index, pad);
 
-            uint32_t v = GPIO[pin].ctrl;
-            v = (v & ~CTRL_FUNCSEL_MASK) | (func & CTRL_FUNCSEL_MASK);
-            GPIO[pin].ctrl = v;
+            // Write-only via the SET/CLR aliases: first FUNCSEL = NULL (all ones),
+            // then clear down to 'func', so the pin never routes to a third function.
+            volatile uint32_t *ctrl = GpioCtrl::Reg::at(m_GPIOBase + block, index);
+            uint32_t clear = GpioCtrl::FuncSel::mask & ~GpioCtrl::FuncSel::encode(func);
+            rp1_set_bits(ctrl, GpioCtrl::FuncSel::mask);
+            if (clear != 0)
+                rp1_clr_bits(ctrl, clear);
 
             return true;
         }
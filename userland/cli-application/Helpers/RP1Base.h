@@ -1,25 +1,31 @@
 #pragma once
 #include <memory>
 #include "../Tracer/cfunctracer.h"
+#include "RP1Fields.h"
+#include "RP1Mapping.h"
 
 namespace SB::RPI5
 {
     constexpr uint32_t CTRL_FUNCSEL_MASK = 0x1Fu; // bits 0..4
 
+    // PAD register values for setFunction(), or'ed together; bit positions
+    // come from the Pad:: descriptors. Output is enabled while OD is clear.
     constexpr uint32_t PULL_NONE = 0x00;
-    constexpr uint32_t PULL_UP = 0x01;
-    constexpr uint32_t PULL_DOWN = 0x02;
+    constexpr uint32_t PULL_UP = Pad::PullUp::mask;
+    constexpr uint32_t PULL_DOWN = Pad::PullDown::mask;
 
-    constexpr uint32_t INPUT_ENABLE = (1u << 3);
-    constexpr uint32_t OUTPUT_ENABLE = (1u << 4);
+    constexpr uint32_t INPUT_ENABLE = Pad::InputEnable::mask;
+    constexpr uint32_t OUTPUT_ENABLE = 0;
+    constexpr uint32_t OUTPUT_DISABLE = Pad::OutputDisable::mask;
 
-    constexpr uint32_t DRIVE_2mA = (0u << 5);
-    constexpr uint32_t DRIVE_4mA = (1u << 5);
-    constexpr uint32_t DRIVE_8mA = (2u << 5);
-    constexpr uint32_t DRIVE_12mA = (3u << 5);
+    constexpr uint32_t DRIVE_2mA = Pad::Drive::encode(0);
+    constexpr uint32_t DRIVE_4mA = Pad::Drive::encode(1);
+    constexpr uint32_t DRIVE_8mA = Pad::Drive::encode(2);
+    constexpr uint32_t DRIVE_12mA = Pad::Drive::encode(3);
 
-    constexpr uint32_t SLEW_FAST = (1u << 7);
+    constexpr uint32_t SLEW_FAST = Pad::SlewFast::mask;
     constexpr uint32_t SLEW_SLOW = 0;
+    constexpr uint32_t PAD_MASK = 0xFFu;
 
     enum gpio_function_rp1: uint32_t
     {
@@ -40,10 +46,9 @@ namespace SB::RPI5
     class RP1Base
     {
         public:
-            RP1Base(std::shared_ptr<CTracer> m_trace);
+            RP1Base(std::shared_ptr<CTracer> m_trace, eRp1Backend backend = eRp1Backend::Auto);
             virtual ~RP1Base();
 
-            uint32_t *PERIBase();
             RP1_GPIO_Regs_t *GPIOBase();
             uint32_t *RIOBase();
             uint32_t *PADBase();
@@ -56,8 +61,10 @@ namespace SB::RPI5
         protected:
             std::shared_ptr<CTracer> m_trace;
 
+            const RP1Mapping* mapping() const { return m_mapping.get(); }
+
         private:
-            uint32_t *m_PERIBase = nullptr;
+            std::shared_ptr<RP1Mapping> m_mapping;
             uint32_t *m_GPIOBase = nullptr;
             uint32_t *m_RIOBase = nullptr;
             uint32_t *m_PADBase = nullptr;
@@ -67,6 +74,6 @@ namespace SB::RPI5
             uint32_t *m_PWMClockBase = nullptr;
             uint32_t *m_PWMRegs = nullptr;
             
-            bool initialize();
+            bool initialize(eRp1Backend backend);
     };
 }
\ No newline at end of file
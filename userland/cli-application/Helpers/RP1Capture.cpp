@@ -0,0 +1,306 @@
+#include "RP1Capture.h"
+#include "RP1Timer.h"
+#include "../Tracer/cfunctracer.h"
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+
+namespace SB::RPI5
+{
+    RP1Capture::RP1Capture(std::shared_ptr<CTracer> tracer)
+        : m_trace(tracer)
+    {
+        CFuncTracer trace("RP1Capture::RP1Capture", m_trace);
+        m_freq = rp1_tick_freq();
+    }
+    RP1Capture::~RP1Capture()
+    {
+        CFuncTracer trace("RP1Capture::~RP1Capture", m_trace);
+        unlock();
+    }
+
+    void RP1Capture::unlock()
+    {
+        if (m_bLocked)
+        {
+            munlock(m_values.data(), m_values.size() * sizeof(uint32_t));
+            munlock(m_ticks.data(), m_ticks.size() * sizeof(uint64_t));
+            m_bLocked = false;
+        }
+    }
+
+    bool RP1Capture::prepare(const RP1CaptureConfig_t& config)
+    {
+        CFuncTracer trace("RP1Capture::prepare", m_trace);
+        try
+        {
+            if ((config.mask == 0) || (config.postSamples == 0))
+            {
+                trace.Error("nothing to capture (mask 0x%08x, post %ld)", config.mask, config.postSamples);
+                return false;
+            }
+            if ((config.mask >> RP1_BANK_PINS[0]) != 0)
+            {
+                trace.Error("mask 0x%08x has pins outside bank 0", config.mask);
+                return false;
+            }
+            m_config = config;
+            // assign() writes every element, so the pages are faulted in here
+            // and not in the sampling loop; mlock keeps them resident for every
+            // run, with or without -rt (which would mlockall)
+            unlock();
+            m_values.assign(config.preSamples + config.postSamples, 0);
+            m_ticks.assign(config.preSamples + config.postSamples, 0);
+            m_bLocked = (mlock(m_values.data(), m_values.size() * sizeof(uint32_t)) == 0);
+            if (m_bLocked && (mlock(m_ticks.data(), m_ticks.size() * sizeof(uint64_t)) != 0))
+            {
+                munlock(m_values.data(), m_values.size() * sizeof(uint32_t));
+                m_bLocked = false;
+            }
+            if (!m_bLocked)
+                trace.Warning("capture buffers not locked: %s (needs CAP_IPC_LOCK or RLIMIT_MEMLOCK)", strerror(errno));
+            m_first = m_count = m_trigger = 0;
+            m_bTriggered = false;
+            trace.Trace("mask 0x%08x, pre %ld, post %ld, %s", config.mask, config.preSamples, config.postSamples,
+                        config.useInSync ? "InSync" : "In");
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    template <bool Sync>
+    bool RP1Capture::sample(const RP1IO::Fast& io)
+    {
+        // Every trigger is (in & patMask) == patValue, and for the edge types
+        // also a change on edgeMask. eNone matches the first sample.
+        uint32_t edgeMask = 0, patMask = 0, patValue = 0;
+        const uint32_t pinBit = 1u << m_config.trigger.pin;
+        switch (m_config.trigger.type)
+        {
+            case eRp1TriggerType::eRising:  edgeMask = patMask = patValue = pinBit; break;
+            case eRp1TriggerType::eFalling: edgeMask = patMask = pinBit; break;
+            case eRp1TriggerType::eEdge:    edgeMask = pinBit; break;
+            case eRp1TriggerType::ePattern: patMask = m_config.trigger.mask; patValue = m_config.trigger.value & patMask; break;
+            default: break;
+        }
+
+        uint32_t *values = m_values.data();
+        uint64_t *ticks = m_ticks.data();
+        const size_t n = m_values.size();
+        const uint64_t timeout = m_config.timeoutNs ? rp1_ns_to_ticks(m_config.timeoutNs, m_freq) : UINT64_MAX;
+
+        size_t idx = 0;
+        size_t taken = 0;
+        const uint64_t start = rp1_ticks();
+        uint32_t prev = Sync ? io.readSync() : io.read();
+        for (;;)
+        {
+            uint32_t v = Sync ? io.readSync() : io.read();
+            uint64_t t = rp1_ticks();
+            values[idx] = v;
+            ticks[idx] = t;
+            ++taken;
+            if (((v & patMask) == patValue) && ((edgeMask == 0) || ((v ^ prev) & edgeMask)))
+                break;
+            prev = v;
+            if (++idx == n)
+                idx = 0;
+            if (t - start > timeout) [[unlikely]]
+                return false;
+        }
+
+        m_trigger = idx;
+        for (size_t k = 1; k < m_config.postSamples; ++k)
+        {
+            if (++idx == n)
+                idx = 0;
+            values[idx] = Sync ? io.readSync() : io.read();
+            ticks[idx] = rp1_ticks();
+        }
+
+        const size_t pre = std::min(m_config.preSamples, taken - 1);
+        m_first = (m_trigger + n - pre) % n;
+        m_count = pre + m_config.postSamples;
+        return true;
+    }
+
+    bool RP1Capture::run(const RP1IO::Fast& io)
+    {
+        CFuncTracer trace("RP1Capture::run", m_trace);
+        if (!io.valid() || m_values.empty())
+        {
+            trace.Error("invalid RIO handle or capture not prepared");
+            return false;
+        }
+        m_bTriggered = m_config.useInSync ? sample<true>(io) : sample<false>(io);
+        if (!m_bTriggered)
+        {
+            trace.Error("no trigger within %llu ns", static_cast<unsigned long long>(m_config.timeoutNs));
+            m_count = 0;
+        }
+        return m_bTriggered;
+    }
+
+    int64_t RP1Capture::offsetNs(size_t i) const
+    {
+        uint64_t t = m_ticks[(m_first + i) % m_ticks.size()];
+        uint64_t trig = m_ticks[m_trigger];
+        return (t >= trig) ? static_cast<int64_t>(rp1_ticks_to_ns(t - trig, m_freq))
+                           : -static_cast<int64_t>(rp1_ticks_to_ns(trig - t, m_freq));
+    }
+
+    RP1CaptureStats_t RP1Capture::stats() const
+    {
+        RP1CaptureStats_t st = {};
+        st.triggered = m_bTriggered;
+        st.samples = m_count;
+        if (m_count < 2)
+            return st;
+        st.triggerIndex = (m_trigger + m_values.size() - m_first) % m_values.size();
+
+        std::vector<uint64_t> intervals(m_count - 1);
+        for (size_t i = 1; i < m_count; ++i)
+            intervals[i - 1] = static_cast<uint64_t>(offsetNs(i) - offsetNs(i - 1));
+        st.durationNs = static_cast<uint64_t>(offsetNs(m_count - 1) - offsetNs(0));
+        st.sampleRateHz = st.durationNs ? (static_cast<double>(m_count - 1) * 1e9 / static_cast<double>(st.durationNs)) : 0.0;
+
+        std::vector<uint64_t> sorted = intervals;
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        st.medianIntervalNs = sorted[sorted.size() / 2];
+        st.minIntervalNs = *std::min_element(intervals.begin(), intervals.end());
+        st.maxIntervalNs = *std::max_element(intervals.begin(), intervals.end());
+        const uint64_t gapLimit = std::max<uint64_t>(st.medianIntervalNs * 4, 1);
+        for (uint64_t d : intervals)
+        {
+            if (d > gapLimit)
+            {
+                ++st.gaps;
+                st.gapNs += d - st.medianIntervalNs;
+            }
+        }
+        return st;
+    }
+
+    std::string RP1Capture::formatStats() const
+    {
+        auto st = stats();
+        if (!st.triggered)
+            return "capture: not triggered\n";
+        return std::format("capture: {} samples ({} before trigger) in {:.1f} us, {:.2f} MS/s, "
+                           "interval min/median/max {}/{}/{} ns, {} gaps ({} ns lost)\n",
+                           st.samples, st.triggerIndex, st.durationNs / 1000.0, st.sampleRateHz / 1e6,
+                           st.minIntervalNs, st.medianIntervalNs, st.maxIntervalNs, st.gaps, st.gapNs);
+    }
+
+    // Value change dump, 1 ns timescale, time 0 = first sample; one wire per
+    // pin of the mask plus a 'trigger' marker.
+    bool RP1Capture::writeVcd(const std::string& path) const
+    {
+        CFuncTracer trace("RP1Capture::writeVcd", m_trace);
+        try
+        {
+            if (m_count == 0)
+            {
+                trace.Error("nothing captured");
+                return false;
+            }
+            std::ofstream out(path);
+            if (!out.is_open())
+            {
+                trace.Error("cannot open %s", path.c_str());
+                return false;
+            }
+
+            std::vector<uint32_t> pins;
+            for (uint32_t pin = 0; pin < 32; ++pin)
+                if (m_config.mask & (1u << pin))
+                    pins.push_back(pin);
+            auto id = [](size_t n) { return std::string(1, static_cast<char>('!' + n)); };
+
+            out << "$comment RP1 RIO " << (m_config.useInSync ? "InSync" : "In") << " capture $end\n";
+            out << "$timescale 1ns $end\n";
+            out << "$scope module rp1 $end\n";
+            for (size_t i = 0; i < pins.size(); ++i)
+                out << "$var wire 1 " << id(i) << " GPIO" << pins[i] << " $end\n";
+            out << "$var wire 1 " << id(pins.size()) << " trigger $end\n";
+            out << "$upscope $end\n$enddefinitions $end\n";
+
+            const int64_t t0 = offsetNs(0);
+            const size_t trig = stats().triggerIndex;
+            uint32_t last = ~value(0);
+            for (size_t s = 0; s < m_count; ++s)
+            {
+                uint32_t v = value(s);
+                uint32_t changed = (v ^ last) & m_config.mask;
+                if ((changed == 0) && (s != trig) && (s != trig + 1))
+                    continue;
+                out << "#" << (offsetNs(s) - t0) << "\n";
+                for (size_t i = 0; i < pins.size(); ++i)
+                    if (changed & (1u << pins[i]))
+                        out << ((v >> pins[i]) & 1u) << id(i) << "\n";
+                if (s == 0 && trig != 0)
+                    out << "0" << id(pins.size()) << "\n";
+                if (s == trig)
+                    out << "1" << id(pins.size()) << "\n";
+                else if (s == trig + 1)
+                    out << "0" << id(pins.size()) << "\n";
+                last = v;
+            }
+            out << "#" << (offsetNs(m_count - 1) - t0) << "\n";
+            trace.Info("%ld samples written to %s", m_count, path.c_str());
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    // none | rising:<pin> | falling:<pin> | edge:<pin> | pattern:<mask>:<value>
+    bool RP1Capture::parseTrigger(const std::string& text, RP1Trigger_t& trigger)
+    {
+        trigger = { eRp1TriggerType::eNone, 0, 0, 0 };
+        std::vector<std::string> parts;
+        std::stringstream ss(text);
+        std::string part;
+        while (std::getline(ss, part, ':'))
+            parts.push_back(part);
+        if (parts.empty())
+            return false;
+        try
+        {
+            if (parts[0] == "none")
+                return parts.size() == 1;
+            if (parts[0] == "pattern" && parts.size() == 3)
+            {
+                trigger.type = eRp1TriggerType::ePattern;
+                trigger.mask = static_cast<uint32_t>(std::stoul(parts[1], nullptr, 0));
+                trigger.value = static_cast<uint32_t>(std::stoul(parts[2], nullptr, 0));
+                return true;
+            }
+            if (parts.size() != 2)
+                return false;
+            trigger.pin = static_cast<uint32_t>(std::stoul(parts[1]));
+            if (trigger.pin >= RP1_BANK_PINS[0])
+                return false;
+            if (parts[0] == "rising") trigger.type = eRp1TriggerType::eRising;
+            else if (parts[0] == "falling") trigger.type = eRp1TriggerType::eFalling;
+            else if (parts[0] == "edge") trigger.type = eRp1TriggerType::eEdge;
+            else return false;
+            return true;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../Tracer/ctracer.h"
+#include "SBRp1IO.h"
+
+namespace SB::RPI5
+{
+    enum class eRp1TriggerType
+    {
+        eNone,          // start right away
+        eRising,        // pin goes 0 -> 1
+        eFalling,       // pin goes 1 -> 0
+        eEdge,          // pin changes
+        ePattern        // (in & mask) == value
+    };
+
+    typedef struct
+    {
+        eRp1TriggerType type;
+        uint32_t pin;
+        uint32_t mask;
+        uint32_t value;
+    } RP1Trigger_t;
+
+    typedef struct
+    {
+        uint32_t mask;          // bank 0 pins that are sampled (and exported)
+        bool useInSync;         // sample RIO InSync (2 flop synchronised) instead of In
+        size_t preSamples;      // kept from before the trigger
+        size_t postSamples;     // taken from the trigger on
+        RP1Trigger_t trigger;
+        uint64_t timeoutNs;     // waiting for the trigger; 0 = no timeout
+    } RP1CaptureConfig_t;
+
+    typedef struct
+    {
+        bool triggered;
+        size_t samples;
+        size_t triggerIndex;    // index of the trigger sample in the captured window
+        uint64_t durationNs;
+        double sampleRateHz;
+        uint64_t minIntervalNs;
+        uint64_t medianIntervalNs;
+        uint64_t maxIntervalNs;
+        size_t gaps;            // intervals above 4 x the median (preemption, interrupts)
+        uint64_t gapNs;         // time lost in those gaps
+    } RP1CaptureStats_t;
+
+    // Logic analyser on RIO bank 0. The sample buffers are allocated, written
+    // once and locked by prepare(), so run() is only the sampling loop: read In
+    // or InSync, stamp it with the generic timer, evaluate the trigger. Before the
+    // trigger the buffer is a ring of preSamples + postSamples; after it another
+    // postSamples are taken and the window around the trigger is kept.
+    class RP1Capture
+    {
+        public:
+            RP1Capture(std::shared_ptr<CTracer> tracer);
+            virtual ~RP1Capture();
+
+            bool prepare(const RP1CaptureConfig_t& config);
+            bool run(const RP1IO::Fast& io);
+
+            size_t size() const { return m_count; }
+            uint32_t value(size_t i) const { return m_values[(m_first + i) % m_values.size()]; }
+            int64_t offsetNs(size_t i) const;     // time relative to the trigger sample
+
+            RP1CaptureStats_t stats() const;
+            std::string formatStats() const;
+            bool writeVcd(const std::string& path) const;
+
+            static bool parseTrigger(const std::string& text, RP1Trigger_t& trigger);
+
+        private:
+            template <bool Sync>
+            bool sample(const RP1IO::Fast& io);
+            void unlock();
+
+            std::shared_ptr<CTracer> m_trace;
+            RP1CaptureConfig_t m_config = {};
+            std::vector<uint32_t> m_values;
+            std::vector<uint64_t> m_ticks;
+            size_t m_first = 0;         // ring index of the first kept sample
+            size_t m_count = 0;
+            size_t m_trigger = 0;       // ring index of the trigger sample
+            bool m_bTriggered = false;
+            bool m_bLocked = false;     // m_values and m_ticks are mlock'ed
+            uint64_t m_freq = 0;
+    };
+}
@@ -0,0 +1,229 @@
+#include "RP1Clock.h"
+#include "RP1Timer.h"
+#include "SBDelay.h"
+#include "../Tracer/cfunctracer.h"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <map>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        constexpr size_t MAX_LATE_SAMPLES = 1u << 20;  // edges kept for the percentiles
+        constexpr uint32_t CALIBRATION_LOOPS = 2000;
+
+        double Frac(double v)
+        {
+            return v - std::floor(v);
+        }
+    }
+
+    RP1Clock::RP1Clock(std::shared_ptr<CTracer> tracer)
+        : m_trace(tracer)
+    {
+        CFuncTracer trace("RP1Clock::RP1Clock", m_trace);
+        m_freq = rp1_tick_freq();
+    }
+    RP1Clock::~RP1Clock()
+    {
+        CFuncTracer trace("RP1Clock::~RP1Clock", m_trace);
+    }
+
+    bool RP1Clock::prepare(const RP1ClockConfig_t& config)
+    {
+        CFuncTracer trace("RP1Clock::prepare", m_trace);
+        try
+        {
+            if ((config.frequencyHz <= 0.0) || (config.duty <= 0.0) || (config.duty >= 1.0) ||
+                config.pins.empty() || (config.durationNs == 0))
+            {
+                trace.Error("invalid clock (%f Hz, duty %f, %ld pins, %llu ns)", config.frequencyHz, config.duty,
+                            config.pins.size(), static_cast<unsigned long long>(config.durationNs));
+                return false;
+            }
+            const long double periodTicks = static_cast<long double>(m_freq) / config.frequencyHz;
+            if (periodTicks >= 2147483648.0L)
+            {
+                trace.Error("%f Hz is below the lowest frequency of the timer (%llu Hz / 2^31)", config.frequencyHz,
+                            static_cast<unsigned long long>(m_freq));
+                return false;
+            }
+            m_config = config;
+            m_periodQ = static_cast<uint64_t>(periodTicks * 4294967296.0L);
+            m_periods = std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(config.durationNs * 1e-9 * config.frequencyHz)));
+
+            // Rising edge at the phase, falling edge duty later; edges of
+            // different pins at the same tick share one SET / CLR write
+            std::map<uint64_t, std::pair<uint32_t, uint32_t>> edges;
+            m_mask = m_initial = 0;
+            for (const auto& p : config.pins)
+            {
+                if ((p.pin >= RP1_BANK_PINS[0]) || (m_mask & (1u << p.pin)))
+                {
+                    trace.Error("GPIO%u is outside bank 0 or used twice", p.pin);
+                    return false;
+                }
+                const uint32_t bit = 1u << p.pin;
+                const double rise = Frac(p.phaseDeg / 360.0);
+                const double fall = Frac(rise + config.duty);
+                edges[static_cast<uint64_t>(rise * m_periodQ)].first |= bit;
+                edges[static_cast<uint64_t>(fall * m_periodQ)].second |= bit;
+                if (fall < rise)
+                    m_initial |= bit;           // high across the period boundary
+                m_mask |= bit;
+            }
+            m_events.clear();
+            for (const auto& [offset, bits] : edges)
+                m_events.push_back({ offset, bits.first, bits.second });
+
+            m_minGap = 1.0;
+            for (size_t i = 0; i < m_events.size(); ++i)
+            {
+                uint64_t next = (i + 1 < m_events.size()) ? m_events[i + 1].offsetQ : m_events[0].offsetQ + m_periodQ;
+                m_minGap = std::min(m_minGap, static_cast<double>(next - m_events[i].offsetQ) / static_cast<double>(m_periodQ));
+            }
+
+            m_late.assign(std::min<uint64_t>(m_periods * m_events.size(), MAX_LATE_SAMPLES), 0);
+            // Calibrates the delay threshold on first use, outside run()
+            m_sleepTicks = rp1_ns_to_ticks(SBDelay::thresholdNs(), m_freq) * 2;
+            m_bRan = false;
+            trace.Trace("%f Hz, duty %f, %ld pins, %llu periods, %ld edges per period", config.frequencyHz, config.duty,
+                        config.pins.size(), static_cast<unsigned long long>(m_periods), m_events.size());
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    // One paced edge: read the timer, SET and CLR write, read the timer. The
+    // writes carry no bits, so the pins do not move.
+    uint64_t RP1Clock::calibrate(const RP1IO::Fast& io)
+    {
+        const uint64_t t0 = rp1_ticks();
+        for (uint32_t i = 0; i < CALIBRATION_LOOPS; ++i)
+        {
+            rp1_spin_until(rp1_ticks());
+            io.set(0);
+            io.clear(0);
+            (void)rp1_ticks();
+        }
+        return std::max<uint64_t>(1, (rp1_ticks() - t0 + CALIBRATION_LOOPS - 1) / CALIBRATION_LOOPS);
+    }
+
+    bool RP1Clock::run(const RP1IO::Fast& io)
+    {
+        CFuncTracer trace("RP1Clock::run", m_trace);
+        if (!io.valid() || m_events.empty())
+        {
+            trace.Error("invalid RIO handle or clock not prepared");
+            return false;
+        }
+        m_loopTicks = calibrate(io);
+        m_bLimited = m_config.frequencyHz > static_cast<double>(m_freq) * m_minGap / static_cast<double>(m_loopTicks);
+        m_lateCount = 0;
+        m_lateSum = m_lateSumSq = 0.0;
+        m_lateMax = 0;
+
+        const Event *ev = m_events.data();
+        const size_t n = m_events.size();
+        uint32_t *late = m_late.data();
+        const size_t lateSize = m_late.size();
+        const uint64_t sleepTicks = m_sleepTicks;
+        const bool bPaced = !m_bLimited;
+
+        io.write(m_mask, m_initial);
+        unsigned __int128 baseQ = 0;
+        const uint64_t start = rp1_ticks() + 4 * m_loopTicks;
+        for (uint64_t k = 0; k < m_periods; ++k, baseQ += m_periodQ)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                const uint64_t deadline = start + static_cast<uint64_t>((baseQ + ev[i].offsetQ) >> 32);
+                if (bPaced)
+                {
+                    const uint64_t now = rp1_ticks();
+                    if (deadline > now + sleepTicks)
+                        SBDelay::sleepBefore(SBDelay::nowNs() + rp1_ticks_to_ns(deadline - now, m_freq));
+                    rp1_spin_until(deadline);
+                }
+                if (ev[i].set)
+                    io.set(ev[i].set);
+                if (ev[i].clr)
+                    io.clear(ev[i].clr);
+                const uint64_t t = rp1_ticks();
+                if (i == 0)
+                {
+                    if (k == 0)
+                        m_firstIssue = t;
+                    m_lastIssue = t;
+                }
+                if (bPaced)
+                {
+                    const uint64_t d = (t > deadline) ? t - deadline : 0;
+                    if (m_lateCount < lateSize)
+                        late[m_lateCount] = static_cast<uint32_t>(std::min<uint64_t>(d, UINT32_MAX));
+                    ++m_lateCount;
+                    m_lateSum += static_cast<double>(d);
+                    m_lateSumSq += static_cast<double>(d) * static_cast<double>(d);
+                    m_lateMax = std::max(m_lateMax, d);
+                }
+            }
+        }
+        m_runTicks = rp1_ticks() - start;
+        io.clear(m_mask);
+        m_edges = m_periods * n;
+        m_bRan = true;
+        return true;
+    }
+
+    RP1ClockStats_t RP1Clock::stats() const
+    {
+        RP1ClockStats_t st = {};
+        const double nsPerTick = 1e9 / static_cast<double>(m_freq);
+        st.targetHz = m_config.frequencyHz;
+        st.maxHz = m_loopTicks ? static_cast<double>(m_freq) * m_minGap / static_cast<double>(m_loopTicks) : 0.0;
+        st.limited = m_bLimited;
+        st.resolutionNs = std::max<uint64_t>(1, rp1_ticks_to_ns(1, m_freq));
+        if (!m_bRan)
+            return st;
+        st.periods = m_periods;
+        st.edges = m_edges;
+        st.runNs = rp1_ticks_to_ns(m_runTicks, m_freq);
+        st.achievedHz = ((m_periods > 1) && (m_lastIssue > m_firstIssue))
+                        ? static_cast<double>(m_periods - 1) * static_cast<double>(m_freq) / static_cast<double>(m_lastIssue - m_firstIssue)
+                        : m_config.frequencyHz;
+        if (m_lateCount > 0)
+        {
+            const double mean = m_lateSum / static_cast<double>(m_lateCount);
+            st.meanLateNs = mean * nsPerTick;
+            st.rmsJitterNs = std::sqrt(std::max(0.0, m_lateSumSq / static_cast<double>(m_lateCount) - mean * mean)) * nsPerTick;
+            st.maxLateNs = rp1_ticks_to_ns(m_lateMax, m_freq);
+
+            std::vector<uint32_t> sorted(m_late.begin(), m_late.begin() + std::min(m_lateCount, m_late.size()));
+            std::sort(sorted.begin(), sorted.end());
+            st.p50LateNs = rp1_ticks_to_ns(sorted[sorted.size() / 2], m_freq);
+            st.p99LateNs = rp1_ticks_to_ns(sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)], m_freq);
+        }
+        return st;
+    }
+
+    std::string RP1Clock::formatStats() const
+    {
+        auto st = stats();
+        std::string text = std::format("clock: target {:.3f} Hz, achieved {:.3f} Hz ({:+.1f} ppm), {} periods, {} edges in {:.3f} ms\n",
+                                       st.targetHz, st.achievedHz, (st.achievedHz / st.targetHz - 1.0) * 1e6,
+                                       st.periods, st.edges, st.runNs / 1e6);
+        if (st.limited)
+            text += std::format("  target above the calibrated limit of {:.0f} Hz: edges issued back to back, no pacing\n", st.maxHz);
+        else
+            text += std::format("  edge lateness mean {:.0f} ns, p50 {} ns, p99 {} ns, max {} ns, jitter (rms) {:.1f} ns, "
+                                "timer tick {} ns, limit {:.0f} Hz\n",
+                                st.meanLateNs, st.p50LateNs, st.p99LateNs, st.maxLateNs, st.rmsJitterNs, st.resolutionNs, st.maxHz);
+        return text;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../Tracer/ctracer.h"
+#include "SBRp1IO.h"
+
+namespace SB::RPI5
+{
+    typedef struct
+    {
+        uint32_t pin;           // bank 0 RIO pin
+        double phaseDeg;        // rising edge at phaseDeg / 360 of the period
+    } RP1ClockPin_t;
+
+    typedef struct
+    {
+        double frequencyHz;
+        double duty;            // high time / period, 0 < duty < 1, same for all pins
+        std::vector<RP1ClockPin_t> pins;
+        uint64_t durationNs;
+    } RP1ClockConfig_t;
+
+    typedef struct
+    {
+        double targetHz;
+        double achievedHz;      // from the first and last edge that was issued
+        double maxHz;           // fastest clock the calibrated loop can pace
+        bool limited;           // target above maxHz: edges were issued back to back
+        uint64_t periods;
+        uint64_t edges;         // alias write groups issued
+        uint64_t runNs;
+        double meanLateNs;      // edge issued - edge scheduled
+        uint64_t p50LateNs;
+        uint64_t p99LateNs;
+        uint64_t maxLateNs;
+        double rmsJitterNs;     // standard deviation of the lateness
+        uint64_t resolutionNs;  // one timer tick
+    } RP1ClockStats_t;
+
+    // Clock generator on RIO pins, paced by the generic timer. prepare()
+    // turns frequency, duty and per-pin phase into the SET/CLR writes of one
+    // period; run() first measures what one paced edge costs (timer read +
+    // alias write) and then issues every edge of every period at its
+    // scheduled tick. Period boundaries are kept in 32.32 fixed point ticks,
+    // so the frequency does not drift for long durations. A target the loop
+    // cannot pace runs as fast as possible and is reported as limited.
+    class RP1Clock
+    {
+        public:
+            RP1Clock(std::shared_ptr<CTracer> tracer);
+            virtual ~RP1Clock();
+
+            bool prepare(const RP1ClockConfig_t& config);
+            bool run(const RP1IO::Fast& io);
+
+            uint32_t mask() const { return m_mask; }
+            RP1ClockStats_t stats() const;
+            std::string formatStats() const;
+
+        private:
+            struct Event
+            {
+                uint64_t offsetQ;       // ticks from the period start, 32.32
+                uint32_t set;
+                uint32_t clr;
+            };
+
+            uint64_t calibrate(const RP1IO::Fast& io);
+
+            std::shared_ptr<CTracer> m_trace;
+            RP1ClockConfig_t m_config = {};
+            std::vector<Event> m_events;
+            uint32_t m_mask = 0;
+            uint32_t m_initial = 0;         // pin levels at phase 0
+            uint64_t m_periodQ = 0;
+            uint64_t m_periods = 0;
+            double m_minGap = 1.0;          // smallest gap between two edges, fraction of the period
+            uint64_t m_freq = 0;
+            uint64_t m_sleepTicks = 0;      // waits longer than this sleep first
+
+            std::vector<uint32_t> m_late;   // lateness of the first edges, ticks
+            size_t m_lateCount = 0;
+            double m_lateSum = 0.0;
+            double m_lateSumSq = 0.0;
+            uint64_t m_lateMax = 0;
+            uint64_t m_edges = 0;
+            uint64_t m_loopTicks = 0;
+            uint64_t m_firstIssue = 0;
+            uint64_t m_lastIssue = 0;
+            uint64_t m_runTicks = 0;
+            bool m_bLimited = false;
+            bool m_bRan = false;
+    };
+}
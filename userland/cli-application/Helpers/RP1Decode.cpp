@@ -0,0 +1,421 @@
+#include "RP1Decode.h"
+#include "../Tracer/cfunctracer.h"
+#include <bit>
+#include <format>
+#include <string.h>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        // 8 samples per step; GCC lowers this to NEON on the Pi 5 and to
+        // SSE/AVX on a PC, no intrinsics needed
+        typedef uint32_t v8u __attribute__((vector_size(32)));
+
+        template <typename TimeFn>
+        size_t Changes(const uint32_t* samples, size_t n, uint32_t mask, TimeFn timeOf, std::vector<RP1Edge_t>& edges)
+        {
+            edges.clear();
+            if (n == 0)
+                return 0;
+            edges.push_back({ timeOf(0), samples[0] & mask });
+
+            const v8u vmask = v8u{} | mask;
+            size_t i = 1;
+            for (; i + 8 <= n; i += 8)
+            {
+                v8u cur, prev;
+                memcpy(&cur, samples + i, sizeof(cur));
+                memcpy(&prev, samples + i - 1, sizeof(prev));
+                v8u d = (cur ^ prev) & vmask;
+                if ((d[0] | d[1] | d[2] | d[3] | d[4] | d[5] | d[6] | d[7]) == 0) [[likely]]
+                    continue;
+                for (size_t j = 0; j < 8; ++j)
+                    if (d[j])
+                        edges.push_back({ timeOf(i + j), samples[i + j] & mask });
+            }
+            for (; i < n; ++i)
+                if ((samples[i] ^ samples[i - 1]) & mask)
+                    edges.push_back({ timeOf(i), samples[i] & mask });
+            return edges.size();
+        }
+
+        // Level lookups at increasing times within one frame
+        struct Cursor
+        {
+            const std::vector<RP1Edge_t>& edges;
+            size_t i;
+            uint32_t at(uint64_t t)
+            {
+                while ((i + 1 < edges.size()) && (edges[i + 1].ns <= t))
+                    ++i;
+                return edges[i].state;
+            }
+        };
+
+        bool Falling(const std::vector<RP1Edge_t>& edges, size_t k, uint32_t bit)
+        {
+            return ((edges[k - 1].state ^ edges[k].state) & bit) && !(edges[k].state & bit);
+        }
+        bool Rising(const std::vector<RP1Edge_t>& edges, size_t k, uint32_t bit)
+        {
+            return ((edges[k - 1].state ^ edges[k].state) & bit) && (edges[k].state & bit);
+        }
+        uint32_t Bit(uint32_t pin)
+        {
+            return (pin < 32) ? (1u << pin) : 0;
+        }
+    }
+
+    RP1Decode::RP1Decode(std::shared_ptr<CTracer> tracer)
+        : m_trace(tracer)
+    {
+        CFuncTracer trace("RP1Decode::RP1Decode", m_trace);
+    }
+    RP1Decode::~RP1Decode()
+    {
+        CFuncTracer trace("RP1Decode::~RP1Decode", m_trace);
+    }
+
+    size_t RP1Decode::changes(const uint32_t* samples, const uint64_t* timesNs, size_t n, uint32_t mask,
+                              std::vector<RP1Edge_t>& edges)
+    {
+        return Changes(samples, n, mask, [timesNs](size_t i) { return timesNs[i]; }, edges);
+    }
+
+    size_t RP1Decode::changes(const uint32_t* samples, size_t n, uint32_t mask, uint64_t periodNs,
+                              std::vector<RP1Edge_t>& edges)
+    {
+        return Changes(samples, n, mask, [periodNs](size_t i) { return i * periodNs; }, edges);
+    }
+
+    uint32_t RP1Decode::pinMask(const RP1DecodeConfig_t& config)
+    {
+        uint32_t mask = 0;
+        for (uint32_t pin : config.pins)
+            mask |= Bit(pin);
+        return mask;
+    }
+
+    bool RP1Decode::decode(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs,
+                           std::vector<RP1Frame_t>& frames)
+    {
+        CFuncTracer trace("RP1Decode::decode", m_trace);
+        try
+        {
+            frames.clear();
+            const size_t required = (config.protocol == eRp1Protocol::eSpi) ? 2 :
+                                    (config.protocol == eRp1Protocol::eI2c) ? 2 : 1;
+            for (size_t p = 0; p < required; ++p)
+            {
+                if (config.pins[p] >= 32)
+                {
+                    trace.Error("pin %ld of the protocol is missing", p);
+                    return false;
+                }
+            }
+            if ((config.protocol == eRp1Protocol::eUart) &&
+                ((config.baud == 0) || (config.dataBits < 5) || (config.dataBits > 9) || (config.stopBits < 1) || (config.stopBits > 2)))
+            {
+                trace.Error("invalid uart settings %u baud %u bits %u stop", config.baud, config.dataBits, config.stopBits);
+                return false;
+            }
+            if ((config.protocol == eRp1Protocol::eSpi) && ((config.dataBits == 0) || (config.dataBits > 32) || (config.spiMode > 3)))
+            {
+                trace.Error("invalid spi settings %u bits mode %u", config.dataBits, config.spiMode);
+                return false;
+            }
+            if (edges.size() < 2)
+                return true;
+
+            switch (config.protocol)
+            {
+                case eRp1Protocol::eUart: uart(config, edges, endNs, frames); break;
+                case eRp1Protocol::eSpi: spi(config, edges, endNs, frames); break;
+                case eRp1Protocol::eI2c: i2c(config, edges, endNs, frames); break;
+                case eRp1Protocol::eOneWire: oneWire(config, edges, endNs, frames); break;
+            }
+            trace.Trace("%ld edges, %ld frames", edges.size(), frames.size());
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    // Idle high; a falling edge starts a frame, every bit is sampled in the
+    // middle of its bit time, the search for the next start bit resumes in
+    // the middle of the stop bit.
+    void RP1Decode::uart(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs, std::vector<RP1Frame_t>& frames)
+    {
+        const uint32_t rx = Bit(config.pins[0]);
+        const double bitNs = 1e9 / config.baud;
+        const uint32_t parityBits = (config.parity == 'e' || config.parity == 'o') ? 1 : 0;
+        Cursor cursor { edges, 0 };
+
+        size_t k = 1;
+        while (k < edges.size())
+        {
+            if (!Falling(edges, k, rx))
+            {
+                ++k;
+                continue;
+            }
+            const uint64_t t0 = edges[k].ns;
+            auto at = [&](double bits) { return t0 + static_cast<uint64_t>(bits * bitNs); };
+            cursor.i = k;
+
+            RP1Frame_t frame = { t0, at(1 + config.dataBits + parityBits + config.stopBits), eRp1FrameType::eData, 0, 0, 0 };
+            if (at(0.5 + config.dataBits + parityBits + config.stopBits) > endNs)
+            {
+                frame.flags |= RP1_FRAME_INCOMPLETE;
+                frames.push_back(frame);
+                break;
+            }
+            if (cursor.at(at(0.5)) & rx)
+            {
+                ++k;            // glitch, not a start bit
+                continue;
+            }
+            for (uint32_t b = 0; b < config.dataBits; ++b)
+                if (cursor.at(at(1.5 + b)) & rx)
+                    frame.data |= 1u << b;
+            if (parityBits)
+            {
+                uint32_t ones = std::popcount(frame.data) + ((cursor.at(at(1.5 + config.dataBits)) & rx) ? 1 : 0);
+                if ((ones & 1u) != ((config.parity == 'o') ? 1u : 0u))
+                    frame.flags |= RP1_FRAME_PARITY;
+            }
+            for (uint32_t s = 0; s < config.stopBits; ++s)
+                if (!(cursor.at(at(1.5 + config.dataBits + parityBits + s)) & rx))
+                    frame.flags |= RP1_FRAME_FRAMING;
+            frames.push_back(frame);
+
+            const uint64_t resume = at(1.5 + config.dataBits + parityBits);
+            while ((k < edges.size()) && (edges[k].ns <= resume))
+                ++k;
+        }
+    }
+
+    // Bits are taken from the change list entry of the sampling clock edge:
+    // rising for mode 0 and 3, falling for mode 1 and 2. Without cs the word
+    // boundaries follow from the first clock edge.
+    void RP1Decode::spi(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs, std::vector<RP1Frame_t>& frames)
+    {
+        const uint32_t sck = Bit(config.pins[0]);
+        const uint32_t mosi = Bit(config.pins[1]);
+        const uint32_t miso = Bit(config.pins[2]);
+        const uint32_t cs = Bit(config.pins[3]);
+        const bool sampleRising = ((config.spiMode >> 1) & 1u) == (config.spiMode & 1u);
+
+        bool selected = cs ? !(edges[0].state & cs) : true;
+        uint32_t bits = 0, mo = 0, mi = 0;
+        uint64_t start = 0;
+        for (size_t k = 1; k < edges.size(); ++k)
+        {
+            const uint32_t cur = edges[k].state;
+            const uint32_t changed = edges[k - 1].state ^ cur;
+            const uint64_t ns = edges[k].ns;
+            if (changed & cs)
+            {
+                if (cur & cs)
+                {
+                    if (bits)
+                        frames.push_back({ start, ns, eRp1FrameType::eData, mo, mi, RP1_FRAME_INCOMPLETE });
+                    frames.push_back({ ns, ns, eRp1FrameType::eStop, 0, 0, 0 });
+                    selected = false;
+                }
+                else
+                {
+                    frames.push_back({ ns, ns, eRp1FrameType::eStart, 0, 0, 0 });
+                    selected = true;
+                }
+                bits = mo = mi = 0;
+            }
+            if (!selected || !(changed & sck) || (((cur & sck) != 0) != sampleRising))
+                continue;
+
+            if (bits == 0)
+                start = ns;
+            const uint32_t bo = (cur & mosi) ? 1 : 0;
+            const uint32_t bi = (cur & miso) ? 1 : 0;
+            if (config.lsbFirst)
+            {
+                mo |= bo << bits;
+                mi |= bi << bits;
+            }
+            else
+            {
+                mo = (mo << 1) | bo;
+                mi = (mi << 1) | bi;
+            }
+            if (++bits == config.dataBits)
+            {
+                frames.push_back({ start, ns, eRp1FrameType::eData, mo, mi, 0 });
+                bits = mo = mi = 0;
+            }
+        }
+        if (bits)
+            frames.push_back({ start, endNs, eRp1FrameType::eData, mo, mi, RP1_FRAME_INCOMPLETE });
+    }
+
+    // START / STOP: sda changes while scl stays high. Data is sampled on the
+    // rising scl edge, 8 bits MSB first and the ACK bit (low = ACK).
+    void RP1Decode::i2c(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs, std::vector<RP1Frame_t>& frames)
+    {
+        const uint32_t scl = Bit(config.pins[0]);
+        const uint32_t sda = Bit(config.pins[1]);
+
+        bool inFrame = false;
+        uint32_t bits = 0, byte = 0, count = 0;
+        uint64_t start = 0;
+        for (size_t k = 1; k < edges.size(); ++k)
+        {
+            const uint32_t prev = edges[k - 1].state;
+            const uint32_t cur = edges[k].state;
+            const uint64_t ns = edges[k].ns;
+            const eRp1FrameType type = (count == 0) ? eRp1FrameType::eAddress : eRp1FrameType::eData;
+            if (((prev ^ cur) & sda) && (prev & scl) && (cur & scl))
+            {
+                if (bits)
+                    frames.push_back({ start, ns, type, byte, 0, RP1_FRAME_INCOMPLETE });
+                frames.push_back({ ns, ns, (cur & sda) ? eRp1FrameType::eStop : eRp1FrameType::eStart, 0, 0, 0 });
+                inFrame = !(cur & sda);
+                bits = byte = count = 0;
+                continue;
+            }
+            if (!inFrame || !Rising(edges, k, scl))
+                continue;
+
+            if (bits == 0)
+                start = ns;
+            if (bits < 8)
+            {
+                byte = (byte << 1) | ((cur & sda) ? 1 : 0);
+                ++bits;
+                continue;
+            }
+            uint32_t flags = (cur & sda) ? static_cast<uint32_t>(RP1_FRAME_NACK) : 0u;
+            if ((type == eRp1FrameType::eAddress) && (byte & 1u))
+                flags |= RP1_FRAME_READ;
+            frames.push_back({ start, ns, type, byte, 0, flags });
+            bits = byte = 0;
+            ++count;
+        }
+        if (bits)
+            frames.push_back({ start, endNs, (count == 0) ? eRp1FrameType::eAddress : eRp1FrameType::eData, byte, 0, RP1_FRAME_INCOMPLETE });
+    }
+
+    // Reset: low for 480 us (accepted from 380 us), presence: the slave pulls
+    // low for 60..240 us within 80 us. Time slots: low shorter than 15 us is a
+    // 1, up to 150 us a 0; bytes are sent LSB first.
+    void RP1Decode::oneWire(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs, std::vector<RP1Frame_t>& frames)
+    {
+        const uint32_t dq = Bit(config.pins[0]);
+        auto nextRising = [&](size_t k) {
+            while ((k < edges.size()) && !Rising(edges, k, dq))
+                ++k;
+            return k;
+        };
+        auto nextFalling = [&](size_t k) {
+            while ((k < edges.size()) && !Falling(edges, k, dq))
+                ++k;
+            return k;
+        };
+
+        uint32_t bits = 0, byte = 0;
+        uint64_t start = 0;
+        size_t k = nextFalling(1);
+        while (k < edges.size())
+        {
+            const uint64_t tFall = edges[k].ns;
+            const size_t r = nextRising(k + 1);
+            if (r >= edges.size())
+            {
+                frames.push_back({ tFall, endNs, eRp1FrameType::eData, byte, 0, RP1_FRAME_INCOMPLETE });
+                return;
+            }
+            const uint64_t low = edges[r].ns - tFall;
+            size_t next = r + 1;
+
+            if (low >= 380000)
+            {
+                RP1Frame_t frame = { tFall, edges[r].ns, eRp1FrameType::eReset, 0, 0, 0 };
+                const size_t p = nextFalling(r + 1);
+                if ((p < edges.size()) && (edges[p].ns - edges[r].ns <= 80000))
+                {
+                    const size_t q = nextRising(p + 1);
+                    const uint64_t presence = (q < edges.size()) ? edges[q].ns - edges[p].ns : 0;
+                    if ((presence >= 60000) && (presence <= 240000))
+                    {
+                        frame.flags |= RP1_FRAME_PRESENCE;
+                        frame.endNs = edges[q].ns;
+                        next = q + 1;
+                    }
+                }
+                if (bits)
+                    frames.push_back({ start, tFall, eRp1FrameType::eData, byte, 0, RP1_FRAME_INCOMPLETE });
+                frames.push_back(frame);
+                bits = byte = 0;
+            }
+            else if (low > 150000)
+            {
+                frames.push_back({ tFall, edges[r].ns, eRp1FrameType::eData, byte, 0, RP1_FRAME_FRAMING });
+                bits = byte = 0;
+            }
+            else
+            {
+                if (bits == 0)
+                    start = tFall;
+                if (low < 15000)
+                    byte |= 1u << bits;
+                if (++bits == 8)
+                {
+                    frames.push_back({ start, edges[r].ns, eRp1FrameType::eData, byte, 0, 0 });
+                    bits = byte = 0;
+                }
+            }
+            k = nextFalling(next);
+        }
+        if (bits)
+            frames.push_back({ start, endNs, eRp1FrameType::eData, byte, 0, RP1_FRAME_INCOMPLETE });
+    }
+
+    // uart | spi | i2c | onewire, with the defaults 115200 8N1 / mode 0 MSB first
+    bool RP1Decode::parseProtocol(const std::string& name, RP1DecodeConfig_t& config)
+    {
+        config = { eRp1Protocol::eUart, { RP1_DECODE_NOPIN, RP1_DECODE_NOPIN, RP1_DECODE_NOPIN, RP1_DECODE_NOPIN },
+                   115200, 8, 'n', 1, 0, false };
+        if (name == "uart") config.protocol = eRp1Protocol::eUart;
+        else if (name == "spi") config.protocol = eRp1Protocol::eSpi;
+        else if (name == "i2c") config.protocol = eRp1Protocol::eI2c;
+        else if ((name == "onewire") || (name == "1wire")) config.protocol = eRp1Protocol::eOneWire;
+        else return false;
+        return true;
+    }
+
+    std::string RP1Decode::formatFrame(const RP1DecodeConfig_t& config, const RP1Frame_t& frame)
+    {
+        static const char* types[] = { "data", "start", "stop", "address", "reset" };
+        std::string text = std::format("{:>14} {:>9} {:<8}", frame.startNs, frame.endNs - frame.startNs,
+                                       types[static_cast<int>(frame.type)]);
+        if ((frame.type == eRp1FrameType::eData) || (frame.type == eRp1FrameType::eAddress))
+        {
+            text += std::format(" 0x{:02x}", frame.data);
+            if ((config.protocol == eRp1Protocol::eUart) && (frame.data >= 0x20) && (frame.data < 0x7f))
+                text += std::format(" '{}'", static_cast<char>(frame.data));
+            if ((config.protocol == eRp1Protocol::eSpi) && (config.pins[2] < 32))
+                text += std::format(" miso 0x{:02x}", frame.data2);
+            if (frame.type == eRp1FrameType::eAddress)
+                text += std::format(" (0x{:02x} {})", frame.data >> 1, (frame.flags & RP1_FRAME_READ) ? "read" : "write");
+        }
+        if (frame.flags & RP1_FRAME_FRAMING) text += " framing-error";
+        if (frame.flags & RP1_FRAME_PARITY) text += " parity-error";
+        if (frame.flags & RP1_FRAME_NACK) text += " nack";
+        if (frame.flags & RP1_FRAME_INCOMPLETE) text += " incomplete";
+        if (frame.flags & RP1_FRAME_PRESENCE) text += " presence";
+        return text;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../Tracer/ctracer.h"
+
+namespace SB::RPI5
+{
+    // One entry of a change list: the input word from ns on. A stream file
+    // is a change list already; sample buffers are turned into one by
+    // RP1Decode::changes().
+    typedef struct
+    {
+        uint64_t ns;
+        uint32_t state;
+    } RP1Edge_t;
+
+    enum class eRp1Protocol
+    {
+        eUart,
+        eSpi,
+        eI2c,
+        eOneWire
+    };
+
+    constexpr uint32_t RP1_DECODE_NOPIN = UINT32_MAX;
+
+    typedef struct
+    {
+        eRp1Protocol protocol;
+        // uart: rx | spi: sck, mosi, miso, cs | i2c: scl, sda | 1-wire: dq;
+        // unused entries RP1_DECODE_NOPIN (spi miso and cs are optional)
+        uint32_t pins[4];
+        uint32_t baud;          // uart
+        uint32_t dataBits;      // uart 5..9, spi 1..32
+        char parity;            // uart 'n', 'e', 'o'
+        uint32_t stopBits;      // uart 1, 2
+        uint32_t spiMode;       // 0..3 (cpol << 1 | cpha)
+        bool lsbFirst;          // spi
+    } RP1DecodeConfig_t;
+
+    enum class eRp1FrameType
+    {
+        eData,
+        eStart,         // i2c (repeated) start, spi cs asserted
+        eStop,          // i2c stop, spi cs released
+        eAddress,       // i2c address byte
+        eReset          // 1-wire reset pulse
+    };
+
+    enum : uint32_t
+    {
+        RP1_FRAME_FRAMING = 1u << 0,        // uart stop bit low, 1-wire slot too long
+        RP1_FRAME_PARITY = 1u << 1,
+        RP1_FRAME_NACK = 1u << 2,           // i2c
+        RP1_FRAME_INCOMPLETE = 1u << 3,     // cut by cs, stop or the end of the data
+        RP1_FRAME_PRESENCE = 1u << 4,       // 1-wire reset answered
+        RP1_FRAME_READ = 1u << 5            // i2c address with R/W = 1
+    };
+
+    typedef struct
+    {
+        uint64_t startNs;
+        uint64_t endNs;
+        eRp1FrameType type;
+        uint32_t data;          // uart / i2c / 1-wire byte, spi mosi
+        uint32_t data2;         // spi miso
+        uint32_t flags;
+    } RP1Frame_t;
+
+    // Offline protocol decoders. They walk the change list, so idle time
+    // costs nothing; turning a sample buffer into a change list compares 8
+    // samples per step and only looks at single samples in the (rare) groups
+    // that contain a change.
+    class RP1Decode
+    {
+        public:
+            RP1Decode(std::shared_ptr<CTracer> tracer);
+            virtual ~RP1Decode();
+
+            // Changes of (sample & mask), sample i taken at timesNs[i] or at
+            // i * periodNs; the first sample is always an entry.
+            static size_t changes(const uint32_t* samples, const uint64_t* timesNs, size_t n, uint32_t mask,
+                                  std::vector<RP1Edge_t>& edges);
+            static size_t changes(const uint32_t* samples, size_t n, uint32_t mask, uint64_t periodNs,
+                                  std::vector<RP1Edge_t>& edges);
+
+            // endNs is the end of the captured data; a frame running past it
+            // is flagged incomplete
+            bool decode(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs,
+                        std::vector<RP1Frame_t>& frames);
+
+            static uint32_t pinMask(const RP1DecodeConfig_t& config);
+            static bool parseProtocol(const std::string& name, RP1DecodeConfig_t& config);
+            static std::string formatFrame(const RP1DecodeConfig_t& config, const RP1Frame_t& frame);
+
+        private:
+            static void uart(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs, std::vector<RP1Frame_t>& frames);
+            static void spi(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs, std::vector<RP1Frame_t>& frames);
+            static void i2c(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs, std::vector<RP1Frame_t>& frames);
+            static void oneWire(const RP1DecodeConfig_t& config, const std::vector<RP1Edge_t>& edges, uint64_t endNs, std::vector<RP1Frame_t>& frames);
+
+            std::shared_ptr<CTracer> m_trace;
+    };
+}
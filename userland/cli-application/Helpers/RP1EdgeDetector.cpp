@@ -0,0 +1,266 @@
+#include "RP1EdgeDetector.h"
+#include "RP1Timer.h"
+#include "../Tracer/cfunctracer.h"
+#include <algorithm>
+#include <bit>
+#include <format>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        constexpr uint32_t CHECK_POLLS = 1024;      // polls between two looks at the clock
+        constexpr uint32_t SPIN_WAITS = 256;        // empty ring checks before the consumer yields
+    }
+
+    RP1EdgeDetector::RP1EdgeDetector(std::shared_ptr<CTracer> tracer)
+        : m_trace(tracer)
+    {
+        CFuncTracer trace("RP1EdgeDetector::RP1EdgeDetector", m_trace);
+        m_freq = rp1_tick_freq();
+    }
+    RP1EdgeDetector::~RP1EdgeDetector()
+    {
+        CFuncTracer trace("RP1EdgeDetector::~RP1EdgeDetector", m_trace);
+        if (m_bRunning)
+            stop();
+    }
+
+    bool RP1EdgeDetector::start(const RP1EdgeDetectorConfig_t& config, const RP1IO::Fast& io)
+    {
+        CFuncTracer trace("RP1EdgeDetector::start", m_trace);
+        try
+        {
+            if (m_bRunning || !io.valid() || (config.mask == 0) || (config.queueEdges == 0))
+            {
+                trace.Error("cannot start (running %d, valid %d, mask 0x%08x, queue %ld)",
+                            m_bRunning, io.valid(), config.mask, config.queueEdges);
+                return false;
+            }
+            m_config = config;
+            m_io = io;
+            m_report = {};
+            m_bStop = false;
+            m_polls = m_dropped = m_maxGapNs = 0;
+            m_head = m_tail = 0;
+
+            // Written once here, so the poll thread never faults a page in
+            const size_t size = std::bit_ceil(config.queueEdges);
+            m_ring.assign(size, RP1EdgeEvent_t{ 0, 0, 0 });
+            m_ringMask = size - 1;
+
+            SBRealtime::resolveCpu(config.realtime, m_report);
+            m_startTicks = rp1_ticks();
+            m_lastTicks = m_startTicks;
+            m_poller = std::thread([this]() {
+                SBRealtime::applyToThisThread(m_config.realtime, m_report);
+                poll();
+            });
+            m_bRunning = true;
+            trace.Info("watching mask 0x%08x, %ld edge queue", config.mask, size);
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    bool RP1EdgeDetector::stop()
+    {
+        CFuncTracer trace("RP1EdgeDetector::stop", m_trace);
+        try
+        {
+            if (!m_bRunning)
+                return false;
+            m_bStop.store(true);
+            m_poller.join();
+            m_bRunning = false;
+            m_report.runNs = rp1_ticks_to_ns(m_lastTicks.load() - m_startTicks, m_freq);
+            for (const auto& w : m_report.warnings)
+                trace.Warning("%s", w.c_str());
+            auto st = stats();
+            trace.Info("%llu polls, %llu edges, %llu dropped", static_cast<unsigned long long>(st.polls),
+                       static_cast<unsigned long long>(st.edges), static_cast<unsigned long long>(st.dropped));
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    void RP1EdgeDetector::poll()
+    {
+        const RP1IO::Fast io = m_io;
+        const uint32_t mask = m_config.mask;
+        RP1EdgeEvent_t *ring = m_ring.data();
+        const uint64_t ringMask = m_ringMask;
+        const uint64_t size = ringMask + 1;
+
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        uint64_t tail = m_tail.load(std::memory_order_acquire);
+        uint32_t prev = io.readSync() & mask;
+        uint64_t last = rp1_ticks();
+        while (!m_bStop.load(std::memory_order_relaxed))
+        {
+            for (uint32_t i = 0; i < CHECK_POLLS; ++i)
+            {
+                const uint32_t v = io.readSync() & mask;
+                uint32_t changed = v ^ prev;
+                if (changed) [[unlikely]]
+                {
+                    const uint64_t t = rp1_ticks();
+                    prev = v;
+                    // The tail is only re-read when the ring looks full
+                    if (head + std::popcount(changed) - tail > size)
+                        tail = m_tail.load(std::memory_order_acquire);
+                    while (changed)
+                    {
+                        const uint32_t pin = std::countr_zero(changed);
+                        changed &= changed - 1;
+                        if (head - tail >= size)
+                        {
+                            m_dropped.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                        ring[head & ringMask] = { t, pin, (v >> pin) & 1u };
+                        ++head;
+                    }
+                    m_head.store(head, std::memory_order_release);
+                }
+            }
+            const uint64_t now = rp1_ticks();
+            const uint64_t gap = rp1_ticks_to_ns(now - last, m_freq);
+            if (gap > m_maxGapNs.load(std::memory_order_relaxed))
+                m_maxGapNs.store(gap, std::memory_order_relaxed);
+            last = now;
+            m_polls.fetch_add(CHECK_POLLS, std::memory_order_relaxed);
+            m_lastTicks.store(now, std::memory_order_relaxed);
+        }
+    }
+
+    void RP1EdgeDetector::discard()
+    {
+        m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    bool RP1EdgeDetector::tryPop(RP1EdgeEvent_t& edge)
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+            return false;
+        edge = m_ring[tail & m_ringMask];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t RP1EdgeDetector::toNs(uint64_t ticks) const
+    {
+        return (ticks > m_startTicks) ? rp1_ticks_to_ns(ticks - m_startTicks, m_freq) : 0;
+    }
+
+    // Spin a little for edges that are close together, then give the cpu
+    // away between checks
+    bool RP1EdgeDetector::waitPop(uint64_t deadline, RP1EdgeEvent_t& edge)
+    {
+        for (uint32_t spins = 0; ; ++spins)
+        {
+            if (tryPop(edge))
+                return true;
+            if (rp1_ticks() >= deadline)
+                return false;
+            if (spins >= SPIN_WAITS)
+                std::this_thread::yield();
+        }
+    }
+
+    int RP1EdgeDetector::WaitNextEdgeUs(int timeoutus, RP1EdgeEvent_t* outEv, std::vector<std::string>& errors)
+    {
+        if (!m_bRunning || (outEv == nullptr))
+        {
+            errors.emplace_back("WaitNextEdgeUs: edge detector not started");
+            return -1;
+        }
+        const uint64_t start = rp1_ticks();
+        const uint64_t deadline = (timeoutus < 0) ? UINT64_MAX : start + rp1_ns_to_ticks(static_cast<uint64_t>(timeoutus) * 1000ull, m_freq);
+        if (!waitPop(deadline, *outEv))
+        {
+            errors.emplace_back("WaitNextEdgeUs: timeout");
+            return -1;
+        }
+        // Time from the call to the edge, 0 when it was already queued
+        return static_cast<int>(rp1_ticks_to_ns((outEv->ticks > start) ? outEv->ticks - start : 0, m_freq) / 1000ull);
+    }
+
+    int RP1EdgeDetector::WaitNextEdgeUs(int timeoutus, gpioevent_data* outEv, std::vector<std::string>& errors)
+    {
+        RP1EdgeEvent_t edge = {};
+        int elapsedUs = WaitNextEdgeUs(timeoutus, &edge, errors);
+        if (elapsedUs < 0)
+            return -1;
+        if (outEv)
+        {
+            outEv->timestamp = toNs(edge.ticks);
+            outEv->id = edge.rising ? GPIOEVENT_EVENT_RISING_EDGE : GPIOEVENT_EVENT_FALLING_EDGE;
+        }
+        return elapsedUs;
+    }
+
+    int RP1EdgeDetector::WaitEdgesUs(int maxEdges, int totalTimeoutUs, std::vector<int>& deltasUs, std::vector<std::string>& errors)
+    {
+        CFuncTracer trace("RP1EdgeDetector::WaitEdgesUs", m_trace);
+        try
+        {
+            deltasUs.clear();
+            if (!m_bRunning)
+            {
+                errors.emplace_back("WaitEdgesUs: edge detector not started");
+                return -1;
+            }
+
+            // Absolute deadline for the whole capture
+            const uint64_t deadline = rp1_ticks() + rp1_ns_to_ticks(static_cast<uint64_t>(std::max(totalTimeoutUs, 0)) * 1000ull, m_freq);
+            RP1EdgeEvent_t prevEv = {};
+            bool havePrev = false;
+            while (static_cast<int>(deltasUs.size()) < maxEdges)
+            {
+                // no more edges before the global timeout
+                RP1EdgeEvent_t ev = {};
+                if (!waitPop(deadline, ev))
+                    break;
+                if (havePrev)
+                    deltasUs.push_back(static_cast<int>(rp1_ticks_to_ns(ev.ticks - prevEv.ticks, m_freq) / 1000ull));
+                prevEv = ev;
+                havePrev = true;
+            }
+            return static_cast<int>(deltasUs.size());
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+            errors.emplace_back(std::format("exception occurred : {0}", e.what()));
+        }
+        return -1;
+    }
+
+    RP1EdgeDetectorStats_t RP1EdgeDetector::stats() const
+    {
+        RP1EdgeDetectorStats_t st = {};
+        st.polls = m_polls.load(std::memory_order_relaxed);
+        st.edges = m_head.load(std::memory_order_relaxed);
+        st.dropped = m_dropped.load(std::memory_order_relaxed);
+        st.maxPollGapNs = m_maxGapNs.load(std::memory_order_relaxed);
+        const uint64_t runTicks = m_lastTicks.load(std::memory_order_relaxed) - m_startTicks;
+        st.meanPollNs = st.polls ? static_cast<double>(rp1_ticks_to_ns(runTicks, m_freq)) / static_cast<double>(st.polls) : 0.0;
+        return st;
+    }
+
+    std::string RP1EdgeDetector::formatStats(const RP1EdgeDetectorStats_t& stats)
+    {
+        return std::format("edges: {} polls ({:.1f} ns each), {} edges, {} dropped, longest check interval {} ns\n",
+                           stats.polls, stats.meanPollNs, stats.edges, stats.dropped, stats.maxPollGapNs);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <linux/gpio.h>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Tracer/ctracer.h"
+#include "SBRealtime.h"
+#include "SBRp1IO.h"
+
+namespace SB::RPI5
+{
+    typedef struct
+    {
+        uint64_t ticks;         // generic timer, first poll that saw the new level
+        uint32_t pin;
+        uint32_t rising;        // 1: low -> high, 0: high -> low
+    } RP1EdgeEvent_t;
+
+    typedef struct
+    {
+        uint32_t mask;                  // watched bank 0 pins
+        size_t queueEdges;              // rounded up to a power of two
+        SBRealtimeConfig_t realtime;    // cpu / priority of the poll thread
+    } RP1EdgeDetectorConfig_t;
+
+    typedef struct
+    {
+        uint64_t polls;         // reads of InSync
+        uint64_t edges;         // edges queued
+        uint64_t dropped;       // edges lost on a full queue
+        uint64_t maxPollGapNs;  // longest time for one check interval (1024 polls)
+        double meanPollNs;      // time between two reads of InSync
+    } RP1EdgeDetectorStats_t;
+
+    // Edge detection without the kernel: a pinned SCHED_FIFO thread spins on
+    // RIO InSync, XORs each sample with the previous one and queues one
+    // (pin, edge, ticks) record per changed watched pin. The queue is a single
+    // producer / single consumer ring with atomic head and tail, so the poll
+    // thread never blocks; a full ring counts the edge as dropped. The Wait
+    // functions take the same arguments as their SBPio counterparts, so a
+    // decoder written against kernel GPIO events can switch by swapping the
+    // object it waits on.
+    class RP1EdgeDetector
+    {
+        public:
+            RP1EdgeDetector(std::shared_ptr<CTracer> tracer);
+            virtual ~RP1EdgeDetector();
+
+            bool start(const RP1EdgeDetectorConfig_t& config, const RP1IO::Fast& io);
+            bool stop();
+            bool running() const { return m_bRunning; }
+            const RP1IO::Fast& io() const { return m_io; }
+
+            // Forget every queued edge, e.g. the ones caused by our own pulse
+            void discard();
+            bool tryPop(RP1EdgeEvent_t& edge);
+            uint64_t toNs(uint64_t ticks) const;
+
+            // As SBPio: us from the call to the edge, -1 on timeout or error;
+            // a negative timeout waits forever
+            int WaitNextEdgeUs(int timeoutus, RP1EdgeEvent_t* outEv, std::vector<std::string>& errors);
+            // As SBPio: id is GPIOEVENT_EVENT_RISING/FALLING_EDGE, timestamp in ns
+            int WaitNextEdgeUs(int timeoutus, gpioevent_data* outEv, std::vector<std::string>& errors);
+            // Intervals between up to maxEdges edges, as SBPio
+            int WaitEdgesUs(int maxEdges, int totalTimeoutUs, std::vector<int>& deltasUs, std::vector<std::string>& errors);
+
+            RP1EdgeDetectorStats_t stats() const;
+            const SBRealtimeReport_t& realtimeReport() const { return m_report; }
+            static std::string formatStats(const RP1EdgeDetectorStats_t& stats);
+
+        private:
+            void poll();
+            bool waitPop(uint64_t deadline, RP1EdgeEvent_t& edge);
+
+            std::shared_ptr<CTracer> m_trace;
+            RP1EdgeDetectorConfig_t m_config = {};
+            SBRealtimeReport_t m_report = {};
+            RP1IO::Fast m_io;
+            std::thread m_poller;
+            std::atomic<bool> m_bStop { false };
+            bool m_bRunning = false;
+            uint64_t m_freq = 0;
+            uint64_t m_startTicks = 0;
+
+            std::vector<RP1EdgeEvent_t> m_ring;
+            uint64_t m_ringMask = 0;
+            alignas(64) std::atomic<uint64_t> m_head { 0 };    // written by the poll thread
+            alignas(64) std::atomic<uint64_t> m_tail { 0 };    // written by the consumer
+
+            alignas(64) std::atomic<uint64_t> m_polls { 0 };
+            std::atomic<uint64_t> m_dropped { 0 };
+            std::atomic<uint64_t> m_maxGapNs { 0 };
+            std::atomic<uint64_t> m_lastTicks { 0 };
+    };
+}
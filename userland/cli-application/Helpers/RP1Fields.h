@@ -0,0 +1,265 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "RP1Registers.h"
+
+namespace SB::RPI5
+{
+    // Compile-time description of the RP1 registers the helpers touch.
+    //
+    //   RP1Register<Offset, Stride>   register at block + Offset (+ index * Stride)
+    //   RP1Field<Reg, Lsb, Width>     bit field of that register
+    //
+    // Everything is constexpr; the only code generated is the volatile load and
+    // store through rp1_read()/rp1_write(). Several fields of the same register
+    // are combined with '|' into one RP1FieldSet so that
+    //
+    //   rp1_modify(pad, pin, Pad::PullUp::val(1) | Pad::PullDown::val(0));
+    //
+    // is exactly one read and one write. Combining fields of different registers
+    // does not compile.
+    template <uint32_t Offset, uint32_t Stride = 4>
+    struct RP1Register
+    {
+        static_assert((Offset % 4) == 0 && (Stride % 4) == 0, "RP1 registers are 32 bit aligned");
+        static constexpr uint32_t offset = Offset;
+        static constexpr uint32_t stride = Stride;
+
+        [[gnu::always_inline]] static volatile uint32_t *at(volatile uint32_t *block, uint32_t index = 0) noexcept
+        {
+            if constexpr (Stride == 0)
+                return block + Offset / 4;
+            else
+            {
+                // Indexing a row view keeps one base for several registers of the
+                // same index, so the compiler folds Offset into the store.
+                using Row = volatile uint32_t[Stride / 4];
+                return &reinterpret_cast<Row*>(block)[index][Offset / 4];
+            }
+        }
+        [[gnu::always_inline]] static const volatile uint32_t *at(const volatile uint32_t *block, uint32_t index = 0) noexcept
+        {
+            return at(const_cast<volatile uint32_t*>(block), index);
+        }
+        [[gnu::always_inline]] static uint32_t read(const volatile uint32_t *block, uint32_t index = 0) noexcept
+        {
+            return rp1_read(at(block, index));
+        }
+        [[gnu::always_inline]] static void write(volatile uint32_t *block, uint32_t index, uint32_t value) noexcept
+        {
+            rp1_write(at(block, index), value);
+        }
+    };
+
+    template <typename Reg>
+    struct RP1FieldSet
+    {
+        uint32_t mask;
+        uint32_t bits;
+
+        constexpr RP1FieldSet operator|(RP1FieldSet other) const
+        {
+            return { mask | other.mask, bits | other.bits };
+        }
+    };
+
+    template <typename Reg, uint32_t Lsb, uint32_t Width>
+    struct RP1Field
+    {
+        static_assert(Width > 0 && Lsb + Width <= 32, "field does not fit in a 32 bit register");
+
+        using Register = Reg;
+        static constexpr uint32_t lsb = Lsb;
+        static constexpr uint32_t width = Width;
+        static constexpr uint32_t mask = (Width == 32) ? 0xffffffffu : (((1u << Width) - 1u) << Lsb);
+
+        static constexpr uint32_t encode(uint32_t value) { return (value << Lsb) & mask; }
+        static constexpr uint32_t decode(uint32_t raw) { return (raw & mask) >> Lsb; }
+        static constexpr RP1FieldSet<Reg> val(uint32_t value) { return { mask, encode(value) }; }
+        // Single bit 'n' (< Width) inside the field, e.g. one channel of a per-channel enable field
+        static constexpr RP1FieldSet<Reg> bitOn(uint32_t n) { return { 1u << (Lsb + n), 1u << (Lsb + n) }; }
+        static constexpr RP1FieldSet<Reg> bitOff(uint32_t n) { return { 1u << (Lsb + n), 0 }; }
+
+        [[gnu::always_inline]] static uint32_t get(const volatile uint32_t *block, uint32_t index = 0) noexcept
+        {
+            return decode(Reg::read(block, index));
+        }
+        [[gnu::always_inline]] static void set(volatile uint32_t *block, uint32_t index, uint32_t value) noexcept
+        {
+            rp1_modify(block, index, val(value));
+        }
+    };
+
+    // One read, one write: the fields in 'fields' are replaced, the rest kept.
+    template <typename Reg>
+    [[gnu::always_inline]] inline void rp1_modify(volatile uint32_t *block, uint32_t index, RP1FieldSet<Reg> fields) noexcept
+    {
+        volatile uint32_t *reg = Reg::at(block, index);
+        rp1_write(reg, (rp1_read(reg) & ~fields.mask) | fields.bits);
+    }
+
+    // Atomic, write-only updates through the per-block aliases
+    // (+0x1000 XOR, +0x2000 SET, +0x3000 CLR). No read of the register is
+    // needed, so there is no PCIe round trip and no lost update when two
+    // threads touch different bits of the same register.
+    enum class eRp1Alias : uint32_t
+    {
+        Xor = 0x1000,
+        Set = 0x2000,
+        Clr = 0x3000
+    };
+
+    [[gnu::always_inline]] inline volatile uint32_t *rp1_alias(volatile uint32_t *reg, eRp1Alias alias) noexcept
+    {
+        return reg + static_cast<uint32_t>(alias) / 4;
+    }
+    [[gnu::always_inline]] inline void rp1_set_bits(volatile uint32_t *reg, uint32_t bits) noexcept
+    {
+        rp1_write(rp1_alias(reg, eRp1Alias::Set), bits);
+    }
+    [[gnu::always_inline]] inline void rp1_clr_bits(volatile uint32_t *reg, uint32_t bits) noexcept
+    {
+        rp1_write(rp1_alias(reg, eRp1Alias::Clr), bits);
+    }
+    [[gnu::always_inline]] inline void rp1_xor_bits(volatile uint32_t *reg, uint32_t bits) noexcept
+    {
+        rp1_write(rp1_alias(reg, eRp1Alias::Xor), bits);
+    }
+
+    // Write-only field update: SET the new one bits, then CLR the remaining
+    // bits of the fields. Single-bit fields take one write. A multi-bit field
+    // passes through (old | new) between the two writes; callers that need a
+    // safe intermediate state set the whole field first (see setFunction).
+    template <typename Reg>
+    [[gnu::always_inline]] inline void rp1_apply(volatile uint32_t *block, uint32_t index, RP1FieldSet<Reg> fields) noexcept
+    {
+        volatile uint32_t *reg = Reg::at(block, index);
+        if (fields.bits != 0)
+            rp1_set_bits(reg, fields.bits);
+        if ((fields.mask & ~fields.bits) != 0)
+            rp1_clr_bits(reg, fields.mask & ~fields.bits);
+    }
+
+    // ----------------------------------------------------------------
+    // PAD bank (window Pad, +4 per pin after the voltage select register).
+    // The helpers' pad() pointer already skips VOLTAGE_SELECT, so Offset 0.
+    // ----------------------------------------------------------------
+    namespace Pad
+    {
+        using Reg = RP1Register<0x00, 4>;
+        using SlewFast = RP1Field<Reg, 0, 1>;
+        using Schmitt = RP1Field<Reg, 1, 1>;
+        using PullDown = RP1Field<Reg, 2, 1>;
+        using PullUp = RP1Field<Reg, 3, 1>;
+        using Drive = RP1Field<Reg, 4, 2>;          // 0 = 2mA, 1 = 4mA, 2 = 8mA, 3 = 12mA
+        using InputEnable = RP1Field<Reg, 6, 1>;
+        using OutputDisable = RP1Field<Reg, 7, 1>;
+        using Pulls = RP1Field<Reg, 2, 2>;          // PullDown + PullUp together
+    }
+
+    // ----------------------------------------------------------------
+    // GPIO bank (window Gpio): STATUS / CTRL pair per pin, 8 bytes apart.
+    // ----------------------------------------------------------------
+    namespace GpioStatus
+    {
+        using Reg = RP1Register<0x00, 8>;
+        using OutFromPeri = RP1Field<Reg, 8, 1>;
+        using OutToPad = RP1Field<Reg, 9, 1>;
+        using OeFromPeri = RP1Field<Reg, 12, 1>;
+        using OeToPad = RP1Field<Reg, 13, 1>;
+        using InFromPad = RP1Field<Reg, 17, 1>;
+        using InFiltered = RP1Field<Reg, 18, 1>;
+        using InToPeri = RP1Field<Reg, 19, 1>;
+        using IrqToProc = RP1Field<Reg, 29, 1>;
+    }
+    namespace GpioCtrl
+    {
+        using Reg = RP1Register<0x04, 8>;
+        using FuncSel = RP1Field<Reg, 0, 5>;
+        using FilterM = RP1Field<Reg, 5, 7>;
+        using OutOver = RP1Field<Reg, 12, 2>;
+        using OeOver = RP1Field<Reg, 14, 2>;
+        using InOver = RP1Field<Reg, 16, 2>;
+        using IrqMask = RP1Field<Reg, 20, 8>;
+        using IrqReset = RP1Field<Reg, 28, 1>;
+        using IrqOver = RP1Field<Reg, 30, 2>;
+    }
+
+    // ----------------------------------------------------------------
+    // RIO bank (window Rio): one bit per pin of the bank.
+    // ----------------------------------------------------------------
+    namespace Rio
+    {
+        using Out = RP1Register<0x00, 0>;
+        using OE = RP1Register<0x04, 0>;
+        using In = RP1Register<0x08, 0>;
+        using InSync = RP1Register<0x0c, 0>;
+    }
+
+    // ----------------------------------------------------------------
+    // PWM block (windows Pwm0 / Pwm1).
+    // ----------------------------------------------------------------
+    namespace PwmGlobal
+    {
+        using Reg = RP1Register<0x00, 0>;
+        using ChanEnable = RP1Field<Reg, 0, 4>;
+        using SetUpdate = RP1Field<Reg, 31, 1>;
+    }
+    namespace PwmFifoCtrl
+    {
+        using Reg = RP1Register<0x04, 0>;
+        using Level = RP1Field<Reg, 0, 5>;          // words in DUTY_FIFO, read only
+        using Flush = RP1Field<Reg, 5, 1>;
+        using FlushDone = RP1Field<Reg, 6, 1>;
+        using Threshold = RP1Field<Reg, 11, 5>;     // DREQ below this level
+        using DwellTime = RP1Field<Reg, 19, 5>;
+        using DreqEnable = RP1Field<Reg, 31, 1>;
+
+        constexpr uint32_t DEPTH = 16;              // DUTY_FIFO words
+    }
+    namespace PwmCommon
+    {
+        using Range = RP1Register<0x08, 0>;
+        using Duty = RP1Register<0x0c, 0>;
+        using DutyFifo = RP1Register<0x10, 0>;      // write pushes one duty word
+    }
+    namespace PwmChan
+    {
+        using Ctrl = RP1Register<0x14, 0x10>;
+        using Range = RP1Register<0x18, 0x10>;
+        using Phase = RP1Register<0x1c, 0x10>;
+        using Duty = RP1Register<0x20, 0x10>;
+
+        using Mode = RP1Field<Ctrl, 0, 3>;
+        using Invert = RP1Field<Ctrl, 3, 1>;
+        using Bind = RP1Field<Ctrl, 4, 1>;
+        using UseFifo = RP1Field<Ctrl, 5, 1>;
+        using Sdm = RP1Field<Ctrl, 6, 1>;
+        using Dither = RP1Field<Ctrl, 7, 1>;
+        using FifoPopMask = RP1Field<Ctrl, 8, 1>;
+        using SdmBandwidth = RP1Field<Ctrl, 12, 4>;
+        using SdmBias = RP1Field<Ctrl, 16, 16>;
+    }
+
+    // ----------------------------------------------------------------
+    // Clocks block: the PWM0 and PWM1 clock generators at 0x74 / 0x84.
+    // ----------------------------------------------------------------
+    namespace PwmClock
+    {
+        // index: PWM block, CLK_PWM1 follows CLK_PWM0 at 0x84
+        using Ctrl = RP1Register<0x74, 0x10>;
+        using DivInt = RP1Register<0x78, 0x10>;
+        using DivFrac = RP1Register<0x7c, 0x10>;
+        using Sel = RP1Register<0x80, 0x10>;
+
+        using AuxSrc = RP1Field<Ctrl, 5, 5>;
+        using Enable = RP1Field<Ctrl, 11, 1>;
+        using Int = RP1Field<DivInt, 0, 16>;        // integer divider, 0 reads as 65536
+        using Frac = RP1Field<DivFrac, 16, 16>;     // fraction in 1/65536
+        using Firmware = RP1Field<Ctrl, 24, 8>;     // upper bits as the firmware programs them
+
+        // 0x11000840: 50 MHz aux source (xosc based), enabled
+        constexpr uint32_t CTRL_DEFAULT = AuxSrc::encode(2) | Enable::encode(1) | Firmware::encode(0x11);
+        static_assert(CTRL_DEFAULT == 0x11000840u);
+    }
+}
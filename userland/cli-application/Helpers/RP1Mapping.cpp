@@ -0,0 +1,243 @@
+#include "RP1Mapping.h"
+#include "RP1Sim.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace SB::RPI5
+{
+    std::mutex RP1Mapping::s_lock;
+    std::weak_ptr<RP1Mapping> RP1Mapping::s_instance[static_cast<int>(eRp1Backend::Count)];
+#ifdef RP1_DEFAULT_BACKEND_SIM
+    eRp1Backend RP1Mapping::s_defaultBackend = eRp1Backend::Simulated;
+#else
+    eRp1Backend RP1Mapping::s_defaultBackend = eRp1Backend::Auto;
+#endif
+
+    std::shared_ptr<RP1Mapping> RP1Mapping::acquire(std::shared_ptr<CTracer> tracer, eRp1Backend backend)
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        if (backend == eRp1Backend::Auto)
+            backend = s_defaultBackend;
+
+        std::shared_ptr<RP1Mapping> mapping = s_instance[static_cast<int>(backend)].lock();
+        if (mapping)
+            return mapping;
+
+        mapping = std::shared_ptr<RP1Mapping>(new RP1Mapping(tracer, backend));
+        if (mapping->isValid())
+            s_instance[static_cast<int>(backend)] = mapping;
+        return mapping;
+    }
+
+    void RP1Mapping::setDefaultBackend(eRp1Backend backend)
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        s_defaultBackend = backend;
+    }
+    eRp1Backend RP1Mapping::getDefaultBackend()
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        return s_defaultBackend;
+    }
+    bool RP1Mapping::parseBackend(const std::string& name, eRp1Backend& backend)
+    {
+        if (name == "auto") backend = eRp1Backend::Auto;
+        else if (name == "devmem" || name == "mem") backend = eRp1Backend::DevMem;
+        else if (name == "gpiomem" || name == "gpiomem0") backend = eRp1Backend::GpioMem;
+        else if (name == "sim" || name == "simulated") backend = eRp1Backend::Simulated;
+        else return false;
+        return true;
+    }
+    const char* RP1Mapping::backendName(eRp1Backend backend)
+    {
+        switch (backend)
+        {
+            case eRp1Backend::Auto: return "auto";
+            case eRp1Backend::DevMem: return "devmem";
+            case eRp1Backend::GpioMem: return "gpiomem";
+            case eRp1Backend::Simulated: return "sim";
+            default: break;
+        }
+        return "unknown";
+    }
+
+    RP1Mapping::RP1Mapping(std::shared_ptr<CTracer> tracer, eRp1Backend backend)
+        : m_trace(tracer)
+        , m_backend(backend)
+    {
+        CFuncTracer trace("RP1Mapping::RP1Mapping", m_trace);
+        try
+        {
+            switch (m_backend)
+            {
+                case eRp1Backend::DevMem:
+                    m_bValid = mapDevMem();
+                    break;
+                case eRp1Backend::GpioMem:
+                    m_bValid = mapGpioMem();
+                    break;
+                case eRp1Backend::Simulated:
+                    m_bValid = mapSimulated();
+                    break;
+                default:
+                    m_bValid = mapDevMem();
+                    if (!m_bValid)
+                    {
+                        trace.Info("opens gpiomem0 as fallback");
+                        m_bValid = mapGpioMem();
+                    }
+                    break;
+            }
+            if (!m_bValid)
+            {
+                trace.Error("RP1 peripherals could not be mapped (backend %s)", backendName(m_backend));
+                return;
+            }
+
+            for (int i = 0; i < static_cast<int>(eRp1Window::Count); ++i)
+                trace.Info("%s : %p", RP1_WINDOWS[i].name, m_window[i]);
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+    }
+    RP1Mapping::~RP1Mapping()
+    {
+        CFuncTracer trace("RP1Mapping::~RP1Mapping", m_trace);
+        try
+        {
+            unmapAll();
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+    }
+
+    void *RP1Mapping::mapRegion(int fd, off_t offset, size_t size)
+    {
+        return mmap(nullptr,
+                    size,
+                    (PROT_READ | PROT_WRITE),
+                    MAP_SHARED | MAP_POPULATE,
+                    fd,
+                    offset);
+    }
+
+    bool RP1Mapping::mapDevMem()
+    {
+        CFuncTracer trace("RP1Mapping::mapDevMem", m_trace);
+        int memfd = open("/dev/mem", O_RDWR | O_SYNC);
+        if (memfd < 0)
+        {
+            trace.Info("open(/dev/mem) failed : %s", strerror(errno));
+            return false;
+        }
+
+        // Only the sub-windows we actually drive are mapped, not the full 4 MB BAR.
+        bool bOk = true;
+        for (int i = 0; i < static_cast<int>(eRp1Window::Count); ++i)
+        {
+            void *map = mapRegion(memfd, static_cast<off_t>(RP1_BAR0_BASE + RP1_WINDOWS[i].offset), RP1_WINDOWS[i].size);
+            if (map == MAP_FAILED)
+            {
+                trace.Error("mmap %s failed : %s", RP1_WINDOWS[i].name, strerror(errno));
+                bOk = false;
+                break;
+            }
+            m_region[i] = map;
+            m_regionSize[i] = RP1_WINDOWS[i].size;
+            m_window[i] = static_cast<uint32_t*>(map);
+        }
+        close(memfd);
+
+        if (!bOk)
+        {
+            unmapAll();
+            return false;
+        }
+        m_device = "/dev/mem";
+        return true;
+    }
+
+    bool RP1Mapping::mapGpioMem()
+    {
+        CFuncTracer trace("RP1Mapping::mapGpioMem", m_trace);
+        // /dev/gpiomem0 exposes the RP1 from the GPIO block onwards (offset 0 = 0xd0000).
+        // Only GPIO, RIO and PAD are reachable; PWM and clocks stay unmapped.
+        constexpr uint32_t GPIOMEM_BASE = 0x0d0000;
+        const RP1WindowInfo_t& pad = RP1_WINDOWS[static_cast<int>(eRp1Window::Pad)];
+        const size_t span = pad.offset + pad.size - GPIOMEM_BASE;
+
+        int memfd = open("/dev/gpiomem0", O_RDWR | O_SYNC);
+        if (memfd < 0)
+        {
+            trace.Error("open(/dev/gpiomem0) failed : %s", strerror(errno));
+            return false;
+        }
+        void *map = mapRegion(memfd, 0, span);
+        close(memfd);
+        if (map == MAP_FAILED)
+        {
+            trace.Error("mmap failed : %s", strerror(errno));
+            return false;
+        }
+
+        constexpr int gpio = static_cast<int>(eRp1Window::Gpio);
+        m_region[gpio] = map;
+        m_regionSize[gpio] = span;
+        for (eRp1Window w : { eRp1Window::Gpio, eRp1Window::Rio, eRp1Window::Pad })
+        {
+            int i = static_cast<int>(w);
+            m_window[i] = static_cast<uint32_t*>(map) + (RP1_WINDOWS[i].offset - GPIOMEM_BASE) / 4;
+        }
+        m_device = "/dev/gpiomem0";
+        return true;
+    }
+
+    bool RP1Mapping::mapSimulated()
+    {
+        CFuncTracer trace("RP1Mapping::mapSimulated", m_trace);
+#ifdef RP1_SIMULATOR
+        for (int i = 0; i < static_cast<int>(eRp1Window::Count); ++i)
+        {
+            void *map = mmap(nullptr, RP1_WINDOWS[i].size, (PROT_READ | PROT_WRITE),
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+            if (map == MAP_FAILED)
+            {
+                trace.Error("mmap %s (simulated) failed : %s", RP1_WINDOWS[i].name, strerror(errno));
+                unmapAll();
+                return false;
+            }
+            m_region[i] = map;
+            m_regionSize[i] = RP1_WINDOWS[i].size;
+            m_window[i] = static_cast<uint32_t*>(map);
+        }
+        RP1Sim::attach(m_window);
+        m_device = "simulator";
+        return true;
+#else
+        trace.Error("simulated backend not available (build with -DRP1_SIMULATOR=ON)");
+        return false;
+#endif
+    }
+
+    void RP1Mapping::unmapAll()
+    {
+        if (m_backend == eRp1Backend::Simulated && m_bValid)
+            RP1Sim::detach();
+        for (int i = 0; i < static_cast<int>(eRp1Window::Count); ++i)
+        {
+            if (m_region[i] != nullptr)
+                munmap(m_region[i], m_regionSize[i]);
+            m_region[i] = nullptr;
+            m_regionSize[i] = 0;
+            m_window[i] = nullptr;
+        }
+        m_bValid = false;
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "../Tracer/cfunctracer.h"
+
+namespace SB::RPI5
+{
+    // Peripheral sub-windows of the RP1 BAR that the helpers use. Every RP1
+    // block is 16 KB: the registers at +0x0000 followed by the atomic XOR/SET/CLR
+    // aliases at +0x1000/+0x2000/+0x3000. GPIO, RIO and PAD have one block per
+    // bank (3 banks).
+    enum class eRp1Window : int
+    {
+        Clocks = 0,
+        Pwm0,
+        Pwm1,
+        Gpio,
+        Rio,
+        Pad,
+        Count
+    };
+
+    constexpr uint64_t RP1_BAR0_BASE = 0x1f00000000ULL;
+    constexpr size_t RP1_BLOCK_SIZE = 0x4000;
+    constexpr uint32_t RP1_BANK_COUNT = 3;
+    constexpr uint32_t RP1_BANK_PINS[RP1_BANK_COUNT] = { 28, 6, 20 };
+
+    // Where the register windows come from. Auto = the process default
+    // (see RP1Mapping::setDefaultBackend), which is /dev/mem with a
+    // /dev/gpiomem0 fallback unless the build or the command line says otherwise.
+    enum class eRp1Backend : int
+    {
+        Auto = 0,
+        DevMem,
+        GpioMem,
+        Simulated,
+        Count
+    };
+
+    typedef struct
+    {
+        const char* name;
+        uint32_t offset;    // offset from RP1_BAR0_BASE
+        size_t size;
+    } RP1WindowInfo_t;
+
+    constexpr RP1WindowInfo_t RP1_WINDOWS[static_cast<int>(eRp1Window::Count)] =
+    {
+        { "CLOCKS", 0x018000, RP1_BLOCK_SIZE },
+        { "PWM0",   0x098000, RP1_BLOCK_SIZE },
+        { "PWM1",   0x09c000, RP1_BLOCK_SIZE },
+        { "GPIO",   0x0d0000, RP1_BLOCK_SIZE * RP1_BANK_COUNT },
+        { "RIO",    0x0e0000, RP1_BLOCK_SIZE * RP1_BANK_COUNT },
+        { "PAD",    0x0f0000, RP1_BLOCK_SIZE * RP1_BANK_COUNT },
+    };
+
+    // Process-wide, reference counted mapping of the RP1 peripheral windows.
+    // The first acquire() for a backend maps the windows (prefaulted with
+    // MAP_POPULATE), later calls hand out the same instance, and the windows are
+    // unmapped when the last RP1Base (or other user) releases its shared_ptr.
+    class RP1Mapping
+    {
+        public:
+            static std::shared_ptr<RP1Mapping> acquire(std::shared_ptr<CTracer> tracer, eRp1Backend backend = eRp1Backend::Auto);
+            static void setDefaultBackend(eRp1Backend backend);
+            static eRp1Backend getDefaultBackend();
+            static bool parseBackend(const std::string& name, eRp1Backend& backend);
+            static const char* backendName(eRp1Backend backend);
+            virtual ~RP1Mapping();
+
+            RP1Mapping(const RP1Mapping&) = delete;
+            RP1Mapping& operator=(const RP1Mapping&) = delete;
+
+            uint32_t *window(eRp1Window w) const { return m_window[static_cast<int>(w)]; }
+            bool isValid() const { return m_bValid; }
+            const char* deviceName() const { return m_device; }
+            eRp1Backend backend() const { return m_backend; }
+
+        private:
+            RP1Mapping(std::shared_ptr<CTracer> tracer, eRp1Backend backend);
+
+            bool mapDevMem();
+            bool mapGpioMem();
+            bool mapSimulated();
+            void unmapAll();
+            void *mapRegion(int fd, off_t offset, size_t size);
+
+            std::shared_ptr<CTracer> m_trace;
+            uint32_t *m_window[static_cast<int>(eRp1Window::Count)] = {};
+            void *m_region[static_cast<int>(eRp1Window::Count)] = {};
+            size_t m_regionSize[static_cast<int>(eRp1Window::Count)] = {};
+            const char* m_device = "none";
+            eRp1Backend m_backend = eRp1Backend::Auto;
+            bool m_bValid = false;
+
+            static std::mutex s_lock;
+            static std::weak_ptr<RP1Mapping> s_instance[static_cast<int>(eRp1Backend::Count)];
+            static eRp1Backend s_defaultBackend;
+    };
+}
@@ -0,0 +1,328 @@
+#include "RP1PinProfile.h"
+#include "RP1Base.h"
+#include "RP1Fields.h"
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <sstream>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        std::string Lower(std::string text)
+        {
+            for (auto& c : text)
+                c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            return text;
+        }
+
+        bool ParseNumber(const std::string& text, int32_t& value)
+        {
+            if (text.empty() || (text.find_first_not_of("0123456789") != std::string::npos) || (text.size() > 6))
+                return false;
+            value = std::stoi(text);
+            return true;
+        }
+
+        bool ParseOnOff(const std::string& text, int32_t& value)
+        {
+            if ((text == "on") || (text == "1") || (text == "yes"))
+                value = 1;
+            else if ((text == "off") || (text == "0") || (text == "no"))
+                value = 0;
+            else
+                return false;
+            return true;
+        }
+
+        bool ParseFunc(const std::string& text, uint32_t pin, int32_t& func)
+        {
+            if (text == "rio")
+                func = GPIO_FUNC_RIO;
+            else if (text == "proc_rio")
+                func = 6;
+            else if (text == "pio")
+                func = 7;
+            else if (text == "null")
+                func = RP1_FUNC_NULL;
+            else if (text == "pwm")
+                func = (pin < RP1_BANK_PINS[0]) ? RP1_BANK0_CAPS[pin].pwmFunc : -1;
+            else if ((text.size() == 4) && (text.compare(0, 3, "alt") == 0))
+                return ParseNumber(text.substr(3), func);
+            else
+                return ParseNumber(text, func);
+            return func >= 0;
+        }
+
+        bool ParseSetting(const std::string& key, const std::string& value, RP1PinSetting_t& s)
+        {
+            if (key == "func")
+                return ParseFunc(value, s.pin, s.func);
+            if (key == "pull")
+            {
+                if (value == "none")
+                    s.pull = PULL_NONE;
+                else if (value == "up")
+                    s.pull = PULL_UP;
+                else if (value == "down")
+                    s.pull = PULL_DOWN;
+                else
+                    return false;
+                return true;
+            }
+            if (key == "drive")
+            {
+                std::string ma = value;
+                if ((ma.size() > 2) && (ma.compare(ma.size() - 2, 2, "ma") == 0))
+                    ma.resize(ma.size() - 2);
+                return ParseNumber(ma, s.driveMa);
+            }
+            if (key == "slew")
+            {
+                if ((value != "fast") && (value != "slow"))
+                    return false;
+                s.slewFast = (value == "fast") ? 1 : 0;
+                return true;
+            }
+            if ((key == "schmitt") || (key == "hyst"))
+                return ParseOnOff(value, s.schmitt);
+            if (key == "dir")
+            {
+                if ((value != "in") && (value != "out"))
+                    return false;
+                s.output = (value == "out") ? 1 : 0;
+                return true;
+            }
+            if (key == "level")
+            {
+                if ((value == "high") || (value == "low"))
+                {
+                    s.level = (value == "high") ? 1 : 0;
+                    return true;
+                }
+                return ParseOnOff(value, s.level);
+            }
+            return false;
+        }
+
+        uint32_t DriveField(int32_t ma)
+        {
+            switch (ma)
+            {
+                case 2: return 0;
+                case 4: return 1;
+                case 8: return 2;
+                default: return 3;
+            }
+        }
+    }
+
+    RP1PinSetting_t RP1PinProfile::keep(uint32_t pin)
+    {
+        return { pin, RP1_PROFILE_KEEP, RP1_PROFILE_KEEP, RP1_PROFILE_KEEP, RP1_PROFILE_KEEP,
+                 RP1_PROFILE_KEEP, RP1_PROFILE_KEEP, RP1_PROFILE_KEEP };
+    }
+
+    bool RP1PinProfile::parse(const std::string& text, RP1PinProfile_t& profile, std::vector<std::string>& errors)
+    {
+        const size_t errorCount = errors.size();
+        profile.pins.clear();
+        std::istringstream lines(text);
+        std::string line;
+        for (uint32_t lineNr = 1; std::getline(lines, line); ++lineNr)
+        {
+            auto hash = line.find('#');
+            if (hash != std::string::npos)
+                line.resize(hash);
+            std::istringstream words(Lower(line));
+            std::string word;
+            if (!(words >> word))
+                continue;
+
+            if (word.compare(0, 4, "gpio") == 0)
+                word = word.substr(4);
+            int32_t pin = 0;
+            if (!ParseNumber(word, pin))
+            {
+                errors.emplace_back(std::format("line {}: '{}' is not a pin", lineNr, word));
+                continue;
+            }
+            RP1PinSetting_t s = keep(static_cast<uint32_t>(pin));
+            while (words >> word)
+            {
+                auto eq = word.find('=');
+                if ((eq == std::string::npos) || !ParseSetting(word.substr(0, eq), word.substr(eq + 1), s))
+                    errors.emplace_back(std::format("line {}: GPIO{} cannot take '{}'", lineNr, pin, word));
+            }
+            profile.pins.push_back(s);
+        }
+        return errors.size() == errorCount;
+    }
+
+    bool RP1PinProfile::load(const std::string& path, RP1PinProfile_t& profile, std::vector<std::string>& errors)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            errors.emplace_back(std::format("cannot open profile {}", path));
+            return false;
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+        auto slash = path.find_last_of('/');
+        profile.name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+        return parse(text.str(), profile, errors);
+    }
+
+    bool RP1PinProfile::validate(const RP1PinProfile_t& profile, std::vector<std::string>& errors)
+    {
+        const size_t errorCount = errors.size();
+        uint32_t seen = 0;
+        for (const auto& s : profile.pins)
+        {
+            if (s.pin >= RP1_BANK_PINS[0])
+            {
+                errors.emplace_back(std::format("GPIO{} is not a bank 0 pin", s.pin));
+                continue;
+            }
+            if (seen & (1u << s.pin))
+                errors.emplace_back(std::format("GPIO{} is in the profile twice", s.pin));
+            seen |= 1u << s.pin;
+
+            if ((s.func != RP1_PROFILE_KEEP) && !rp1_pin_has_func(s.pin, static_cast<uint32_t>(s.func)))
+                errors.emplace_back(std::format("GPIO{} has no function {}", s.pin, s.func));
+            if ((s.pull != RP1_PROFILE_KEEP) && (s.pull != PULL_NONE) && (s.pull != PULL_UP) && (s.pull != PULL_DOWN))
+                errors.emplace_back(std::format("GPIO{}: pull {} is not none, up or down", s.pin, s.pull));
+            if ((s.driveMa != RP1_PROFILE_KEEP) && (s.driveMa != 2) && (s.driveMa != 4) && (s.driveMa != 8) && (s.driveMa != 12))
+                errors.emplace_back(std::format("GPIO{}: drive {} mA is not 2, 4, 8 or 12", s.pin, s.driveMa));
+            if ((s.level != RP1_PROFILE_KEEP) && (s.output != 1))
+                errors.emplace_back(std::format("GPIO{}: a level needs dir=out", s.pin));
+            if ((s.func != RP1_PROFILE_KEEP) && (s.func != GPIO_FUNC_RIO) && (s.output != RP1_PROFILE_KEEP))
+                errors.emplace_back(std::format("GPIO{}: dir needs func=rio, not function {}", s.pin, s.func));
+        }
+        return errors.size() == errorCount;
+    }
+
+    bool RP1PinProfile::plan(const RP1PinProfile_t& profile, const RP1Snapshot_t& current, RP1Snapshot_t& target,
+                             std::vector<std::string>& errors)
+    {
+        const size_t errorCount = errors.size();
+        target = current;
+        RP1BankSnapshot_t& bank = target.bank[0];
+        for (const auto& s : profile.pins)
+        {
+            if (s.pin >= RP1_BANK_PINS[0])
+                continue;
+            const uint32_t bit = 1u << s.pin;
+            uint32_t& ctrl = bank.ctrl[s.pin];
+            uint32_t& pad = bank.pad[s.pin];
+
+            if (s.func != RP1_PROFILE_KEEP)
+                ctrl = (ctrl & ~GpioCtrl::FuncSel::mask) | GpioCtrl::FuncSel::encode(static_cast<uint32_t>(s.func));
+            if ((s.output != RP1_PROFILE_KEEP) && (GpioCtrl::FuncSel::decode(ctrl) != GPIO_FUNC_RIO))
+                errors.emplace_back(std::format("GPIO{}: dir needs func=rio, the pin is on function {}", s.pin,
+                                                GpioCtrl::FuncSel::decode(ctrl)));
+
+            if (s.pull != RP1_PROFILE_KEEP)
+                pad = (pad & ~Pad::Pulls::mask) | Pad::PullUp::encode(s.pull == PULL_UP) | Pad::PullDown::encode(s.pull == PULL_DOWN);
+            if (s.driveMa != RP1_PROFILE_KEEP)
+                pad = (pad & ~Pad::Drive::mask) | Pad::Drive::encode(DriveField(s.driveMa));
+            if (s.slewFast != RP1_PROFILE_KEEP)
+                pad = (pad & ~Pad::SlewFast::mask) | Pad::SlewFast::encode(s.slewFast);
+            if (s.schmitt != RP1_PROFILE_KEEP)
+                pad = (pad & ~Pad::Schmitt::mask) | Pad::Schmitt::encode(s.schmitt);
+
+            // An output pad must not be disabled, an input pad must be enabled
+            if (s.output == 1)
+            {
+                pad &= ~Pad::OutputDisable::mask;
+                bank.rioOE |= bit;
+            }
+            else if (s.output == 0)
+            {
+                pad |= Pad::InputEnable::mask;
+                bank.rioOE &= ~bit;
+            }
+            if (s.level == 1)
+                bank.rioOut |= bit;
+            else if (s.level == 0)
+                bank.rioOut &= ~bit;
+        }
+        return errors.size() == errorCount;
+    }
+
+    uint32_t RP1PinProfile::write(volatile uint32_t *gpio, volatile uint32_t *pad, volatile uint32_t *rio,
+                                  const RP1BankSnapshot_t& current, const RP1BankSnapshot_t& target) noexcept
+    {
+        uint32_t writes = 0;
+
+        // Levels first, so a pin that becomes an output starts at its level
+        const uint32_t outSet = target.rioOut & ~current.rioOut;
+        const uint32_t outClr = current.rioOut & ~target.rioOut;
+        if (outSet)
+        {
+            rp1_set_bits(Rio::Out::at(rio), outSet);
+            ++writes;
+        }
+        if (outClr)
+        {
+            rp1_clr_bits(Rio::Out::at(rio), outClr);
+            ++writes;
+        }
+
+        for (uint32_t pin = 0; pin < RP1_BANK_PINS[0]; ++pin)
+        {
+            if (target.pad[pin] != current.pad[pin])
+            {
+                Pad::Reg::write(pad, pin, target.pad[pin]);
+                ++writes;
+            }
+        }
+
+        // FUNCSEL through NULL (all ones) and down, as RP1Base::setFunction
+        for (uint32_t pin = 0; pin < RP1_BANK_PINS[0]; ++pin)
+        {
+            const uint32_t func = GpioCtrl::FuncSel::decode(target.ctrl[pin]);
+            if (func == GpioCtrl::FuncSel::decode(current.ctrl[pin]))
+                continue;
+            volatile uint32_t *ctrl = GpioCtrl::Reg::at(gpio, pin);
+            rp1_set_bits(ctrl, GpioCtrl::FuncSel::mask);
+            ++writes;
+            const uint32_t clear = GpioCtrl::FuncSel::mask & ~GpioCtrl::FuncSel::encode(func);
+            if (clear != 0)
+            {
+                rp1_clr_bits(ctrl, clear);
+                ++writes;
+            }
+        }
+
+        const uint32_t oeSet = target.rioOE & ~current.rioOE;
+        const uint32_t oeClr = current.rioOE & ~target.rioOE;
+        if (oeSet)
+        {
+            rp1_set_bits(Rio::OE::at(rio), oeSet);
+            ++writes;
+        }
+        if (oeClr)
+        {
+            rp1_clr_bits(Rio::OE::at(rio), oeClr);
+            ++writes;
+        }
+        return writes;
+    }
+
+    std::vector<RP1SnapshotChange_t> RP1PinProfile::verify(const RP1Snapshot_t& target, const RP1Snapshot_t& actual)
+    {
+        std::vector<RP1SnapshotChange_t> mismatches;
+        for (const auto& c : RP1Snapshot::diff(target, actual))
+        {
+            if ((c.bank != 0) || (strcmp(c.reg, "status") == 0))
+                continue;
+            if ((strcmp(c.reg, "rio") == 0) && (strcmp(c.field, "OUT") != 0) && (strcmp(c.field, "OE") != 0))
+                continue;
+            mismatches.push_back(c);
+        }
+        return mismatches;
+    }
+}
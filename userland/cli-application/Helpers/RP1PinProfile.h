@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "RP1Pins.h"
+#include "RP1Snapshot.h"
+
+namespace SB::RPI5
+{
+    constexpr int32_t RP1_PROFILE_KEEP = -1;    // setting not in the profile, pin keeps it
+
+    // Wanted state of one bank 0 pin; every field can be RP1_PROFILE_KEEP.
+    typedef struct
+    {
+        uint32_t pin;
+        int32_t func;           // FUNCSEL 0..8 or RP1_FUNC_NULL
+        int32_t pull;           // PULL_NONE, PULL_UP, PULL_DOWN
+        int32_t driveMa;        // 2, 4, 8, 12
+        int32_t slewFast;       // 0 slow, 1 fast
+        int32_t schmitt;        // input hysteresis 0 / 1
+        int32_t output;         // RIO direction: 0 input, 1 output
+        int32_t level;          // RIO output level 0 / 1, needs output = 1
+    } RP1PinSetting_t;
+
+    typedef struct
+    {
+        std::string name;
+        std::vector<RP1PinSetting_t> pins;
+    } RP1PinProfile_t;
+
+    typedef struct
+    {
+        RP1Snapshot_t before;
+        RP1Snapshot_t target;
+        RP1Snapshot_t after;
+        uint32_t writes;        // register writes of the apply pass
+        uint64_t planNs;        // snapshot, validate and plan
+        uint64_t writeNs;       // the apply pass
+        std::vector<RP1SnapshotChange_t> mismatches;    // target vs after
+    } RP1ProfileResult_t;
+
+    // Declarative pin set-up. A profile is text, one pin per line:
+    //
+    //   # pin   settings (any order, left out = keep)
+    //   4       func=rio dir=out level=0 drive=8 slew=fast
+    //   17      func=rio dir=in pull=up schmitt=on
+    //   GPIO18  func=pwm
+    //
+    // func is rio, proc_rio, pio, pwm (PWM0 on that pin), null, alt0..alt8 or
+    // a FUNCSEL number. A profile can also be a constexpr table of
+    // RP1PinSetting_t. validate() checks it against RP1_BANK0_CAPS, plan()
+    // works out the registers it leads to from a snapshot, and write()
+    // programs only the registers that change in one ordered pass:
+    // RIO Out levels, PAD, FUNCSEL, RIO OE. Pads and FUNCSEL are written
+    // from the planned value, without reading them back first.
+    class RP1PinProfile
+    {
+        public:
+            static bool parse(const std::string& text, RP1PinProfile_t& profile, std::vector<std::string>& errors);
+            static bool load(const std::string& path, RP1PinProfile_t& profile, std::vector<std::string>& errors);
+            static bool validate(const RP1PinProfile_t& profile, std::vector<std::string>& errors);
+
+            // target = current with the profile applied (bank 0 ctrl, pad and RIO Out / OE)
+            static bool plan(const RP1PinProfile_t& profile, const RP1Snapshot_t& current, RP1Snapshot_t& target,
+                             std::vector<std::string>& errors);
+            // Register writes done; plain function on the mapped windows, no tracing
+            static uint32_t write(volatile uint32_t *gpio, volatile uint32_t *pad, volatile uint32_t *rio,
+                                  const RP1BankSnapshot_t& current, const RP1BankSnapshot_t& target) noexcept;
+            // The planned fields the registers do not hold (ctrl, pad, RIO Out / OE)
+            static std::vector<RP1SnapshotChange_t> verify(const RP1Snapshot_t& target, const RP1Snapshot_t& actual);
+
+            static RP1PinSetting_t keep(uint32_t pin);
+    };
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <array>
+#include <stdint.h>
+#include "RP1Fields.h"
+#include "RP1Mapping.h"
+
+namespace SB::RPI5
+{
+    // What a bank 0 pin can do. Every bank 0 pin has the nine alternate
+    // functions a0..a8 (a5 = SYS_RIO, a6 = PROC_RIO, a7 = PIO) and the same
+    // pad: pulls, schmitt trigger, slew and 2/4/8/12 mA drive. PWM0 is on a
+    // few pins only.
+    typedef struct
+    {
+        uint16_t funcs;         // bit n: FUNCSEL n is implemented
+        int8_t pwmFunc;         // FUNCSEL that routes PWM0 to the pin, -1: none
+        int8_t pwmChannel;      // PWM0 channel on that pin, -1: none
+    } RP1PinCaps_t;
+
+    constexpr uint32_t RP1_FUNC_COUNT = 9;
+    constexpr uint32_t RP1_FUNC_NULL = 0x1f;
+    constexpr uint16_t RP1_FUNCS_ALL = (1u << RP1_FUNC_COUNT) - 1;
+
+    constexpr std::array<RP1PinCaps_t, RP1_BANK_PINS[0]> RP1_BANK0_CAPS = []() {
+        std::array<RP1PinCaps_t, RP1_BANK_PINS[0]> caps = {};
+        for (auto& c : caps)
+            c = { RP1_FUNCS_ALL, -1, -1 };
+        caps[12] = { RP1_FUNCS_ALL, 0, 0 };
+        caps[13] = { RP1_FUNCS_ALL, 0, 1 };
+        caps[14] = { RP1_FUNCS_ALL, 0, 2 };
+        caps[15] = { RP1_FUNCS_ALL, 0, 3 };
+        caps[18] = { RP1_FUNCS_ALL, 3, 2 };
+        caps[19] = { RP1_FUNCS_ALL, 3, 3 };
+        return caps;
+    }();
+
+    constexpr bool rp1_pin_has_func(uint32_t pin, uint32_t func)
+    {
+        return (pin < RP1_BANK_PINS[0]) &&
+               ((func == RP1_FUNC_NULL) || ((func < RP1_FUNC_COUNT) && (RP1_BANK0_CAPS[pin].funcs & (1u << func))));
+    }
+
+    // Pins the PWM blocks can drive. PWM0 is on bank 0 (18 / 19 repeat
+    // channels 2 / 3 of 14 / 15 on a3); PWM1 reaches a pin only at GPIO45,
+    // the Pi 5 fan connector. Its other channels still run, for the duty
+    // FIFO or a transaction, they just have no pin.
+    constexpr uint32_t RP1_PWM_BLOCKS = 2;
+    constexpr uint32_t RP1_PWM_CHANNELS = 4;
+
+    typedef struct
+    {
+        uint8_t gpio;
+        uint8_t block;          // 0: PWM0, 1: PWM1
+        uint8_t channel;
+        uint8_t func;           // FUNCSEL that routes the channel to the pin
+    } RP1PwmRoute_t;
+
+    inline constexpr RP1PwmRoute_t RP1_PWM_ROUTES[] = {
+        { 12, 0, 0, 0 }, { 13, 0, 1, 0 }, { 14, 0, 2, 0 }, { 15, 0, 3, 0 },
+        { 18, 0, 2, 3 }, { 19, 0, 3, 3 },
+        { 45, 1, 3, 0 },
+    };
+
+    constexpr const RP1PwmRoute_t *rp1_pwm_route(uint32_t pin)
+    {
+        for (const auto& r : RP1_PWM_ROUTES)
+        {
+            if (r.gpio == pin)
+                return &r;
+        }
+        return nullptr;
+    }
+
+    // Runtime lookups for pins that come from the command line: -1 when the
+    // pin has no PWM channel
+    constexpr int32_t rp1_pwm_block(uint32_t pin)
+    {
+        return (rp1_pwm_route(pin) != nullptr) ? rp1_pwm_route(pin)->block : -1;
+    }
+    constexpr int32_t rp1_pwm_channel(uint32_t pin)
+    {
+        return (rp1_pwm_route(pin) != nullptr) ? rp1_pwm_route(pin)->channel : -1;
+    }
+    constexpr int32_t rp1_pwm_func(uint32_t pin)
+    {
+        return (rp1_pwm_route(pin) != nullptr) ? rp1_pwm_route(pin)->func : -1;
+    }
+
+    // Logical pin 0..53 to its bank and its index inside that bank
+    constexpr bool rp1_pin_location(uint32_t gpio, uint32_t& bank, uint32_t& index)
+    {
+        for (bank = 0; bank < RP1_BANK_COUNT; ++bank)
+        {
+            if (gpio < RP1_BANK_PINS[bank])
+            {
+                index = gpio;
+                return true;
+            }
+            gpio -= RP1_BANK_PINS[bank];
+        }
+        return false;
+    }
+
+    constexpr uint32_t rp1_pin_bank(uint32_t gpio)
+    {
+        uint32_t bank = 0, index = 0;
+        return rp1_pin_location(gpio, bank, index) ? bank : RP1_BANK_COUNT;
+    }
+
+    // Compile-time pin. Bank, index, mask and block offset are constants, so
+    // every access below is one load or store at window + immediate:
+    //
+    //   using Led = RP1Pin<4>;
+    //   Led::output(rio);
+    //   Led::set(rio);
+    //
+    // The windows are the ones RP1Base maps (RIOBase, GPIOBase, PADBase), all
+    // starting at bank 0.
+    template <uint32_t GPIO>
+    struct RP1Pin
+    {
+        static_assert(rp1_pin_bank(GPIO) < RP1_BANK_COUNT, "not an RP1 GPIO (0..53)");
+
+        static constexpr uint32_t gpio = GPIO;
+        static constexpr uint32_t bank = rp1_pin_bank(GPIO);
+        static constexpr uint32_t index = []() { uint32_t b = 0, i = 0; rp1_pin_location(GPIO, b, i); return i; }();
+        static constexpr uint32_t mask = 1u << index;
+        static constexpr size_t block = bank * (RP1_BLOCK_SIZE / 4);    // in words
+
+        [[gnu::always_inline]] static void set(volatile uint32_t *rio) noexcept { rp1_set_bits(Rio::Out::at(rio + block), mask); }
+        [[gnu::always_inline]] static void clear(volatile uint32_t *rio) noexcept { rp1_clr_bits(Rio::Out::at(rio + block), mask); }
+        [[gnu::always_inline]] static void toggle(volatile uint32_t *rio) noexcept { rp1_xor_bits(Rio::Out::at(rio + block), mask); }
+        [[gnu::always_inline]] static void write(volatile uint32_t *rio, bool level) noexcept { level ? set(rio) : clear(rio); }
+        [[gnu::always_inline]] static bool read(const volatile uint32_t *rio) noexcept { return (Rio::In::read(rio + block) & mask) != 0; }
+        [[gnu::always_inline]] static void output(volatile uint32_t *rio) noexcept { rp1_set_bits(Rio::OE::at(rio + block), mask); }
+        [[gnu::always_inline]] static void input(volatile uint32_t *rio) noexcept { rp1_clr_bits(Rio::OE::at(rio + block), mask); }
+
+        [[gnu::always_inline]] static volatile uint32_t *status(volatile uint32_t *gpioBase) noexcept { return GpioStatus::Reg::at(gpioBase + block, index); }
+        [[gnu::always_inline]] static volatile uint32_t *ctrl(volatile uint32_t *gpioBase) noexcept { return GpioCtrl::Reg::at(gpioBase + block, index); }
+        // padBase is the PAD window, + 1 skips VOLTAGE_SELECT
+        [[gnu::always_inline]] static volatile uint32_t *pad(volatile uint32_t *padBase) noexcept { return Pad::Reg::at(padBase + block + 1, index); }
+    };
+
+    // Compile-time PWM pin: RP1PwmPin<17> does not compile.
+    template <uint32_t GPIO>
+    struct RP1PwmPin : RP1Pin<GPIO>
+    {
+        static_assert(rp1_pwm_channel(GPIO) >= 0, "GPIO has no PWM channel (12, 13, 14, 15, 18, 19, 45)");
+
+        static constexpr uint32_t pwmBlock = static_cast<uint32_t>(rp1_pwm_block(GPIO));  // PWM0 / PWM1, not RP1Pin::block
+        static constexpr uint32_t channel = static_cast<uint32_t>(rp1_pwm_channel(GPIO));
+        static constexpr uint32_t func = static_cast<uint32_t>(rp1_pwm_func(GPIO));
+    };
+
+    static_assert((rp1_pin_bank(27) == 0) && (rp1_pin_bank(28) == 1) && (rp1_pin_bank(34) == 2) &&
+                  (rp1_pin_bank(53) == 2) && (rp1_pin_bank(54) == RP1_BANK_COUNT));
+    static_assert(rp1_pin_has_func(18, 3) && (RP1_BANK0_CAPS[18].pwmChannel == 2));
+    static_assert(!rp1_pin_has_func(28, 5) && !rp1_pin_has_func(4, 9));
+    static_assert((rp1_pwm_channel(13) == 1) && (rp1_pwm_func(19) == 3) && (rp1_pwm_channel(17) == -1) && (rp1_pwm_channel(40) == -1));
+    static_assert((RP1Pin<40>::bank == 2) && (RP1Pin<40>::index == 6) && (RP1Pin<29>::mask == 0x2));
+    static_assert((RP1PwmPin<18>::channel == 2) && (RP1PwmPin<18>::func == 3));
+    static_assert((RP1PwmPin<45>::pwmBlock == 1) && (RP1PwmPin<45>::channel == 3) && (rp1_pwm_block(13) == 0));
+    static_assert(RP1PwmPin<45>::block == RP1Pin<45>::block);
+    static_assert([]() {
+        for (const auto& r : RP1_PWM_ROUTES)
+        {
+            if ((r.block >= RP1_PWM_BLOCKS) || (r.channel >= RP1_PWM_CHANNELS) ||
+                ((r.gpio < RP1_BANK_PINS[0]) && (RP1_BANK0_CAPS[r.gpio].pwmChannel != r.channel)))
+                return false;
+        }
+        return true;
+    }(), "RP1_PWM_ROUTES does not match RP1_BANK0_CAPS");
+}
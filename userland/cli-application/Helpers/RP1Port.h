@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "SBRp1IO.h"
+
+namespace SB::RPI5
+{
+    // Logical port: an ordered list of bank 0 RIO pins, bit i of the port
+    // value is pins[i]. A write is one SET and one CLR alias write; the port
+    // value is scattered to RIO bits with one table lookup per port byte. A
+    // read is one In read, gathered back with one lookup per RIO byte. Pins
+    // that are consecutive and ascending skip the tables and use a shift.
+    // Made by RP1IO::port(), which checks the pins.
+    class RP1Port
+    {
+        public:
+            RP1Port() = default;
+            RP1Port(const RP1IO::Fast& io, const std::vector<uint32_t>& pins)
+                : m_io(io), m_pins(pins)
+            {
+                for (size_t i = 0; i < pins.size(); ++i)
+                    m_mask |= 1u << pins[i];
+                m_contiguous = true;
+                for (size_t i = 1; i < pins.size(); ++i)
+                    m_contiguous = m_contiguous && (pins[i] == pins[0] + i);
+                m_shift = pins.empty() ? 0 : pins[0];
+
+                int portBitOf[32];
+                for (uint32_t bit = 0; bit < 32; ++bit)
+                    portBitOf[bit] = -1;
+                for (size_t i = 0; i < pins.size(); ++i)
+                    portBitOf[pins[i]] = static_cast<int>(i);
+
+                for (uint32_t byte = 0; byte < 4; ++byte)
+                {
+                    for (uint32_t v = 0; v < 256; ++v)
+                    {
+                        uint32_t rio = 0, port = 0;
+                        for (uint32_t b = 0; b < 8; ++b)
+                        {
+                            if (!(v & (1u << b)))
+                                continue;
+                            const uint32_t bit = byte * 8 + b;
+                            if (bit < pins.size())
+                                rio |= 1u << pins[bit];
+                            if (portBitOf[bit] >= 0)
+                                port |= 1u << portBitOf[bit];
+                        }
+                        m_scatter[byte][v] = rio;
+                        m_gather[byte][v] = port;
+                    }
+                }
+            }
+
+            bool valid() const noexcept { return m_io.valid() && !m_pins.empty(); }
+            size_t width() const noexcept { return m_pins.size(); }
+            uint32_t mask() const noexcept { return m_mask; }
+            const std::vector<uint32_t>& pins() const noexcept { return m_pins; }
+
+            [[gnu::always_inline]] uint32_t scatter(uint32_t value) const noexcept
+            {
+                if (m_contiguous)
+                    return (value << m_shift) & m_mask;
+                return m_scatter[0][value & 0xff] | m_scatter[1][(value >> 8) & 0xff] |
+                       m_scatter[2][(value >> 16) & 0xff] | m_scatter[3][value >> 24];
+            }
+            [[gnu::always_inline]] uint32_t gather(uint32_t rio) const noexcept
+            {
+                if (m_contiguous)
+                    return (rio & m_mask) >> m_shift;
+                return m_gather[0][rio & 0xff] | m_gather[1][(rio >> 8) & 0xff] |
+                       m_gather[2][(rio >> 16) & 0xff] | m_gather[3][rio >> 24];
+            }
+
+            [[gnu::always_inline]] void write(uint32_t value) const noexcept { m_io.write(m_mask, scatter(value)); }
+            [[gnu::always_inline]] uint32_t read() const noexcept { return gather(m_io.read()); }
+            [[gnu::always_inline]] uint32_t readOut() const noexcept { return gather(m_io.readOut()); }
+
+            void output() const noexcept { m_io.output(m_mask); }
+            void input() const noexcept { m_io.input(m_mask); }
+
+        private:
+            RP1IO::Fast m_io;
+            std::vector<uint32_t> m_pins;
+            uint32_t m_mask = 0;
+            bool m_contiguous = false;
+            uint32_t m_shift = 0;
+            std::array<std::array<uint32_t, 256>, 4> m_scatter = {};
+            std::array<std::array<uint32_t, 256>, 4> m_gather = {};
+    };
+}
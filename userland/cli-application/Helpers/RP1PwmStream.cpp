@@ -0,0 +1,246 @@
+#include "RP1PwmStream.h"
+#include "RP1Fields.h"
+#include "RP1Timer.h"
+#include "RP1Wait.h"
+#include "SBDelay.h"
+#include "../Tracer/cfunctracer.h"
+#include <algorithm>
+#include <bit>
+#include <format>
+
+namespace SB::RPI5
+{
+    RP1PwmStream::RP1PwmStream(std::shared_ptr<CTracer> tracer)
+        : m_trace(tracer)
+    {
+        CFuncTracer trace("RP1PwmStream::RP1PwmStream", m_trace);
+    }
+    RP1PwmStream::~RP1PwmStream()
+    {
+        CFuncTracer trace("RP1PwmStream::~RP1PwmStream", m_trace);
+        if (m_bRunning)
+            stop();
+    }
+
+    bool RP1PwmStream::start(const RP1PwmStreamConfig_t& config, RP1PWM& pwm)
+    {
+        CFuncTracer trace("RP1PwmStream::start", m_trace);
+        try
+        {
+            if (m_bRunning || (config.sampleRate == 0) || (config.queueSamples == 0))
+            {
+                trace.Error("cannot start (running %d, rate %u, queue %ld)", m_bRunning, config.sampleRate, config.queueSamples);
+                return false;
+            }
+            const int block = rp1_pwm_block(config.pin);
+            m_fifoCtrl = (block >= 0) ? pwm.fifoCtrlReg(block) : nullptr;
+            m_dutyFifo = (block >= 0) ? pwm.dutyFifoReg(block) : nullptr;
+            if ((m_fifoCtrl == nullptr) || (m_dutyFifo == nullptr))
+            {
+                trace.Error("GPIO%u has no PWM channel or its PWM block is not mapped", config.pin);
+                return false;
+            }
+            m_config = config;
+            m_config.threshold = std::clamp<uint32_t>(config.threshold, 1, PwmFifoCtrl::DEPTH);
+            m_report = {};
+            m_bStop = false;
+            m_head = m_tail = 0;
+            m_samples = m_underruns = m_starved = m_refills = 0;
+            m_maxGapNs = m_latencySumNs = m_maxLatencyNs = 0;
+
+            // Written once here, so neither side faults a page in
+            const size_t size = std::bit_ceil(config.queueSamples);
+            m_ring.assign(size, 0);
+            m_ringMask = size - 1;
+
+            if (!pwm.fifoAttach(config.pin, config.sampleRate, m_range))
+            {
+                trace.Error("cannot put GPIO%u on the duty FIFO", config.pin);
+                return false;
+            }
+            m_pwm = &pwm;
+            m_periodNs = 1000000000ull / config.sampleRate;
+
+            SBRealtime::resolveCpu(m_config.realtime, m_report);
+            m_refiller = std::thread([this]() {
+                SBRealtime::applyToThisThread(m_config.realtime, m_report);
+                refill();
+            });
+            m_bRunning = true;
+            trace.Info("GPIO%u streaming at %u Hz, range %u, %ld word queue", config.pin, config.sampleRate, m_range, size);
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    bool RP1PwmStream::stop()
+    {
+        CFuncTracer trace("RP1PwmStream::stop", m_trace);
+        try
+        {
+            if (!m_bRunning)
+                return false;
+            m_bStop.store(true);
+            m_refiller.join();
+            m_bRunning = false;
+            bool bOk = m_pwm->fifoDetach(m_config.pin);
+            for (const auto& w : m_report.warnings)
+                trace.Warning("%s", w.c_str());
+            trace.Info("%s", formatStats(stats()).c_str());
+            return bOk;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    void RP1PwmStream::refill()
+    {
+        const uint32_t *ring = m_ring.data();
+        const uint64_t ringMask = m_ringMask;
+        const uint32_t threshold = m_config.threshold;
+        const uint64_t freq = rp1_tick_freq();
+
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        uint64_t sinceEmpty = 0;        // words written since the FIFO was last seen empty
+        bool bStarved = false;
+        uint64_t last = rp1_ticks();
+        while (!m_bStop.load(std::memory_order_relaxed))
+        {
+            const uint32_t level = std::min(PwmFifoCtrl::Level::decode(rp1_read(m_fifoCtrl)), PwmFifoCtrl::DEPTH);
+            const uint32_t room = PwmFifoCtrl::DEPTH - level;
+            if (head - tail < room)
+                head = m_head.load(std::memory_order_acquire);
+
+            // Empty while words were waiting in the queue: we came too late.
+            // Empty with an empty queue is the producer's doing (starved).
+            if ((level == 0) && (sinceEmpty > 0) && (head != tail)) [[unlikely]]
+                m_underruns.fetch_add(1, std::memory_order_relaxed);
+
+            uint32_t n = 0;
+            while ((n < room) && (tail != head))
+            {
+                rp1_write(m_dutyFifo, ring[tail & ringMask]);
+                ++tail;
+                ++n;
+            }
+            if (n != 0)
+            {
+                m_tail.store(tail, std::memory_order_release);
+                m_samples.fetch_add(n, std::memory_order_relaxed);
+            }
+            sinceEmpty = (level == 0) ? n : sinceEmpty + n;
+
+            const bool bNowStarved = (n < room) && (level + n < threshold);
+            if (bNowStarved && !bStarved)
+                m_starved.fetch_add(1, std::memory_order_relaxed);
+            bStarved = bNowStarved;
+
+            const uint64_t now = rp1_ticks();
+            const uint64_t gap = rp1_ticks_to_ns(now - last, freq);
+            last = now;
+            if (gap > m_maxGapNs.load(std::memory_order_relaxed))
+                m_maxGapNs.store(gap, std::memory_order_relaxed);
+            const uint64_t latency = (head - tail + level + n) * m_periodNs;
+            m_latencySumNs.fetch_add(latency, std::memory_order_relaxed);
+            if (latency > m_maxLatencyNs.load(std::memory_order_relaxed))
+                m_maxLatencyNs.store(latency, std::memory_order_relaxed);
+            m_refills.fetch_add(1, std::memory_order_relaxed);
+
+            // Back when the FIFO has drained to the threshold
+            const uint32_t ahead = level + n;
+            SBDelay::ns(((ahead > threshold) ? ahead - threshold : 1) * m_periodNs);
+        }
+    }
+
+    size_t RP1PwmStream::space() const
+    {
+        return m_ring.size() - queued();
+    }
+
+    size_t RP1PwmStream::queued() const
+    {
+        return static_cast<size_t>(m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire));
+    }
+
+    size_t RP1PwmStream::push(const uint32_t *duty, size_t count) noexcept
+    {
+        if (!m_bRunning || (duty == nullptr))
+            return 0;
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        const uint64_t tail = m_tail.load(std::memory_order_acquire);
+        const size_t n = std::min<size_t>(count, m_ring.size() - (head - tail));
+        for (size_t i = 0; i < n; ++i)
+            m_ring[(head + i) & m_ringMask] = std::min(duty[i], m_range);
+        m_head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t RP1PwmStream::pushQ16(const uint16_t *q16, size_t count) noexcept
+    {
+        if (!m_bRunning || (q16 == nullptr))
+            return 0;
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        const uint64_t tail = m_tail.load(std::memory_order_acquire);
+        const size_t n = std::min<size_t>(count, m_ring.size() - (head - tail));
+        const uint64_t scale = static_cast<uint64_t>(m_range) + 1;
+        for (size_t i = 0; i < n; ++i)
+            m_ring[(head + i) & m_ringMask] = static_cast<uint32_t>((q16[i] * scale) >> 16);
+        m_head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    bool RP1PwmStream::drain(uint64_t timeoutNs)
+    {
+        CFuncTracer trace("RP1PwmStream::drain", m_trace);
+        if (!m_bRunning)
+            return false;
+        const uint64_t deadline = SBDelay::nowNs() + timeoutNs;
+        while (queued() != 0)
+        {
+            if (SBDelay::nowNs() >= deadline)
+            {
+                trace.Error("%ld words still queued", queued());
+                return false;
+            }
+            SBDelay::ns(m_periodNs * PwmFifoCtrl::DEPTH / 2);
+        }
+        // and the FIFO itself
+        const uint64_t now = SBDelay::nowNs();
+        RP1WaitResult_t result;
+        if (!RP1Wait::waitForBits(m_fifoCtrl, PwmFifoCtrl::Level::mask, 0, (deadline > now) ? deadline - now : 0, result))
+        {
+            trace.Error("DUTY_FIFO still holds %u words", PwmFifoCtrl::Level::decode(result.value));
+            return false;
+        }
+        return true;
+    }
+
+    RP1PwmStreamStats_t RP1PwmStream::stats() const
+    {
+        RP1PwmStreamStats_t st = {};
+        st.samples = m_samples.load(std::memory_order_relaxed);
+        st.underruns = m_underruns.load(std::memory_order_relaxed);
+        st.starved = m_starved.load(std::memory_order_relaxed);
+        st.refills = m_refills.load(std::memory_order_relaxed);
+        st.maxRefillGapNs = m_maxGapNs.load(std::memory_order_relaxed);
+        st.meanLatencyNs = (st.refills != 0) ? m_latencySumNs.load(std::memory_order_relaxed) / st.refills : 0;
+        st.maxLatencyNs = m_maxLatencyNs.load(std::memory_order_relaxed);
+        return st;
+    }
+
+    std::string RP1PwmStream::formatStats(const RP1PwmStreamStats_t& stats)
+    {
+        return std::format("{} samples, {} refills, {} underruns, {} starved, max refill gap {} ns, "
+                           "latency mean {} ns / max {} ns",
+                           stats.samples, stats.refills, stats.underruns, stats.starved, stats.maxRefillGapNs,
+                           stats.meanLatencyNs, stats.maxLatencyNs);
+    }
+}
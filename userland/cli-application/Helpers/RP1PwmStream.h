@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Tracer/ctracer.h"
+#include "SBRealtime.h"
+#include "SBRP1Pwm.h"
+
+namespace SB::RPI5
+{
+    typedef struct
+    {
+        uint32_t pin;                   // PWM pin (12, 13, 14, 15, 18, 19 on PWM0, 45 on PWM1)
+        uint32_t sampleRate;            // duty words per second (= PWM frequency)
+        size_t queueSamples;            // producer queue, rounded up to a power of two
+        uint32_t threshold;             // refill when the FIFO holds fewer words (1..DEPTH)
+        SBRealtimeConfig_t realtime;    // cpu / priority of the refill thread
+    } RP1PwmStreamConfig_t;
+
+    typedef struct
+    {
+        uint64_t samples;       // words written to DUTY_FIFO
+        uint64_t underruns;     // refill found the FIFO empty: the PWM repeated its last duty
+        uint64_t starved;       // refill had room but the producer queue was empty
+        uint64_t refills;
+        uint64_t maxRefillGapNs;    // longest time between two refills
+        uint64_t meanLatencyNs;     // queued + FIFO words at refill, as time: push to output
+        uint64_t maxLatencyNs;
+    } RP1PwmStreamStats_t;
+
+    // Duty FIFO streaming. The producer pushes duty words into a single
+    // producer / single consumer ring (no locks, push never blocks); a refill
+    // thread keeps DUTY_FIFO above the threshold and sleeps for the time the
+    // FIFO needs to drain down to it. The PWM pops one word per period, so
+    // the output rate is the PWM's own and does not depend on when the CPU
+    // gets around to writing.
+    class RP1PwmStream
+    {
+        public:
+            RP1PwmStream(std::shared_ptr<CTracer> tracer);
+            virtual ~RP1PwmStream();
+
+            bool start(const RP1PwmStreamConfig_t& config, RP1PWM& pwm);
+            bool stop();
+            bool running() const { return m_bRunning; }
+
+            uint32_t range() const { return m_range; }      // duty word for 100 %
+            size_t space() const;                           // words push() takes now
+            size_t queued() const;
+            // Words accepted (all, or as many as there was room for)
+            size_t push(const uint32_t *duty, size_t count) noexcept;
+            // Q16 samples (see RP1Wavetable.h), scaled to range
+            size_t pushQ16(const uint16_t *q16, size_t count) noexcept;
+            // Wait until the queue is empty, false on timeout
+            bool drain(uint64_t timeoutNs);
+
+            RP1PwmStreamStats_t stats() const;
+            const SBRealtimeReport_t& realtimeReport() const { return m_report; }
+            static std::string formatStats(const RP1PwmStreamStats_t& stats);
+
+        private:
+            void refill();
+
+            std::shared_ptr<CTracer> m_trace;
+            RP1PwmStreamConfig_t m_config = {};
+            SBRealtimeReport_t m_report = {};
+            RP1PWM *m_pwm = nullptr;
+            volatile uint32_t *m_fifoCtrl = nullptr;
+            volatile uint32_t *m_dutyFifo = nullptr;
+            uint32_t m_range = 0;
+            uint64_t m_periodNs = 0;
+            std::thread m_refiller;
+            std::atomic<bool> m_bStop { false };
+            bool m_bRunning = false;
+
+            std::vector<uint32_t> m_ring;
+            uint64_t m_ringMask = 0;
+            alignas(64) std::atomic<uint64_t> m_head { 0 };    // written by the producer
+            alignas(64) std::atomic<uint64_t> m_tail { 0 };    // written by the refill thread
+
+            alignas(64) std::atomic<uint64_t> m_samples { 0 };
+            std::atomic<uint64_t> m_underruns { 0 };
+            std::atomic<uint64_t> m_starved { 0 };
+            std::atomic<uint64_t> m_refills { 0 };
+            std::atomic<uint64_t> m_maxGapNs { 0 };
+            std::atomic<uint64_t> m_latencySumNs { 0 };
+            std::atomic<uint64_t> m_maxLatencyNs { 0 };
+    };
+}
@@ -0,0 +1,102 @@
+#include "RP1PwmTransaction.h"
+
+namespace SB::RPI5
+{
+    RP1PwmTransaction::RP1PwmTransaction(volatile uint32_t *pwm0, volatile uint32_t *pwm1) noexcept
+        : m_block{ pwm0, pwm1 }
+    {
+    }
+
+    bool RP1PwmTransaction::stage(uint32_t block, uint32_t channel, uint32_t reg, uint32_t value) noexcept
+    {
+        if (!usable(block, channel))
+            return false;
+        Channel_t& c = m_chan[block][channel];
+        c.value[reg] = value;
+        c.dirty |= 1u << reg;
+        m_touched |= 1u << block;
+        return true;
+    }
+
+    bool RP1PwmTransaction::ctrl(uint32_t block, uint32_t channel, uint32_t mask, uint32_t value) noexcept
+    {
+        if (!usable(block, channel))
+            return false;
+        Channel_t& c = m_chan[block][channel];
+        c.ctrlMask |= mask;
+        c.ctrlValue = (c.ctrlValue & ~mask) | (value & mask);
+        m_touched |= 1u << block;
+        return true;
+    }
+
+    bool RP1PwmTransaction::enable(uint32_t block, uint32_t channel, bool bEnable) noexcept
+    {
+        if (!usable(block, channel))
+            return false;
+        const uint32_t bit = PwmGlobal::ChanEnable::encode(1u << channel);
+        m_enableMask[block] |= bit;
+        m_enableValue[block] = bEnable ? (m_enableValue[block] | bit) : (m_enableValue[block] & ~bit);
+        m_touched |= 1u << block;
+        return true;
+    }
+
+    uint32_t RP1PwmTransaction::commit() noexcept
+    {
+        uint32_t writes = 0;
+        for (uint32_t b = 0; b < BLOCKS; ++b)
+        {
+            if ((m_touched & (1u << b)) == 0)
+                continue;
+            volatile uint32_t *base = m_block[b];
+            for (uint32_t ch = 0; ch < CHANNELS; ++ch)
+            {
+                const Channel_t& c = m_chan[b][ch];
+                if (c.ctrlMask != 0)
+                {
+                    volatile uint32_t *reg = PwmChan::Ctrl::at(base, ch);
+                    rp1_write(reg, (rp1_read(reg) & ~c.ctrlMask) | c.ctrlValue);
+                    ++writes;
+                }
+                if (c.dirty & (1u << RANGE))
+                {
+                    PwmChan::Range::write(base, ch, c.value[RANGE]);
+                    ++writes;
+                }
+                if (c.dirty & (1u << PHASE))
+                {
+                    PwmChan::Phase::write(base, ch, c.value[PHASE]);
+                    ++writes;
+                }
+                if (c.dirty & (1u << DUTY))
+                {
+                    PwmChan::Duty::write(base, ch, c.value[DUTY]);
+                    ++writes;
+                }
+            }
+            // channel registers must be visible before SET_UPDATE latches them
+            rp1_wmb();
+            volatile uint32_t *global = PwmGlobal::Reg::at(base);
+            rp1_write(global, (rp1_read(global) & ~m_enableMask[b]) | m_enableValue[b] | PwmGlobal::SetUpdate::mask);
+            ++writes;
+        }
+        clear();
+        return writes;
+    }
+
+    void RP1PwmTransaction::clear() noexcept
+    {
+        for (auto& block : m_chan)
+        {
+            for (auto& c : block)
+                c = {};
+        }
+        for (uint32_t b = 0; b < BLOCKS; ++b)
+            m_enableMask[b] = m_enableValue[b] = 0;
+        m_touched = 0;
+    }
+
+    bool RP1PwmTransaction::empty() const noexcept
+    {
+        return m_touched == 0;
+    }
+}
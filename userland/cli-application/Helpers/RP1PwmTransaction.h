@@ -0,0 +1,100 @@
+#pragma once
+#include <stdint.h>
+#include "RP1Fields.h"
+#include "RP1Pins.h"
+#include "SBRP1Pwm.h"
+
+namespace SB::RPI5
+{
+    // Staged channel changes for both PWM blocks, committed with one
+    // SET_UPDATE per block: every channel written in the transaction switches
+    // on its next period boundary together, instead of one apply per call as
+    // setRangeDutyPhase() does. Staging only fills this object; commit() is
+    // the only part that touches registers and does no tracing, so a control
+    // loop can keep one transaction and reuse it every cycle.
+    //
+    // The two blocks have separate SET_UPDATE bits; with both touched, PWM0
+    // is committed first and PWM1 one register write later.
+    class RP1PwmTransaction
+    {
+        public:
+            static constexpr uint32_t BLOCKS = RP1_PWM_BLOCKS;
+            static constexpr uint32_t CHANNELS = RP1_PWM_CHANNELS;
+
+            explicit RP1PwmTransaction(RP1PWM& pwm) noexcept
+                : RP1PwmTransaction(pwm.PWMBase(0), pwm.PWMBase(1))
+            {
+            }
+            RP1PwmTransaction(volatile uint32_t *pwm0, volatile uint32_t *pwm1) noexcept;
+
+            // false for a block / channel out of range or a block not mapped
+            bool range(uint32_t block, uint32_t channel, uint32_t value) noexcept { return stage(block, channel, RANGE, value); }
+            bool duty(uint32_t block, uint32_t channel, uint32_t value) noexcept { return stage(block, channel, DUTY, value); }
+            bool phase(uint32_t block, uint32_t channel, uint32_t value) noexcept { return stage(block, channel, PHASE, value); }
+            bool set(uint32_t block, uint32_t channel, uint32_t rangeValue, uint32_t dutyValue, uint32_t phaseValue) noexcept
+            {
+                return range(block, channel, rangeValue) && duty(block, channel, dutyValue) && phase(block, channel, phaseValue);
+            }
+            // CHAN_CTRL fields, merged into the register at commit
+            bool mode(uint32_t block, uint32_t channel, pwm_mode value) noexcept
+            {
+                return ctrl(block, channel, PwmChan::Mode::mask, PwmChan::Mode::encode(static_cast<uint32_t>(value)));
+            }
+            bool invert(uint32_t block, uint32_t channel, bool bInvert) noexcept
+            {
+                return ctrl(block, channel, PwmChan::Invert::mask, PwmChan::Invert::encode(bInvert ? 1 : 0));
+            }
+            // GLOBAL_CTRL CHAN_EN only, written together with SET_UPDATE;
+            // CHAN_CTRL MODE is left as it is, stage mode() to change it
+            bool enable(uint32_t block, uint32_t channel, bool bEnable) noexcept;
+
+            // Pins known at compile time
+            template <uint32_t GPIO> bool range(RP1PwmPin<GPIO>, uint32_t value) noexcept
+            {
+                return range(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, value);
+            }
+            template <uint32_t GPIO> bool duty(RP1PwmPin<GPIO>, uint32_t value) noexcept
+            {
+                return duty(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, value);
+            }
+            template <uint32_t GPIO> bool phase(RP1PwmPin<GPIO>, uint32_t value) noexcept
+            {
+                return phase(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, value);
+            }
+            template <uint32_t GPIO> bool set(RP1PwmPin<GPIO>, uint32_t rangeValue, uint32_t dutyValue, uint32_t phaseValue) noexcept
+            {
+                return set(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, rangeValue, dutyValue, phaseValue);
+            }
+
+            // Writes the staged registers, then one GLOBAL_CTRL write with
+            // SET_UPDATE per touched block. Returns the register writes done
+            // and leaves the transaction empty.
+            uint32_t commit() noexcept;
+            void clear() noexcept;
+            bool empty() const noexcept;
+
+        private:
+            enum : uint32_t { RANGE = 0, DUTY = 1, PHASE = 2 };
+
+            typedef struct
+            {
+                uint32_t dirty;         // bit per RANGE / DUTY / PHASE
+                uint32_t value[3];
+                uint32_t ctrlMask;
+                uint32_t ctrlValue;
+            } Channel_t;
+
+            bool stage(uint32_t block, uint32_t channel, uint32_t reg, uint32_t value) noexcept;
+            bool ctrl(uint32_t block, uint32_t channel, uint32_t mask, uint32_t value) noexcept;
+            bool usable(uint32_t block, uint32_t channel) const noexcept
+            {
+                return (block < BLOCKS) && (channel < CHANNELS) && (m_block[block] != nullptr);
+            }
+
+            volatile uint32_t *m_block[BLOCKS];
+            Channel_t m_chan[BLOCKS][CHANNELS] = {};
+            uint32_t m_enableMask[BLOCKS] = {};
+            uint32_t m_enableValue[BLOCKS] = {};
+            uint32_t m_touched = 0;     // bit per block
+    };
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#ifdef RP1_SIMULATOR
+#include "RP1Sim.h"
+#endif
+
+namespace SB::RPI5
+{
+    // All RP1 register accesses go through these helpers. On the Pi they are a
+    // plain volatile load/store. A build with RP1_SIMULATOR diverts stores to the
+    // simulator while the simulated backend is active (one predictable branch,
+    // no virtual dispatch).
+    [[gnu::always_inline]] inline uint32_t rp1_read(const volatile uint32_t* reg) noexcept
+    {
+        return *reg;
+    }
+
+    [[gnu::always_inline]] inline void rp1_write(volatile uint32_t* reg, uint32_t value) noexcept
+    {
+#ifdef RP1_SIMULATOR
+        if (RP1Sim::active()) [[unlikely]]
+        {
+            RP1Sim::write(reg, value);
+            return;
+        }
+#endif
+        *reg = value;
+    }
+
+    // Ordering between RP1 accesses. The mapping is Device memory, so accesses to
+    // one block already stay in order; these are for ordering across blocks
+    // (e.g. clock divider before PWM channel, data before an update/apply bit)
+    // and against normal memory (buffers shared with another thread).
+    [[gnu::always_inline]] inline void rp1_wmb() noexcept
+    {
+#if defined(__aarch64__)
+        asm volatile("dmb oshst" ::: "memory");
+#else
+        std::atomic_thread_fence(std::memory_order_release);
+#endif
+    }
+    [[gnu::always_inline]] inline void rp1_rmb() noexcept
+    {
+#if defined(__aarch64__)
+        asm volatile("dmb oshld" ::: "memory");
+#else
+        std::atomic_thread_fence(std::memory_order_acquire);
+#endif
+    }
+    [[gnu::always_inline]] inline void rp1_mb() noexcept
+    {
+#if defined(__aarch64__)
+        asm volatile("dmb osh" ::: "memory");
+#else
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+    }
+}
@@ -0,0 +1,171 @@
+#include "RP1Sim.h"
+#include "RP1Fields.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        constexpr uint32_t RIO_OUT = 0x0;
+        constexpr uint32_t RIO_OE = 0x4;
+        constexpr uint32_t RIO_IN = 0x8;
+        constexpr uint32_t RIO_INSYNC = 0xc;
+        constexpr uint32_t PWM_GLOBAL_CTRL = 0x0;
+        constexpr uint32_t PWM_SET_UPDATE = 0x80000000u;
+        constexpr uint32_t PWM_FIFO_CTRL = 0x4;
+        constexpr uint32_t PWM_DUTY_FIFO = 0x10;
+
+        constexpr uint32_t GPIO_CTRL_RESET = 0x0000001fu;   // FUNCSEL = NULL
+        constexpr uint32_t PAD_RESET = 0x00000056u;         // IE | 4mA | pull-down | schmitt
+    }
+
+    std::atomic<bool> RP1Sim::s_active{ false };
+    uint32_t *RP1Sim::s_window[static_cast<int>(eRp1Window::Count)] = {};
+    std::atomic<uint32_t> RP1Sim::s_inputs[RP1_BANK_COUNT] = {};
+
+    void RP1Sim::write(volatile uint32_t* reg, uint32_t value) noexcept
+    {
+        uintptr_t addr = reinterpret_cast<uintptr_t>(reg);
+        for (int i = 0; i < static_cast<int>(eRp1Window::Count); ++i)
+        {
+            uintptr_t base = reinterpret_cast<uintptr_t>(s_window[i]);
+            if ((base == 0) || (addr < base) || (addr >= base + RP1_WINDOWS[i].size))
+                continue;
+
+            uintptr_t offset = addr - base;
+            uintptr_t block = offset & ~static_cast<uintptr_t>(RP1_BLOCK_SIZE - 1);
+            uint32_t alias = static_cast<uint32_t>(offset >> 12) & 0x3;
+            uint32_t regOffset = static_cast<uint32_t>(offset) & 0xfff;
+
+            std::atomic_ref<uint32_t> target(*reinterpret_cast<uint32_t*>(base + block + regOffset));
+            const bool bPwm = (i == static_cast<int>(eRp1Window::Pwm0)) || (i == static_cast<int>(eRp1Window::Pwm1));
+            const uint32_t before = target.load();
+            switch (alias)
+            {
+                case 0: target.store(value); break;
+                case 1: target.fetch_xor(value); break;
+                case 2: target.fetch_or(value); break;
+                case 3: target.fetch_and(~value); break;
+            }
+
+            if ((i == static_cast<int>(eRp1Window::Rio)) && ((regOffset == RIO_OUT) || (regOffset == RIO_OE)))
+                updateRioInputs(static_cast<uint32_t>(block / RP1_BLOCK_SIZE));
+
+            if (bPwm && (regOffset == PWM_GLOBAL_CTRL))
+                target.fetch_and(~PWM_SET_UPDATE);
+
+            if (bPwm && (regOffset == PWM_FIFO_CTRL))
+            {
+                // LEVEL is read only, FLUSH empties the FIFO and reports FLUSH_DONE
+                uint32_t value = target.load();
+                uint32_t level = before & PwmFifoCtrl::Level::mask;
+                if (value & PwmFifoCtrl::Flush::mask)
+                {
+                    level = 0;
+                    value = (value & ~PwmFifoCtrl::Flush::mask) | PwmFifoCtrl::FlushDone::mask;
+                }
+                target.store((value & ~PwmFifoCtrl::Level::mask) | level);
+            }
+
+            if (bPwm && (regOffset == PWM_DUTY_FIFO))
+            {
+                // One more word queued; a full FIFO drops it, as the chip does
+                std::atomic_ref<uint32_t> ctrl(*reinterpret_cast<uint32_t*>(base + block + PWM_FIFO_CTRL));
+                uint32_t current = ctrl.load();
+                while ((PwmFifoCtrl::Level::decode(current) < PwmFifoCtrl::DEPTH) &&
+                       !ctrl.compare_exchange_weak(current, current + 1))
+                {
+                }
+            }
+            return;
+        }
+
+        // Not a simulated register (e.g. a real mapping next to the simulator)
+        *reg = value;
+    }
+
+    void RP1Sim::attach(uint32_t* const windows[static_cast<int>(eRp1Window::Count)])
+    {
+        for (int i = 0; i < static_cast<int>(eRp1Window::Count); ++i)
+            s_window[i] = windows[i];
+        reset();
+        s_active.store(true);
+    }
+
+    void RP1Sim::detach()
+    {
+        s_active.store(false);
+        for (int i = 0; i < static_cast<int>(eRp1Window::Count); ++i)
+            s_window[i] = nullptr;
+    }
+
+    void RP1Sim::reset()
+    {
+        for (int i = 0; i < static_cast<int>(eRp1Window::Count); ++i)
+        {
+            if (s_window[i] != nullptr)
+                std::memset(s_window[i], 0, RP1_WINDOWS[i].size);
+        }
+
+        for (uint32_t bank = 0; bank < RP1_BANK_COUNT; ++bank)
+        {
+            s_inputs[bank].store(0);
+            uint32_t *gpio = s_window[static_cast<int>(eRp1Window::Gpio)];
+            uint32_t *pad = s_window[static_cast<int>(eRp1Window::Pad)];
+            for (uint32_t pin = 0; pin < RP1_BANK_PINS[bank]; ++pin)
+            {
+                if (gpio != nullptr)
+                    gpio[(bank * RP1_BLOCK_SIZE) / 4 + pin * 2 + 1] = GPIO_CTRL_RESET;
+                if (pad != nullptr)
+                    pad[(bank * RP1_BLOCK_SIZE) / 4 + 1 + pin] = PAD_RESET;
+            }
+        }
+    }
+
+    void RP1Sim::setInputs(uint32_t bank, uint32_t mask, uint32_t value) noexcept
+    {
+        if (bank >= RP1_BANK_COUNT)
+            return;
+        uint32_t current = s_inputs[bank].load();
+        while (!s_inputs[bank].compare_exchange_weak(current, (current & ~mask) | (value & mask)))
+        {
+        }
+        updateRioInputs(bank);
+    }
+
+    uint32_t RP1Sim::popPwmFifo(uint32_t pwm, uint32_t count) noexcept
+    {
+        int i = (pwm == 0) ? static_cast<int>(eRp1Window::Pwm0) : static_cast<int>(eRp1Window::Pwm1);
+        if ((pwm > 1) || (s_window[i] == nullptr))
+            return 0;
+        std::atomic_ref<uint32_t> ctrl(s_window[i][PWM_FIFO_CTRL / 4]);
+        uint32_t current = ctrl.load();
+        uint32_t popped = 0;
+        do
+        {
+            popped = std::min(count, PwmFifoCtrl::Level::decode(current));
+        } while ((popped != 0) && !ctrl.compare_exchange_weak(current, current - popped));
+        return popped;
+    }
+
+    uint32_t RP1Sim::getInputs(uint32_t bank) noexcept
+    {
+        return (bank < RP1_BANK_COUNT) ? s_inputs[bank].load() : 0;
+    }
+
+    void RP1Sim::updateRioInputs(uint32_t bank) noexcept
+    {
+        uint32_t *rio = s_window[static_cast<int>(eRp1Window::Rio)];
+        if ((rio == nullptr) || (bank >= RP1_BANK_COUNT))
+            return;
+
+        uint32_t *regs = rio + (bank * RP1_BLOCK_SIZE) / 4;
+        uint32_t out = std::atomic_ref<uint32_t>(regs[RIO_OUT / 4]).load();
+        uint32_t oe = std::atomic_ref<uint32_t>(regs[RIO_OE / 4]).load();
+        uint32_t in = (out & oe) | (s_inputs[bank].load() & ~oe);
+        std::atomic_ref<uint32_t>(regs[RIO_IN / 4]).store(in);
+        std::atomic_ref<uint32_t>(regs[RIO_INSYNC / 4]).store(in);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "RP1Mapping.h"
+
+namespace SB::RPI5
+{
+    // In-memory RP1 used by the eRp1Backend::Simulated mapping. The register
+    // windows are plain anonymous memory; stores are routed here by rp1_write()
+    // (only when the tree is built with RP1_SIMULATOR) so the XOR/SET/CLR alias
+    // windows at +0x1000/+0x2000/+0x3000 of every block behave like on the chip:
+    //   - alias stores atomically xor/or/and-not into the base register,
+    //   - RIO IN/INSYNC follow OUT where OE is set and the external inputs elsewhere,
+    //   - the PWM GLOBAL_CTRL SET_UPDATE bit (31) self-clears,
+    //   - DUTY_FIFO stores raise the FIFO_CTRL level (up to the depth) and
+    //     FLUSH empties it; nothing drains it but popPwmFifo().
+    class RP1Sim
+    {
+        public:
+            static bool active() noexcept { return s_active.load(std::memory_order_relaxed); }
+            static void write(volatile uint32_t* reg, uint32_t value) noexcept;
+
+            static void attach(uint32_t* const windows[static_cast<int>(eRp1Window::Count)]);
+            static void detach();
+            static void reset();
+
+            // Drive the level of the (simulated) external signals on a bank.
+            static void setInputs(uint32_t bank, uint32_t mask, uint32_t value) noexcept;
+            static uint32_t getInputs(uint32_t bank) noexcept;
+            // Let the (simulated) PWM consume up to count duty words; returns the
+            // number taken from the FIFO
+            static uint32_t popPwmFifo(uint32_t pwm, uint32_t count) noexcept;
+
+        private:
+            static void updateRioInputs(uint32_t bank) noexcept;
+
+            static std::atomic<bool> s_active;
+            static uint32_t *s_window[static_cast<int>(eRp1Window::Count)];
+            static std::atomic<uint32_t> s_inputs[RP1_BANK_COUNT];
+    };
+}
@@ -0,0 +1,208 @@
+#include "RP1Snapshot.h"
+#include "RP1Fields.h"
+#include <time.h>
+#include <format>
+#include <sstream>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        typedef struct
+        {
+            const char* name;
+            uint32_t mask;
+            uint32_t lsb;
+        } FieldInfo_t;
+
+        template <typename F>
+        constexpr FieldInfo_t Info(const char* name) { return { name, F::mask, F::lsb }; }
+
+        constexpr FieldInfo_t STATUS_FIELDS[] =
+        {
+            Info<GpioStatus::OutFromPeri>("OUTFROMPERI"),
+            Info<GpioStatus::OutToPad>("OUTTOPAD"),
+            Info<GpioStatus::OeFromPeri>("OEFROMPERI"),
+            Info<GpioStatus::OeToPad>("OETOPAD"),
+            Info<GpioStatus::InFromPad>("INFROMPAD"),
+            Info<GpioStatus::InFiltered>("INFILTERED"),
+            Info<GpioStatus::InToPeri>("INTOPERI"),
+            Info<GpioStatus::IrqToProc>("IRQTOPROC"),
+        };
+        constexpr FieldInfo_t CTRL_FIELDS[] =
+        {
+            Info<GpioCtrl::FuncSel>("FUNCSEL"),
+            Info<GpioCtrl::FilterM>("F_M"),
+            Info<GpioCtrl::OutOver>("OUTOVER"),
+            Info<GpioCtrl::OeOver>("OEOVER"),
+            Info<GpioCtrl::InOver>("INOVER"),
+            Info<GpioCtrl::IrqMask>("IRQMASK"),
+            Info<GpioCtrl::IrqReset>("IRQRESET"),
+            Info<GpioCtrl::IrqOver>("IRQOVER"),
+        };
+        constexpr FieldInfo_t PAD_FIELDS[] =
+        {
+            Info<Pad::SlewFast>("SLEWFAST"),
+            Info<Pad::Schmitt>("SCHMITT"),
+            Info<Pad::PullDown>("PDE"),
+            Info<Pad::PullUp>("PUE"),
+            Info<Pad::Drive>("DRIVE"),
+            Info<Pad::InputEnable>("IE"),
+            Info<Pad::OutputDisable>("OD"),
+        };
+
+        uint64_t MonotonicNs() noexcept
+        {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        template <size_t N>
+        void DiffFields(std::vector<RP1SnapshotChange_t>& out, uint32_t bank, uint32_t pin, const char* reg,
+                        const FieldInfo_t (&fields)[N], uint32_t before, uint32_t after)
+        {
+            uint32_t changed = before ^ after;
+            if (changed == 0)
+                return;
+            uint32_t known = 0;
+            for (const auto& f : fields)
+            {
+                known |= f.mask;
+                if (changed & f.mask)
+                    out.push_back({ bank, pin, reg, f.name, (before & f.mask) >> f.lsb, (after & f.mask) >> f.lsb });
+            }
+            if (changed & ~known)
+                out.push_back({ bank, pin, reg, "other", before & ~known, after & ~known });
+        }
+
+        const char* PullName(uint32_t pad)
+        {
+            uint32_t up = Pad::PullUp::decode(pad);
+            uint32_t down = Pad::PullDown::decode(pad);
+            return (up && down) ? "both" : up ? "up" : down ? "down" : "none";
+        }
+    }
+
+    bool RP1Snapshot::capture(const RP1Mapping& mapping, RP1Snapshot_t& snap) noexcept
+    {
+        const volatile uint32_t *gpio = mapping.window(eRp1Window::Gpio);
+        const volatile uint32_t *rio = mapping.window(eRp1Window::Rio);
+        const volatile uint32_t *pad = mapping.window(eRp1Window::Pad);
+        if ((gpio == nullptr) || (rio == nullptr) || (pad == nullptr))
+            return false;
+
+        snap.timestampNs = MonotonicNs();
+        for (uint32_t bank = 0; bank < RP1_BANK_COUNT; ++bank)
+        {
+            RP1BankSnapshot_t& b = snap.bank[bank];
+            const volatile uint32_t *g = gpio + bank * (RP1_BLOCK_SIZE / 4);
+            const volatile uint32_t *r = rio + bank * (RP1_BLOCK_SIZE / 4);
+            const volatile uint32_t *p = pad + bank * (RP1_BLOCK_SIZE / 4);
+            const uint32_t pins = RP1_BANK_PINS[bank];
+
+            // Ascending addresses per block so the reads stream over PCIe
+            for (uint32_t pin = 0; pin < pins; ++pin)
+            {
+                b.status[pin] = GpioStatus::Reg::read(g, pin);
+                b.ctrl[pin] = GpioCtrl::Reg::read(g, pin);
+            }
+            b.padVoltage = rp1_read(p);
+            for (uint32_t pin = 0; pin < pins; ++pin)
+                b.pad[pin] = Pad::Reg::read(p + 1, pin);
+            b.rioOut = Rio::Out::read(r);
+            b.rioOE = Rio::OE::read(r);
+            b.rioIn = Rio::In::read(r);
+            b.rioInSync = Rio::InSync::read(r);
+
+            for (uint32_t pin = pins; pin < RP1_BANK_MAX_PINS; ++pin)
+                b.status[pin] = b.ctrl[pin] = b.pad[pin] = 0;
+        }
+        snap.durationNs = MonotonicNs() - snap.timestampNs;
+        return true;
+    }
+
+    std::vector<RP1SnapshotChange_t> RP1Snapshot::diff(const RP1Snapshot_t& before, const RP1Snapshot_t& after)
+    {
+        std::vector<RP1SnapshotChange_t> changes;
+        for (uint32_t bank = 0; bank < RP1_BANK_COUNT; ++bank)
+        {
+            const RP1BankSnapshot_t& a = before.bank[bank];
+            const RP1BankSnapshot_t& b = after.bank[bank];
+            for (uint32_t pin = 0; pin < RP1_BANK_PINS[bank]; ++pin)
+            {
+                DiffFields(changes, bank, pin, "status", STATUS_FIELDS, a.status[pin], b.status[pin]);
+                DiffFields(changes, bank, pin, "ctrl", CTRL_FIELDS, a.ctrl[pin], b.ctrl[pin]);
+                DiffFields(changes, bank, pin, "pad", PAD_FIELDS, a.pad[pin], b.pad[pin]);
+
+                const uint32_t bit = 1u << pin;
+                const struct { const char* name; uint32_t before; uint32_t after; } rioWords[] =
+                {
+                    { "OUT", a.rioOut, b.rioOut },
+                    { "OE", a.rioOE, b.rioOE },
+                    { "IN", a.rioIn, b.rioIn },
+                    { "INSYNC", a.rioInSync, b.rioInSync },
+                };
+                for (const auto& w : rioWords)
+                {
+                    if ((w.before ^ w.after) & bit)
+                        changes.push_back({ bank, pin, "rio", w.name, (w.before & bit) ? 1u : 0u, (w.after & bit) ? 1u : 0u });
+                }
+            }
+            if (a.padVoltage != b.padVoltage)
+                changes.push_back({ bank, 0, "pad", "VOLTAGE_SELECT", a.padVoltage, b.padVoltage });
+        }
+        return changes;
+    }
+
+    std::string RP1Snapshot::pinName(uint32_t bank, uint32_t pin)
+    {
+        // Bank 0 are the header GPIOs; banks 1/2 are RP1 internal pins
+        return (bank == 0) ? std::format("GPIO{}", pin) : std::format("B{}.{}", bank, pin);
+    }
+
+    std::string RP1Snapshot::formatTable(const RP1Snapshot_t& snap)
+    {
+        std::ostringstream os;
+        os << std::format("{:<8}{:>5}{:>4}{:>4}{:>4}{:>4}{:>6}{:>7}{:>7}{:>6}{:>5}{:>4}{:>4}{:>12}{:>12}\n",
+                          "pin", "func", "out", "oe", "in", "pad", "oe2p", "pull", "drive", "slew", "smt", "ie", "od",
+                          "ctrl", "status");
+        for (uint32_t bank = 0; bank < RP1_BANK_COUNT; ++bank)
+        {
+            const RP1BankSnapshot_t& b = snap.bank[bank];
+            for (uint32_t pin = 0; pin < RP1_BANK_PINS[bank]; ++pin)
+            {
+                const uint32_t bit = 1u << pin;
+                const uint32_t pad = b.pad[pin];
+                static const char* DRIVE[] = { "2mA", "4mA", "8mA", "12mA" };
+                os << std::format("{:<8}{:>5}{:>4}{:>4}{:>4}{:>4}{:>6}{:>7}{:>7}{:>6}{:>5}{:>4}{:>4}  0x{:08x}  0x{:08x}\n",
+                                  pinName(bank, pin),
+                                  GpioCtrl::FuncSel::decode(b.ctrl[pin]),
+                                  (b.rioOut & bit) ? 1 : 0,
+                                  (b.rioOE & bit) ? 1 : 0,
+                                  (b.rioIn & bit) ? 1 : 0,
+                                  GpioStatus::InFromPad::decode(b.status[pin]),
+                                  GpioStatus::OeToPad::decode(b.status[pin]),
+                                  PullName(pad),
+                                  DRIVE[Pad::Drive::decode(pad)],
+                                  Pad::SlewFast::decode(pad) ? "fast" : "slow",
+                                  Pad::Schmitt::decode(pad),
+                                  Pad::InputEnable::decode(pad),
+                                  Pad::OutputDisable::decode(pad),
+                                  b.ctrl[pin],
+                                  b.status[pin]);
+            }
+        }
+        os << std::format("captured {} pins in {} ns\n", RP1_PIN_COUNT, snap.durationNs);
+        return os.str();
+    }
+
+    std::string RP1Snapshot::formatDiff(const std::vector<RP1SnapshotChange_t>& changes)
+    {
+        std::ostringstream os;
+        for (const auto& c : changes)
+            os << std::format("{:<8} {}.{:<15} {:#x} -> {:#x}\n", pinName(c.bank, c.pin), c.reg, c.field, c.before, c.after);
+        os << std::format("{} field(s) changed\n", changes.size());
+        return os.str();
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "RP1Mapping.h"
+
+namespace SB::RPI5
+{
+    constexpr uint32_t RP1_BANK_MAX_PINS = 28;
+    constexpr uint32_t RP1_PIN_COUNT = 54;    // 28 + 6 + 20
+
+    // Copy of one GPIO bank: STATUS/CTRL and PAD per pin plus the RIO words.
+    typedef struct
+    {
+        uint32_t status[RP1_BANK_MAX_PINS];
+        uint32_t ctrl[RP1_BANK_MAX_PINS];
+        uint32_t pad[RP1_BANK_MAX_PINS];
+        uint32_t padVoltage;
+        uint32_t rioOut;
+        uint32_t rioOE;
+        uint32_t rioIn;
+        uint32_t rioInSync;
+    } RP1BankSnapshot_t;
+
+    typedef struct
+    {
+        uint64_t timestampNs;   // CLOCK_MONOTONIC when the capture started
+        uint64_t durationNs;    // time the bulk read took
+        RP1BankSnapshot_t bank[RP1_BANK_COUNT];
+    } RP1Snapshot_t;
+
+    typedef struct
+    {
+        uint32_t bank;
+        uint32_t pin;           // pin inside the bank
+        const char* reg;        // "status", "ctrl", "pad", "rio"
+        const char* field;
+        uint32_t before;
+        uint32_t after;
+    } RP1SnapshotChange_t;
+
+    // Plain functions on the mapped windows: no tracing, no allocation in
+    // capture, so they can be called from timing sensitive code.
+    class RP1Snapshot
+    {
+        public:
+            // One sequential pass over the GPIO, PAD and RIO windows of all banks.
+            static bool capture(const RP1Mapping& mapping, RP1Snapshot_t& snap) noexcept;
+            static std::vector<RP1SnapshotChange_t> diff(const RP1Snapshot_t& before, const RP1Snapshot_t& after);
+
+            static std::string formatTable(const RP1Snapshot_t& snap);
+            static std::string formatDiff(const std::vector<RP1SnapshotChange_t>& changes);
+            static std::string pinName(uint32_t bank, uint32_t pin);
+    };
+}
@@ -0,0 +1,662 @@
+#include "RP1Stream.h"
+#include "RP1Timer.h"
+#include "../Tracer/cfunctracer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <format>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        constexpr uint32_t CHECK_POLLS = 1024;      // polls between two looks at the clock
+        constexpr size_t MAX_RECORD_BYTES = 10 + 5 + 5;
+
+        size_t RoundUp(size_t size)
+        {
+            return (size + RP1_STREAM_PAGE - 1) & ~(RP1_STREAM_PAGE - 1);
+        }
+
+        uint8_t* PutVarint(uint8_t* p, uint64_t v)
+        {
+            while (v >= 0x80)
+            {
+                *p++ = static_cast<uint8_t>(v) | 0x80;
+                v >>= 7;
+            }
+            *p++ = static_cast<uint8_t>(v);
+            return p;
+        }
+
+        bool GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+        {
+            v = 0;
+            for (int shift = 0; (p < end) && (shift < 64); shift += 7)
+            {
+                uint8_t b = *p++;
+                v |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if ((b & 0x80) == 0)
+                    return true;
+            }
+            return false;
+        }
+
+        struct AlignedFree
+        {
+            void operator()(uint8_t* p) const { free(p); }
+        };
+        using AlignedBuffer = std::unique_ptr<uint8_t, AlignedFree>;
+
+        AlignedBuffer AllocPages(size_t size)
+        {
+            void *p = nullptr;
+            if (posix_memalign(&p, RP1_STREAM_PAGE, size) != 0)
+                return nullptr;
+            memset(p, 0, size);
+            return AlignedBuffer(static_cast<uint8_t*>(p));
+        }
+    }
+
+    RP1Stream::RP1Stream(std::shared_ptr<CTracer> tracer)
+        : m_trace(tracer)
+    {
+        CFuncTracer trace("RP1Stream::RP1Stream", m_trace);
+        m_freq = rp1_tick_freq();
+    }
+    RP1Stream::~RP1Stream()
+    {
+        CFuncTracer trace("RP1Stream::~RP1Stream", m_trace);
+        if (m_bRunning)
+            stop();
+        free(m_page);
+    }
+
+    bool RP1Stream::start(const RP1StreamConfig_t& config, const RP1IO::Fast& io)
+    {
+        CFuncTracer trace("RP1Stream::start", m_trace);
+        try
+        {
+            if (m_bRunning || !io.valid() || (config.mask == 0) || (config.blockRecords == 0) || config.path.empty())
+            {
+                trace.Error("cannot start (running %d, valid %d, mask 0x%08x, block %ld)",
+                            m_bRunning, io.valid(), config.mask, config.blockRecords);
+                return false;
+            }
+            m_config = config;
+            m_report = {};
+            m_index.clear();
+            m_polls = m_records = m_dropped = m_dropEvents = m_maxGapNs = 0;
+            m_blocksWritten = m_bytesWritten = m_payloadBytes = 0;
+            m_writeError = 0;
+            m_bStop = false;
+            m_bPollDone = false;
+
+            // Both queue blocks and the encode buffer are written once here,
+            // so neither thread faults a page in while streaming
+            for (auto& block : m_blocks)
+            {
+                block.records.assign(config.blockRecords, RP1StreamRecord_t{ 0, 0, 0 });
+                block.count = 0;
+                block.dropped = 0;
+                block.state.store(eBlockFree);
+            }
+            free(m_page);
+            m_pageSize = RoundUp(sizeof(RP1StreamBlockHeader_t) + config.blockRecords * MAX_RECORD_BYTES);
+            void *page = nullptr;
+            if (posix_memalign(&page, RP1_STREAM_PAGE, m_pageSize) != 0)
+            {
+                m_page = nullptr;
+                trace.Error("no memory for a %ld byte block", m_pageSize);
+                return false;
+            }
+            m_page = static_cast<uint8_t*>(page);
+            memset(m_page, 0, m_pageSize);
+
+            // O_DIRECT keeps hours of capture out of the page cache; tmpfs and
+            // some other file systems refuse it, then buffered writes are used
+            m_bDirect = true;
+            m_fd = ::open(config.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+            if ((m_fd < 0) && (errno == EINVAL))
+            {
+                m_bDirect = false;
+                m_fd = ::open(config.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            }
+            if (m_fd < 0)
+            {
+                trace.Error("cannot open %s : %s", config.path.c_str(), strerror(errno));
+                return false;
+            }
+
+            SBRealtime::resolveCpu(config.realtime, m_report);
+            if (config.realtime.lockMemory)
+            {
+                if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+                    m_report.memoryLocked = true;
+                else
+                    m_report.warnings.emplace_back(std::format("mlockall failed: {} (needs CAP_IPC_LOCK or RLIMIT_MEMLOCK)", strerror(errno)));
+            }
+
+            timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            m_startTicks = rp1_ticks();
+            m_lastTicks = m_startTicks;
+            m_offset = 0;
+
+            RP1StreamFileHeader_t fh = {};
+            fh.magic = RP1_STREAM_MAGIC;
+            fh.version = RP1_STREAM_VERSION;
+            fh.mask = config.mask;
+            fh.tickFreq = m_freq;
+            fh.startTicks = m_startTicks;
+            fh.startUnixNs = static_cast<int64_t>(now.tv_sec) * 1000000000ll + now.tv_nsec;
+            fh.blockRecords = static_cast<uint32_t>(config.blockRecords);
+            fh.useInSync = config.useInSync ? 1 : 0;
+            auto header = AllocPages(RP1_STREAM_PAGE);
+            if (header)
+                memcpy(header.get(), &fh, sizeof(fh));
+            if (!header || !writePages(header.get(), RP1_STREAM_PAGE))
+            {
+                ::close(m_fd);
+                m_fd = -1;
+                return false;
+            }
+
+            m_writer = std::thread([this]() { write(); });
+            m_poller = std::thread([this, io]() {
+                SBRealtime::applyToThisThread(m_config.realtime, m_report);
+                if (m_config.useInSync)
+                    poll<true>(io);
+                else
+                    poll<false>(io);
+            });
+            m_bRunning = true;
+            trace.Info("streaming mask 0x%08x to %s (%s, %ld records per block)", config.mask, config.path.c_str(),
+                       m_bDirect ? "O_DIRECT" : "buffered", config.blockRecords);
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    template <bool Sync>
+    void RP1Stream::poll(const RP1IO::Fast& io)
+    {
+        const uint32_t mask = m_config.mask;
+        const size_t capacity = m_config.blockRecords;
+        const uint64_t flushTicks = rp1_ns_to_ticks(m_config.flushNs, m_freq);
+
+        size_t cur = 0;
+        Block *block = &m_blocks[cur];
+        bool bDropping = false;
+        uint64_t lost = 0;              // changes dropped in the current overrun
+        uint64_t blockStart = rp1_ticks();
+
+        // Hand the current block to the writer and take the other one; when
+        // the writer still has it, changes are counted as dropped until it
+        // comes back. The block taken after a drop carries the number of lost
+        // changes and starts with the state at that moment, so the file stays
+        // consistent and says where transitions are missing.
+        auto publish = [&](uint64_t now) {
+            block->state.store(eBlockFull, std::memory_order_release);
+            cur ^= 1;
+            block = &m_blocks[cur];
+            blockStart = now;
+            if (block->state.load(std::memory_order_acquire) != eBlockFree)
+            {
+                bDropping = true;
+                m_dropEvents.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                block->count = 0;
+                block->dropped = 0;
+            }
+        };
+        // false while the writer still has the block
+        auto recover = [&](uint64_t t) {
+            if (block->state.load(std::memory_order_acquire) != eBlockFree)
+                return false;
+            bDropping = false;
+            block->count = 0;
+            block->dropped = static_cast<uint32_t>(std::min<uint64_t>(lost, UINT32_MAX));
+            lost = 0;
+            blockStart = t;
+            return true;
+        };
+        auto emit = [&](uint64_t t, uint32_t state, uint64_t polls) {
+            if (bDropping && !recover(t)) [[unlikely]]
+            {
+                ++lost;
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            block->records[block->count++] = { t, state, static_cast<uint32_t>(std::min<uint64_t>(polls, UINT32_MAX)) };
+            m_records.fetch_add(1, std::memory_order_relaxed);
+            if (block->count == capacity)
+                publish(t);
+        };
+
+        uint32_t prev = (Sync ? io.readSync() : io.read()) & mask;
+        uint64_t last = rp1_ticks();
+        emit(last, prev, 0);
+        uint64_t polls = 0;
+        for (;;)
+        {
+            for (uint32_t i = 0; i < CHECK_POLLS; ++i)
+            {
+                uint32_t v = (Sync ? io.readSync() : io.read()) & mask;
+                ++polls;
+                if (v != prev) [[unlikely]]
+                {
+                    emit(rp1_ticks(), v, polls);
+                    polls = 0;
+                    prev = v;
+                }
+            }
+            uint64_t now = rp1_ticks();
+            uint64_t gap = rp1_ticks_to_ns(now - last, m_freq);
+            if (gap > m_maxGapNs.load(std::memory_order_relaxed))
+                m_maxGapNs.store(gap, std::memory_order_relaxed);
+            last = now;
+            m_polls.fetch_add(CHECK_POLLS, std::memory_order_relaxed);
+            m_lastTicks.store(now, std::memory_order_relaxed);
+
+            // Back from an overrun without a change: record the current state
+            // now instead of waiting for the next transition
+            if (bDropping && recover(now))
+            {
+                emit(now, prev, polls);
+                polls = 0;
+            }
+            else if (!bDropping && (block->count > 0) && (now - blockStart >= flushTicks))
+                publish(now);
+            if (m_bStop.load(std::memory_order_relaxed))
+                break;
+        }
+        if (!bDropping && (block->count > 0))
+            block->state.store(eBlockFull, std::memory_order_release);
+        m_bPollDone.store(true, std::memory_order_release);
+    }
+
+    // The writer takes the blocks in the order the poll thread fills them.
+    // A failed write stops the stream: errno is kept for stats() and the poll
+    // thread is told to stop, the file keeps the blocks written before it.
+    void RP1Stream::write()
+    {
+        size_t idx = 0;
+        for (;;)
+        {
+            Block& block = m_blocks[idx];
+            if (block.state.load(std::memory_order_acquire) == eBlockFull)
+            {
+                if (!writeBlock(block))
+                {
+                    m_writeError.store(errno ? errno : EIO, std::memory_order_relaxed);
+                    m_bStop.store(true, std::memory_order_relaxed);
+                    block.state.store(eBlockFree, std::memory_order_release);
+                    break;
+                }
+                block.state.store(eBlockFree, std::memory_order_release);
+                idx ^= 1;
+                continue;
+            }
+            if (m_bPollDone.load(std::memory_order_acquire))
+            {
+                if (block.state.load(std::memory_order_acquire) == eBlockFull)
+                    continue;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    bool RP1Stream::writeBlock(const Block& block)
+    {
+        if (block.count == 0)
+            return true;
+        const RP1StreamRecord_t *rec = block.records.data();
+        RP1StreamBlockHeader_t bh = {};
+        bh.magic = RP1_STREAM_BLOCK_MAGIC;
+        bh.records = block.count;
+        bh.firstState = rec[0].state;
+        bh.firstTicks = rec[0].ticks;
+        bh.lastTicks = rec[block.count - 1].ticks;
+        bh.dropped = block.dropped;
+
+        uint8_t *start = m_page + sizeof(bh);
+        uint8_t *p = start;
+        uint64_t prevTicks = bh.firstTicks;
+        uint32_t prevState = bh.firstState;
+        for (uint32_t i = 0; i < block.count; ++i)
+        {
+            p = PutVarint(p, rec[i].ticks - prevTicks);
+            p = PutVarint(p, rec[i].state ^ prevState);
+            p = PutVarint(p, rec[i].polls);
+            prevTicks = rec[i].ticks;
+            prevState = rec[i].state;
+        }
+        bh.payloadBytes = static_cast<uint32_t>(p - start);
+        memcpy(m_page, &bh, sizeof(bh));
+        size_t size = RoundUp(sizeof(bh) + bh.payloadBytes);
+        memset(p, 0, m_page + size - p);
+
+        const uint64_t offset = m_offset;
+        if (!writePages(m_page, size))
+            return false;
+        m_index.push_back({ bh.firstTicks, bh.lastTicks, offset, bh.records });
+        m_blocksWritten.fetch_add(1, std::memory_order_relaxed);
+        m_payloadBytes.fetch_add(bh.payloadBytes, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool RP1Stream::writeIndex()
+    {
+        size_t indexBytes = RoundUp(m_index.size() * sizeof(RP1StreamIndexEntry_t));
+        auto buffer = AllocPages(indexBytes + RP1_STREAM_PAGE);
+        if (!buffer)
+            return false;
+        if (!m_index.empty())
+            memcpy(buffer.get(), m_index.data(), m_index.size() * sizeof(RP1StreamIndexEntry_t));
+        RP1StreamTrailer_t trailer = { RP1_STREAM_INDEX_MAGIC, m_offset, m_index.size(), m_lastTicks.load() };
+        memcpy(buffer.get() + indexBytes, &trailer, sizeof(trailer));
+        return writePages(buffer.get(), indexBytes + RP1_STREAM_PAGE);
+    }
+
+    bool RP1Stream::writePages(const uint8_t* data, size_t size)
+    {
+        size_t done = 0;
+        while (done < size)
+        {
+            ssize_t n = ::pwrite(m_fd, data + done, size - done, static_cast<off_t>(m_offset + done));
+            if (n < 0)
+            {
+                const int err = errno;
+                if (err == EINTR)
+                    continue;
+                CFuncTracer trace("RP1Stream::writePages", m_trace);
+                trace.Error("write at %llu failed : %s", static_cast<unsigned long long>(m_offset + done), strerror(err));
+                errno = err;            // for the caller, the tracer may have changed it
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        m_offset += size;
+        m_bytesWritten.fetch_add(size, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool RP1Stream::stop()
+    {
+        CFuncTracer trace("RP1Stream::stop", m_trace);
+        try
+        {
+            if (!m_bRunning)
+                return false;
+            m_bStop.store(true);
+            m_poller.join();
+            m_writer.join();
+            m_bRunning = false;
+            m_report.runNs = rp1_ticks_to_ns(m_lastTicks.load() - m_startTicks, m_freq);
+
+            // The index covers the blocks written before a write error, so the
+            // file stays readable up to there
+            bool bok = (m_writeError.load() == 0);
+            if (!bok)
+                trace.Error("stream stopped by a write error : %s", strerror(m_writeError.load()));
+            if (!writeIndex())
+                bok = false;
+            if (::close(m_fd) != 0)
+                bok = false;
+            m_fd = -1;
+            if (m_report.memoryLocked)
+                munlockall();
+
+            for (const auto& w : m_report.warnings)
+                trace.Warning("%s", w.c_str());
+            auto st = stats();
+            trace.Info("%llu polls, %llu records, %llu dropped, %llu blocks, %llu bytes",
+                       static_cast<unsigned long long>(st.polls), static_cast<unsigned long long>(st.records),
+                       static_cast<unsigned long long>(st.droppedRecords), static_cast<unsigned long long>(st.blocksWritten),
+                       static_cast<unsigned long long>(st.bytesWritten));
+            return bok;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    RP1StreamStats_t RP1Stream::stats() const
+    {
+        RP1StreamStats_t st = {};
+        st.polls = m_polls.load(std::memory_order_relaxed);
+        st.records = m_records.load(std::memory_order_relaxed);
+        st.droppedRecords = m_dropped.load(std::memory_order_relaxed);
+        st.dropEvents = m_dropEvents.load(std::memory_order_relaxed);
+        st.maxPollGapNs = m_maxGapNs.load(std::memory_order_relaxed);
+        st.blocksWritten = m_blocksWritten.load(std::memory_order_relaxed);
+        st.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+        st.payloadBytes = m_payloadBytes.load(std::memory_order_relaxed);
+        st.elapsedNs = rp1_ticks_to_ns(m_lastTicks.load(std::memory_order_relaxed) - m_startTicks, m_freq);
+        st.directIO = m_bDirect;
+        st.writeError = m_writeError.load(std::memory_order_relaxed);
+        return st;
+    }
+
+    std::string RP1Stream::formatStats(const RP1StreamStats_t& st)
+    {
+        double sec = st.elapsedNs / 1e9;
+        double rate = (sec > 0.0) ? st.polls / sec : 0.0;
+        return std::format("stream: {:.1f} s, {:.2f} MS/s, {} changes, {} dropped ({} events), {} blocks, "
+                           "{:.2f} MiB ({:.1f} B/change), max {} polls in {:.1f} us{}\n",
+                           sec, rate / 1e6, st.records, st.droppedRecords, st.dropEvents, st.blocksWritten,
+                           st.bytesWritten / 1048576.0, st.records ? static_cast<double>(st.payloadBytes) / st.records : 0.0,
+                           CHECK_POLLS, st.maxPollGapNs / 1000.0, st.directIO ? ", O_DIRECT" : "") +
+               (st.writeError ? std::format("stream: stopped by a write error : {}\n", strerror(st.writeError)) : std::string());
+    }
+
+    RP1StreamReader::RP1StreamReader(std::shared_ptr<CTracer> tracer)
+        : m_trace(tracer)
+    {
+        CFuncTracer trace("RP1StreamReader::RP1StreamReader", m_trace);
+    }
+    RP1StreamReader::~RP1StreamReader()
+    {
+        CFuncTracer trace("RP1StreamReader::~RP1StreamReader", m_trace);
+        if (m_fd >= 0)
+            ::close(m_fd);
+    }
+
+    bool RP1StreamReader::open(const std::string& path)
+    {
+        CFuncTracer trace("RP1StreamReader::open", m_trace);
+        try
+        {
+            if (m_fd >= 0)
+                ::close(m_fd);
+            m_index.clear();
+            m_bRebuilt = false;
+            m_fd = ::open(path.c_str(), O_RDONLY);
+            struct stat st;
+            if ((m_fd < 0) || (fstat(m_fd, &st) != 0))
+            {
+                trace.Error("cannot open %s : %s", path.c_str(), strerror(errno));
+                return false;
+            }
+            const uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+            if ((::pread(m_fd, &m_header, sizeof(m_header), 0) != sizeof(m_header)) ||
+                (m_header.magic != RP1_STREAM_MAGIC) || (m_header.tickFreq == 0))
+            {
+                trace.Error("%s is not a stream file", path.c_str());
+                return false;
+            }
+            if (m_header.version != RP1_STREAM_VERSION)
+            {
+                trace.Error("%s is stream version %u, expected %u", path.c_str(), m_header.version, RP1_STREAM_VERSION);
+                return false;
+            }
+
+            RP1StreamTrailer_t trailer = {};
+            if ((fileSize >= 2 * RP1_STREAM_PAGE) &&
+                (::pread(m_fd, &trailer, sizeof(trailer), static_cast<off_t>(fileSize - RP1_STREAM_PAGE)) == sizeof(trailer)) &&
+                (trailer.magic == RP1_STREAM_INDEX_MAGIC) &&
+                (trailer.indexOffset + trailer.entries * sizeof(RP1StreamIndexEntry_t) <= fileSize))
+            {
+                m_index.resize(trailer.entries);
+                size_t bytes = trailer.entries * sizeof(RP1StreamIndexEntry_t);
+                if ((bytes > 0) && (::pread(m_fd, m_index.data(), bytes, static_cast<off_t>(trailer.indexOffset)) != static_cast<ssize_t>(bytes)))
+                {
+                    trace.Error("short read of the index");
+                    return false;
+                }
+                m_stopTicks = trailer.stopTicks;
+            }
+            else if (!rebuildIndex(fileSize))
+                return false;
+
+            trace.Info("%s : %ld blocks%s", path.c_str(), m_index.size(), m_bRebuilt ? " (index rebuilt)" : "");
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    bool RP1StreamReader::rebuildIndex(uint64_t fileSize)
+    {
+        CFuncTracer trace("RP1StreamReader::rebuildIndex", m_trace);
+        m_bRebuilt = true;
+        m_stopTicks = m_header.startTicks;
+        uint64_t offset = RP1_STREAM_PAGE;
+        RP1StreamBlockHeader_t bh;
+        while ((offset + sizeof(bh) <= fileSize) &&
+               (::pread(m_fd, &bh, sizeof(bh), static_cast<off_t>(offset)) == sizeof(bh)) &&
+               (bh.magic == RP1_STREAM_BLOCK_MAGIC))
+        {
+            uint64_t size = RoundUp(sizeof(bh) + bh.payloadBytes);
+            if (offset + size > fileSize)
+                break;                      // torn last block
+            m_index.push_back({ bh.firstTicks, bh.lastTicks, offset, bh.records });
+            m_stopTicks = bh.lastTicks;
+            offset += size;
+        }
+        trace.Warning("no index, %ld blocks found", m_index.size());
+        return true;
+    }
+
+    uint64_t RP1StreamReader::toNs(uint64_t ticks) const
+    {
+        return (ticks > m_header.startTicks) ? rp1_ticks_to_ns(ticks - m_header.startTicks, m_header.tickFreq) : 0;
+    }
+
+    uint64_t RP1StreamReader::durationNs() const
+    {
+        return toNs(m_stopTicks);
+    }
+
+    bool RP1StreamReader::readBlock(const RP1StreamIndexEntry_t& entry, std::vector<RP1StreamRecord_t>& records, uint32_t& dropped)
+    {
+        RP1StreamBlockHeader_t bh;
+        if ((::pread(m_fd, &bh, sizeof(bh), static_cast<off_t>(entry.offset)) != sizeof(bh)) || (bh.magic != RP1_STREAM_BLOCK_MAGIC))
+            return false;
+        std::vector<uint8_t> payload(bh.payloadBytes);
+        if (::pread(m_fd, payload.data(), payload.size(), static_cast<off_t>(entry.offset + sizeof(bh))) != static_cast<ssize_t>(payload.size()))
+            return false;
+
+        const uint8_t *p = payload.data();
+        const uint8_t *end = p + payload.size();
+        uint64_t ticks = bh.firstTicks;
+        uint32_t state = bh.firstState;
+        dropped = bh.dropped;
+        records.clear();
+        records.reserve(bh.records);
+        for (uint32_t i = 0; i < bh.records; ++i)
+        {
+            uint64_t dt, ds, polls;
+            if (!GetVarint(p, end, dt) || !GetVarint(p, end, ds) || !GetVarint(p, end, polls))
+                return false;
+            ticks += dt;
+            state ^= static_cast<uint32_t>(ds);
+            records.push_back({ ticks, state, static_cast<uint32_t>(polls) });
+        }
+        return true;
+    }
+
+    bool RP1StreamReader::read(uint64_t fromNs, uint64_t toNs, std::vector<RP1StreamRecord_t>& records)
+    {
+        CFuncTracer trace("RP1StreamReader::read", m_trace);
+        try
+        {
+            records.clear();
+            m_dropped = 0;
+            if ((m_fd < 0) || (toNs <= fromNs))
+                return false;
+            const uint64_t fromTicks = m_header.startTicks + rp1_ns_to_ticks(fromNs, m_header.tickFreq);
+            const uint64_t toTicks = m_header.startTicks + rp1_ns_to_ticks(std::min<uint64_t>(toNs, UINT64_MAX / 2), m_header.tickFreq);
+
+            // First block that ends at or after fromTicks; the state at
+            // fromTicks may be the last record of the block before it
+            auto it = std::partition_point(m_index.begin(), m_index.end(),
+                                           [&](const RP1StreamIndexEntry_t& e) { return e.lastTicks < fromTicks; });
+            if (it != m_index.begin())
+                --it;
+
+            bool bHaveCarry = false;
+            RP1StreamRecord_t carry = {};
+            std::vector<RP1StreamRecord_t> block;
+            size_t blocksRead = 0;
+            for (; (it != m_index.end()) && (it->firstTicks < toTicks); ++it)
+            {
+                uint32_t dropped = 0;
+                if (!readBlock(*it, block, dropped))
+                {
+                    trace.Error("corrupt block at %llu", static_cast<unsigned long long>(it->offset));
+                    return false;
+                }
+                ++blocksRead;
+                if (it->firstTicks >= fromTicks)
+                    m_dropped += dropped;
+                for (const auto& r : block)
+                {
+                    if (r.ticks < fromTicks)
+                    {
+                        carry = r;
+                        bHaveCarry = true;
+                        continue;
+                    }
+                    if (r.ticks >= toTicks)
+                        break;
+                    if (bHaveCarry)
+                    {
+                        records.push_back({ fromTicks, carry.state, carry.polls });
+                        bHaveCarry = false;
+                    }
+                    records.push_back(r);
+                }
+            }
+            if (bHaveCarry)
+                records.push_back({ fromTicks, carry.state, carry.polls });
+            trace.Trace("%ld records from %ld blocks", records.size(), blocksRead);
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+}
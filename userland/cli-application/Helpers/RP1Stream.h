@@ -0,0 +1,210 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Tracer/ctracer.h"
+#include "SBRealtime.h"
+#include "SBRp1IO.h"
+
+namespace SB::RPI5
+{
+    // One run of the RIO input word: the state seen from 'ticks' on, and the
+    // number of polls since the previous change.
+    typedef struct
+    {
+        uint64_t ticks;
+        uint32_t state;
+        uint32_t polls;
+    } RP1StreamRecord_t;
+
+    typedef struct
+    {
+        uint32_t mask;              // bank 0 pins that are streamed
+        bool useInSync;             // poll RIO InSync instead of In
+        std::string path;
+        size_t blockRecords;        // records per queue block (and per file block)
+        uint64_t flushNs;           // a partly filled block is handed over after this
+        SBRealtimeConfig_t realtime;    // cpu / priority of the poll thread
+    } RP1StreamConfig_t;
+
+    // Counters, readable while the stream runs
+    typedef struct
+    {
+        uint64_t polls;             // reads of the input word
+        uint64_t records;           // changes queued
+        uint64_t droppedRecords;    // changes lost because both blocks were full
+        uint64_t dropEvents;        // times the poll thread found no free block
+        uint64_t maxPollGapNs;      // longest time for one check interval (1024 polls)
+        uint64_t blocksWritten;
+        uint64_t bytesWritten;      // file bytes, block padding included
+        uint64_t payloadBytes;      // encoded records only
+        uint64_t elapsedNs;
+        bool directIO;              // O_DIRECT was accepted by the file system
+        int writeError;             // errno of the failed write that stopped the stream, 0 if none
+    } RP1StreamStats_t;
+
+    // File layout, all little endian, every part starts on a 4 KiB boundary so
+    // the writer can use O_DIRECT:
+    //   header page   RP1StreamFileHeader_t
+    //   blocks        RP1StreamBlockHeader_t + varint records, zero padded
+    //   index         RP1StreamIndexEntry_t per block
+    //   trailer page  RP1StreamTrailer_t (last 4 KiB of the file)
+    // A record is encoded as varint(ticks - previous ticks), varint(state ^
+    // previous state), varint(polls); 'previous' restarts at the block header,
+    // so every block decodes on its own. Without a trailer (crash, power loss)
+    // the index is rebuilt by walking the block headers. A block whose header
+    // has 'dropped' set starts after a queue overrun: that many changes are
+    // missing before its first record, which is the state when polling was
+    // queued again.
+    constexpr uint64_t RP1_STREAM_MAGIC = 0x314d525453315052ull;        // "RP1STRM1"
+    constexpr uint32_t RP1_STREAM_BLOCK_MAGIC = 0x314b4c42u;            // "BLK1"
+    constexpr uint64_t RP1_STREAM_INDEX_MAGIC = 0x5845444e49315052ull;  // "RP1INDEX"
+    constexpr uint32_t RP1_STREAM_VERSION = 2;
+    constexpr size_t RP1_STREAM_PAGE = 4096;
+
+    typedef struct
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t mask;
+        uint64_t tickFreq;
+        uint64_t startTicks;
+        int64_t startUnixNs;
+        uint32_t blockRecords;
+        uint32_t useInSync;
+    } RP1StreamFileHeader_t;
+
+    typedef struct
+    {
+        uint32_t magic;
+        uint32_t records;
+        uint32_t payloadBytes;
+        uint32_t firstState;
+        uint64_t firstTicks;
+        uint64_t lastTicks;
+        uint32_t dropped;           // changes lost right before firstTicks (saturates)
+        uint32_t reserved;
+    } RP1StreamBlockHeader_t;
+
+    typedef struct
+    {
+        uint64_t firstTicks;
+        uint64_t lastTicks;
+        uint64_t offset;
+        uint64_t records;
+    } RP1StreamIndexEntry_t;
+
+    typedef struct
+    {
+        uint64_t magic;
+        uint64_t indexOffset;
+        uint64_t entries;
+        uint64_t stopTicks;
+    } RP1StreamTrailer_t;
+
+    // Continuous capture of RIO bank 0 to disk. A pinned SCHED_FIFO thread
+    // polls the input word and queues only the changes; the queue is two
+    // fixed blocks handed back and forth with an atomic state, so neither side
+    // blocks or allocates. When the writer is still busy with the other block
+    // the poll thread keeps polling and counts what it could not queue. The
+    // writer thread encodes each block and appends it to the file.
+    class RP1Stream
+    {
+        public:
+            RP1Stream(std::shared_ptr<CTracer> tracer);
+            virtual ~RP1Stream();
+
+            bool start(const RP1StreamConfig_t& config, const RP1IO::Fast& io);
+            bool stop();
+            bool running() const { return m_bRunning; }
+            // The writer hit a write error and the stream stopped polling
+            bool failed() const { return m_writeError.load(std::memory_order_relaxed) != 0; }
+
+            RP1StreamStats_t stats() const;
+            const SBRealtimeReport_t& realtimeReport() const { return m_report; }
+            static std::string formatStats(const RP1StreamStats_t& stats);
+
+        private:
+            enum : uint32_t { eBlockFree = 0, eBlockFull = 1 };
+            struct Block
+            {
+                std::atomic<uint32_t> state { eBlockFree };
+                uint32_t count = 0;
+                uint32_t dropped = 0;       // changes lost before records[0]
+                std::vector<RP1StreamRecord_t> records;
+            };
+
+            template <bool Sync>
+            void poll(const RP1IO::Fast& io);
+            void write();
+            bool writeBlock(const Block& block);
+            bool writeIndex();
+            bool writePages(const uint8_t* data, size_t size);
+
+            std::shared_ptr<CTracer> m_trace;
+            RP1StreamConfig_t m_config = {};
+            SBRealtimeReport_t m_report = {};
+            Block m_blocks[2];
+            std::thread m_poller;
+            std::thread m_writer;
+            std::atomic<bool> m_bStop { false };
+            std::atomic<bool> m_bPollDone { false };
+            bool m_bRunning = false;
+
+            int m_fd = -1;
+            uint8_t* m_page = nullptr;      // aligned encode buffer
+            size_t m_pageSize = 0;
+            uint64_t m_offset = 0;
+            std::vector<RP1StreamIndexEntry_t> m_index;
+            uint64_t m_freq = 0;
+            uint64_t m_startTicks = 0;
+            std::atomic<uint64_t> m_lastTicks { 0 };
+
+            std::atomic<uint64_t> m_polls { 0 };
+            std::atomic<uint64_t> m_records { 0 };
+            std::atomic<uint64_t> m_dropped { 0 };
+            std::atomic<uint64_t> m_dropEvents { 0 };
+            std::atomic<uint64_t> m_maxGapNs { 0 };
+            std::atomic<uint64_t> m_blocksWritten { 0 };
+            std::atomic<uint64_t> m_bytesWritten { 0 };
+            std::atomic<uint64_t> m_payloadBytes { 0 };
+            std::atomic<int> m_writeError { 0 };
+            bool m_bDirect = false;
+    };
+
+    // Reads a stream file; seek by time through the block index.
+    class RP1StreamReader
+    {
+        public:
+            RP1StreamReader(std::shared_ptr<CTracer> tracer);
+            virtual ~RP1StreamReader();
+
+            bool open(const std::string& path);
+            const RP1StreamFileHeader_t& header() const { return m_header; }
+            const std::vector<RP1StreamIndexEntry_t>& index() const { return m_index; }
+            bool indexRebuilt() const { return m_bRebuilt; }
+            uint64_t durationNs() const;
+            uint64_t toNs(uint64_t ticks) const;
+
+            // Records with fromNs <= t < toNs (ns since the stream start); the
+            // first record is the state at fromNs when the run began earlier.
+            bool read(uint64_t fromNs, uint64_t toNs, std::vector<RP1StreamRecord_t>& records);
+            // Changes the writer dropped inside the range of the last read()
+            uint64_t dropped() const { return m_dropped; }
+
+        private:
+            bool rebuildIndex(uint64_t fileSize);
+            bool readBlock(const RP1StreamIndexEntry_t& entry, std::vector<RP1StreamRecord_t>& records, uint32_t& dropped);
+
+            std::shared_ptr<CTracer> m_trace;
+            int m_fd = -1;
+            RP1StreamFileHeader_t m_header = {};
+            std::vector<RP1StreamIndexEntry_t> m_index;
+            uint64_t m_stopTicks = 0;
+            uint64_t m_dropped = 0;
+            bool m_bRebuilt = false;
+    };
+}
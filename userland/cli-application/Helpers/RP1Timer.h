@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+namespace SB::RPI5
+{
+    // Free running tick counter for busy-wait timing. On the Pi this is the ARM
+    // generic timer (CNTVCT_EL0, 54 MHz on the Pi 5), readable from user space
+    // without a system call; elsewhere it is CLOCK_MONOTONIC in ns.
+    [[gnu::always_inline]] inline uint64_t rp1_ticks() noexcept
+    {
+#if defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("isb; mrs %0, cntvct_el0" : "=r"(ticks) :: "memory");
+        return ticks;
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+    }
+
+    inline uint64_t rp1_tick_freq() noexcept
+    {
+#if defined(__aarch64__)
+        uint64_t freq;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+        return freq;
+#else
+        return 1000000000ull;
+#endif
+    }
+
+    inline uint64_t rp1_ns_to_ticks(uint64_t ns, uint64_t freq = rp1_tick_freq()) noexcept
+    {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(ns) * freq + 500000000ull) / 1000000000ull);
+    }
+
+    inline uint64_t rp1_ticks_to_ns(uint64_t ticks, uint64_t freq = rp1_tick_freq()) noexcept
+    {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(ticks) * 1000000000ull + freq / 2) / freq);
+    }
+
+    // Spin until the tick counter reaches deadline
+    [[gnu::always_inline]] inline void rp1_spin_until(uint64_t deadline) noexcept
+    {
+        while (rp1_ticks() < deadline)
+        {
+        }
+    }
+}
@@ -0,0 +1,156 @@
+#include "RP1Wait.h"
+#include "SBDelay.h"
+#include <errno.h>
+#include <sched.h>
+#include <algorithm>
+#include <format>
+#include <mutex>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        // Reads between two looks at the clock while spinning
+        constexpr uint32_t SPIN_READS = 16;
+        constexpr uint64_t DEFAULT_SLEEP_NS = 50000;
+
+        std::mutex s_policyLock;
+        bool s_bPolicySet = false;
+        RP1WaitPolicy_t s_policy = {};
+
+        void Relax(eRp1Relax relax) noexcept
+        {
+            if (relax == eRp1Relax::Wfe)
+                rp1_cpu_wait_event();
+            else
+                rp1_cpu_relax();
+        }
+
+        // start + ns on the generic timer, saturated: a timeout too long for
+        // the counter waits forever instead of wrapping to a past deadline
+        uint64_t TicksAfter(uint64_t start, uint64_t ns, uint64_t freq) noexcept
+        {
+            if (ns == RP1_WAIT_FOREVER)
+                return UINT64_MAX;
+            const uint64_t ticks = rp1_ns_to_ticks(ns, freq);
+            return (ticks > UINT64_MAX - start) ? UINT64_MAX : start + ticks;
+        }
+
+        void Backoff(const RP1WaitPolicy_t& policy, uint64_t leftNs) noexcept
+        {
+            switch (policy.backoff)
+            {
+                case eRp1Backoff::Yield:
+                    sched_yield();
+                    break;
+                case eRp1Backoff::Sleep:
+                {
+                    uint64_t ns = std::min(policy.sleepNs, leftNs);
+                    timespec ts = { static_cast<time_t>(ns / 1000000000ull), static_cast<long>(ns % 1000000000ull) };
+                    while (clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR)
+                    {
+                    }
+                    break;
+                }
+                default:
+                    Relax(policy.relax);
+                    break;
+            }
+        }
+    }
+
+    RP1WaitPolicy_t RP1Wait::defaultPolicy()
+    {
+        std::lock_guard<std::mutex> lock(s_policyLock);
+        if (!s_bPolicySet)
+        {
+            s_policy = { SBDelay::thresholdNs(), eRp1Relax::Yield, eRp1Backoff::Sleep, DEFAULT_SLEEP_NS };
+            s_bPolicySet = true;
+        }
+        return s_policy;
+    }
+
+    void RP1Wait::setDefaultPolicy(const RP1WaitPolicy_t& policy)
+    {
+        std::lock_guard<std::mutex> lock(s_policyLock);
+        s_policy = policy;
+        s_bPolicySet = true;
+    }
+
+    bool RP1Wait::waitForBits(const volatile uint32_t *reg, uint32_t mask, uint32_t value, uint64_t timeoutNs,
+                              RP1WaitResult_t& result, const RP1WaitPolicy_t& policy) noexcept
+    {
+        result = {};
+        if (reg == nullptr)
+            return false;
+
+        const uint64_t freq = rp1_tick_freq();
+        const uint64_t start = rp1_ticks();
+        const uint64_t deadline = TicksAfter(start, timeoutNs, freq);
+        const uint64_t spinEnd = TicksAfter(start, policy.spinNs, freq);
+        result.startTicks = start;
+        result.prevTicks = start;
+        value &= mask;
+
+        // Spin phase: the clock is read after every register read so the
+        // timestamp of the match stays within one read, but the deadline is
+        // only checked every SPIN_READS reads
+        uint64_t now = start;
+        while (now < spinEnd)
+        {
+            for (uint32_t i = 0; i < SPIN_READS; ++i)
+            {
+                result.value = rp1_read(reg);
+                now = rp1_ticks();
+                ++result.reads;
+                if ((result.value & mask) == value)
+                {
+                    result.matched = true;
+                    result.ticks = now;
+                    return true;
+                }
+                result.prevTicks = now;
+                Relax(policy.relax);
+            }
+            if (now >= deadline)
+            {
+                result.ticks = now;
+                return false;
+            }
+        }
+
+        // Back-off phase
+        for (;;)
+        {
+            result.value = rp1_read(reg);
+            now = rp1_ticks();
+            ++result.reads;
+            if ((result.value & mask) == value)
+            {
+                result.matched = true;
+                result.ticks = now;
+                return true;
+            }
+            if (now >= deadline)
+            {
+                result.ticks = now;
+                return false;
+            }
+            result.prevTicks = now;
+            uint64_t leftNs = (deadline == UINT64_MAX) ? UINT64_MAX : rp1_ticks_to_ns(deadline - now, freq);
+            Backoff(policy, leftNs);
+            ++result.backoffs;
+        }
+    }
+
+    std::string RP1Wait::formatPolicy(const RP1WaitPolicy_t& policy)
+    {
+        static const char *relax[] = { "yield", "wfe" };
+        static const char *backoff[] = { "spin", "sched_yield", "sleep" };
+        std::string s = std::format("spin {} ns ({}), then {}", policy.spinNs,
+                                    relax[static_cast<uint32_t>(policy.relax)], backoff[static_cast<uint32_t>(policy.backoff)]);
+        if (policy.backoff == eRp1Backoff::Sleep)
+            s += std::format(" {} ns", policy.sleepNs);
+        return s;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include "RP1Fields.h"
+#include "RP1Timer.h"
+
+namespace SB::RPI5
+{
+    // CPU hint inside a spin loop: 'yield' on ARM (lets the sibling thread of
+    // the core run, no latency), 'pause' on x86
+    [[gnu::always_inline]] inline void rp1_cpu_relax() noexcept
+    {
+#if defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#else
+        asm volatile("" ::: "memory");
+#endif
+    }
+
+    // 'wfe' on ARM: the core sleeps until an event. User space has no one to
+    // send it, so this relies on the kernel's event stream (about every 100 us
+    // on arm64) and trades that much latency for a mostly idle core. Plain
+    // relax elsewhere.
+    [[gnu::always_inline]] inline void rp1_cpu_wait_event() noexcept
+    {
+#if defined(__aarch64__)
+        asm volatile("wfe" ::: "memory");
+#else
+        rp1_cpu_relax();
+#endif
+    }
+
+    constexpr uint64_t RP1_WAIT_FOREVER = UINT64_MAX;
+
+    enum class eRp1Relax : uint32_t
+    {
+        Yield,      // rp1_cpu_relax between reads
+        Wfe,        // rp1_cpu_wait_event between reads
+    };
+
+    enum class eRp1Backoff : uint32_t
+    {
+        None,       // spin until the timeout
+        Yield,      // sched_yield() between reads
+        Sleep,      // clock_nanosleep(sleepNs) between reads
+    };
+
+    typedef struct
+    {
+        uint64_t spinNs;        // spin this long before backing off (RP1_WAIT_FOREVER: only spin)
+        eRp1Relax relax;
+        eRp1Backoff backoff;
+        uint64_t sleepNs;       // for eRp1Backoff::Sleep
+    } RP1WaitPolicy_t;
+
+    typedef struct
+    {
+        bool matched;
+        uint64_t ticks;         // generic timer right after the read that matched (or timed out)
+        uint64_t prevTicks;     // ... after the read before it: the bits changed in (prevTicks, ticks]
+        uint64_t startTicks;
+        uint64_t reads;
+        uint64_t backoffs;      // yields or sleeps done
+        uint32_t value;         // last register value read
+    } RP1WaitResult_t;
+
+    // Wait until (*reg & mask) == value. The first policy.spinNs are spent
+    // reading the register back to back with a CPU hint in between, which sees
+    // a change within one register read; after that it backs off to
+    // sched_yield() or short sleeps so a long wait does not hold a core. The
+    // default spin time is SBDelay's calibrated sleep wakeup latency: a wait
+    // shorter than that is over before a sleep would have returned.
+    class RP1Wait
+    {
+        public:
+            static RP1WaitPolicy_t defaultPolicy();
+            static void setDefaultPolicy(const RP1WaitPolicy_t& policy);
+
+            static bool waitForBits(const volatile uint32_t *reg, uint32_t mask, uint32_t value, uint64_t timeoutNs,
+                                    RP1WaitResult_t& result, const RP1WaitPolicy_t& policy) noexcept;
+            // Takes the policy lock and may calibrate SBDelay on first use, so
+            // not noexcept; fetch defaultPolicy() once for a hot path
+            static bool waitForBits(const volatile uint32_t *reg, uint32_t mask, uint32_t value, uint64_t timeoutNs,
+                                    RP1WaitResult_t& result)
+            {
+                return waitForBits(reg, mask, value, timeoutNs, result, defaultPolicy());
+            }
+
+            static std::string formatPolicy(const RP1WaitPolicy_t& policy);
+    };
+}
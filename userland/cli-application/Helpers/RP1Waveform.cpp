@@ -0,0 +1,193 @@
+#include "RP1Waveform.h"
+#include "RP1Timer.h"
+#include "SBDelay.h"
+#include "../Tracer/cfunctracer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+#include <sstream>
+
+namespace SB::RPI5
+{
+    RP1Waveform::RP1Waveform(std::shared_ptr<CTracer> tracer)
+        : m_trace(tracer)
+    {
+        CFuncTracer trace("RP1Waveform::RP1Waveform", m_trace);
+        m_freq = rp1_tick_freq();
+    }
+    RP1Waveform::~RP1Waveform()
+    {
+        CFuncTracer trace("RP1Waveform::~RP1Waveform", m_trace);
+    }
+
+    RP1Waveform& RP1Waveform::add(uint32_t mask, uint32_t value, uint32_t delayNs)
+    {
+        m_steps.push_back({ mask, value, delayNs });
+        return *this;
+    }
+    void RP1Waveform::clear()
+    {
+        m_steps.clear();
+        m_ops.clear();
+        m_issued.clear();
+        m_bRan = false;
+    }
+
+    bool RP1Waveform::compile(uint32_t repeat)
+    {
+        CFuncTracer trace("RP1Waveform::compile", m_trace);
+        try
+        {
+            if (m_steps.empty() || (repeat == 0))
+            {
+                trace.Error("nothing to compile (%ld steps, repeat %u)", m_steps.size(), repeat);
+                return false;
+            }
+            m_ops.clear();
+            m_ops.reserve(m_steps.size() * repeat);
+
+            // Deadlines are summed in ns and converted once per step so the
+            // rounding of the tick conversion does not accumulate.
+            uint64_t atNs = 0;
+            for (uint32_t r = 0; r < repeat; ++r)
+            {
+                for (const auto& s : m_steps)
+                {
+                    m_ops.push_back({ s.value & s.mask, ~s.value & s.mask, rp1_ns_to_ticks(atNs, m_freq) });
+                    atNs += s.delayNs;
+                }
+            }
+            // The last hold is part of the waveform: a closing op without writes
+            m_ops.push_back({ 0, 0, rp1_ns_to_ticks(atNs, m_freq) });
+
+            m_issued.assign(m_ops.size(), 0);
+            // The first use of the delay threshold calibrates it (~20 ms of
+            // sleeps); done here so run() starts warm
+            m_sleepTicks = rp1_ns_to_ticks(SBDelay::thresholdNs(), m_freq) * 2;
+            m_bRan = false;
+            trace.Trace("%ld ops, %llu ns, tick %llu ns", m_ops.size(), static_cast<unsigned long long>(atNs),
+                        static_cast<unsigned long long>(rp1_ticks_to_ns(1, m_freq)));
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    bool RP1Waveform::run(const RP1IO::Fast& io)
+    {
+        CFuncTracer trace("RP1Waveform::run", m_trace);
+        if (!io.valid() || m_ops.empty())
+        {
+            trace.Error("invalid RIO handle or waveform not compiled");
+            return false;
+        }
+
+        const RP1WaveOp_t *op = m_ops.data();
+        const RP1WaveOp_t *end = op + m_ops.size();
+        uint64_t *issued = m_issued.data();
+
+        // Long holds sleep until shortly before their deadline instead of
+        // spinning through them; the threshold was fetched by compile().
+        const uint64_t sleepTicks = m_sleepTicks;
+        const uint64_t start = rp1_ticks();
+        for (; op != end; ++op, ++issued)
+        {
+            const uint64_t deadline = start + op->atTicks;
+            const uint64_t now = rp1_ticks();
+            if (deadline > now + sleepTicks)
+                SBDelay::sleepBefore(SBDelay::nowNs() + rp1_ticks_to_ns(deadline - now, m_freq));
+            rp1_spin_until(deadline);
+            if (op->set)
+                io.set(op->set);
+            if (op->clr)
+                io.clear(op->clr);
+            *issued = rp1_ticks() - start;
+        }
+        m_bRan = true;
+        return true;
+    }
+
+    std::vector<RP1WaveResult_t> RP1Waveform::results() const
+    {
+        std::vector<RP1WaveResult_t> results;
+        if (!m_bRan)
+            return results;
+        results.reserve(m_ops.size());
+        for (size_t i = 0; i < m_ops.size(); ++i)
+        {
+            uint64_t requested = rp1_ticks_to_ns(m_ops[i].atTicks, m_freq);
+            uint64_t achieved = rp1_ticks_to_ns(m_issued[i], m_freq);
+            results.push_back({ requested, achieved, static_cast<int64_t>(achieved) - static_cast<int64_t>(requested) });
+        }
+        return results;
+    }
+
+    RP1WaveStats_t RP1Waveform::stats() const
+    {
+        RP1WaveStats_t st = { 0, 0, 0, 0.0, rp1_ticks_to_ns(1, m_freq) };
+        auto results = this->results();
+        if (results.empty())
+            return st;
+        st.steps = results.size();
+        st.minErrorNs = st.maxErrorNs = results.front().errorNs;
+        double sumAbs = 0.0;
+        for (const auto& r : results)
+        {
+            st.minErrorNs = std::min(st.minErrorNs, r.errorNs);
+            st.maxErrorNs = std::max(st.maxErrorNs, r.errorNs);
+            sumAbs += static_cast<double>(std::llabs(r.errorNs));
+        }
+        st.meanAbsErrorNs = sumAbs / static_cast<double>(results.size());
+        return st;
+    }
+
+    std::string RP1Waveform::formatReport(size_t maxRows) const
+    {
+        std::ostringstream os;
+        auto results = this->results();
+        if (results.empty())
+            return "waveform has not run\n";
+
+        os << std::format("{:>6} {:>10} {:>10} {:>12} {:>12} {:>8}\n", "step", "set", "clr", "request ns", "achieved ns", "err ns");
+        for (size_t i = 0; i < results.size() && i < maxRows; ++i)
+        {
+            os << std::format("{:>6} 0x{:08x} 0x{:08x} {:>12} {:>12} {:>8}\n", i, m_ops[i].set, m_ops[i].clr,
+                              results[i].requestedNs, results[i].achievedNs, results[i].errorNs);
+        }
+        if (results.size() > maxRows)
+            os << std::format("   ... {} more steps\n", results.size() - maxRows);
+
+        auto st = stats();
+        os << std::format("steps {}, error min {} ns / max {} ns / mean |err| {:.1f} ns, timer tick {} ns\n",
+                          st.steps, st.minErrorNs, st.maxErrorNs, st.meanAbsErrorNs, st.tickNs);
+        return os.str();
+    }
+
+    bool RP1Waveform::parse(const std::string& pattern, uint32_t mask, std::vector<RP1WaveStep_t>& steps)
+    {
+        std::stringstream ss(pattern);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            auto colon = item.find(':');
+            if (colon == std::string::npos)
+                return false;
+            try
+            {
+                uint32_t value = std::stoul(item.substr(0, colon)) ? mask : 0;
+                unsigned long long delayNs = std::stoull(item.substr(colon + 1));
+                if (delayNs > UINT32_MAX)
+                    return false;
+                steps.push_back({ mask, value, static_cast<uint32_t>(delayNs) });
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+        return !steps.empty();
+    }
+}
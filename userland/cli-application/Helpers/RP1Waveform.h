@@ -0,0 +1,87 @@
+#pragma once
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../Tracer/ctracer.h"
+#include "SBRp1IO.h"
+
+namespace SB::RPI5
+{
+    // One step of a timeline: drive the pins of mask to value, then hold for
+    // delayNs before the next step.
+    typedef struct
+    {
+        uint32_t mask;
+        uint32_t value;
+        uint32_t delayNs;
+    } RP1WaveStep_t;
+
+    // Compiled step: SET/CLR alias words and the deadline in timer ticks
+    // counted from the start of the run.
+    typedef struct
+    {
+        uint32_t set;
+        uint32_t clr;
+        uint64_t atTicks;
+    } RP1WaveOp_t;
+
+    typedef struct
+    {
+        uint64_t requestedNs;   // step start relative to the run start
+        uint64_t achievedNs;    // when its writes were issued
+        int64_t errorNs;        // achieved - requested
+    } RP1WaveResult_t;
+
+    typedef struct
+    {
+        size_t steps;
+        int64_t minErrorNs;
+        int64_t maxErrorNs;
+        double meanAbsErrorNs;
+        uint64_t tickNs;        // timer resolution
+    } RP1WaveStats_t;
+
+    // Bit-bang waveform engine on RIO bank 0.
+    //
+    //   RP1Waveform wave(tracer);
+    //   wave.add(mask, mask, 500).add(mask, 0, 1500);
+    //   wave.compile(2);                 // repeat twice
+    //   wave.run(io.fast(mask));
+    //
+    // compile() turns the steps into a flat array of absolute deadlines, so
+    // late steps do not shift the ones after them. run() spins on the ARM
+    // generic timer (CLOCK_MONOTONIC on a host) and writes through the RIO
+    // SET/CLR aliases; it is untraced and does not allocate. The timestamps
+    // of the last run are available through results()/stats().
+    class RP1Waveform
+    {
+        public:
+            RP1Waveform(std::shared_ptr<CTracer> tracer);
+            virtual ~RP1Waveform();
+
+            RP1Waveform& add(uint32_t mask, uint32_t value, uint32_t delayNs);
+            RP1Waveform& add(const RP1WaveStep_t& step) { return add(step.mask, step.value, step.delayNs); }
+            void clear();
+            const std::vector<RP1WaveStep_t>& steps() const { return m_steps; }
+
+            bool compile(uint32_t repeat = 1);
+            bool run(const RP1IO::Fast& io);
+
+            std::vector<RP1WaveResult_t> results() const;
+            RP1WaveStats_t stats() const;
+            std::string formatReport(size_t maxRows = 64) const;
+
+            // "v:ns,v:ns,..." with v 0/1 on the pins of mask
+            static bool parse(const std::string& pattern, uint32_t mask, std::vector<RP1WaveStep_t>& steps);
+
+        private:
+            std::shared_ptr<CTracer> m_trace;
+            std::vector<RP1WaveStep_t> m_steps;
+            std::vector<RP1WaveOp_t> m_ops;
+            std::vector<uint64_t> m_issued;     // ticks from run start, per op
+            uint64_t m_freq = 0;
+            uint64_t m_sleepTicks = 0;          // holds longer than this sleep first
+            bool m_bRan = false;
+    };
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace SB::RPI5
+{
+    // Wavetables for the PWM duty FIFO. Tables are Q16 (0..65535, mid scale
+    // 32768) and built at compile time, so any range can be fed from them with
+    // one multiply: duty = (q16 * (range + 1)) >> 16.
+    constexpr double RP1_PI = 3.14159265358979323846;
+
+    // sin() usable in constant expressions: reduced to [-pi/2, pi/2], then the
+    // Taylor series up to x^17 (error < 1e-13 there)
+    constexpr double rp1_sin(double x)
+    {
+        const double turns = x / (2.0 * RP1_PI);
+        long long n = static_cast<long long>(turns);
+        if (turns < 0.0)
+            --n;
+        x -= 2.0 * RP1_PI * static_cast<double>(n);     // [0, 2pi)
+        if (x > RP1_PI)
+            x -= 2.0 * RP1_PI;                          // (-pi, pi]
+        if (x > RP1_PI / 2.0)
+            x = RP1_PI - x;
+        else if (x < -RP1_PI / 2.0)
+            x = -RP1_PI - x;
+
+        double term = x, sum = x;
+        for (int k = 1; k <= 8; ++k)
+        {
+            term *= -x * x / static_cast<double>((2 * k) * (2 * k + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr uint16_t rp1_q16(double unit)     // 0.0 .. 1.0 to 0 .. 65535
+    {
+        const double v = unit * 65535.0 + 0.5;
+        return (v <= 0.0) ? 0 : (v >= 65535.0) ? 65535 : static_cast<uint16_t>(v);
+    }
+
+    template <size_t N>
+    constexpr std::array<uint16_t, N> rp1_sine_q16()
+    {
+        std::array<uint16_t, N> t = {};
+        for (size_t i = 0; i < N; ++i)
+            t[i] = rp1_q16(0.5 + 0.5 * rp1_sin(2.0 * RP1_PI * static_cast<double>(i) / static_cast<double>(N)));
+        return t;
+    }
+
+    template <size_t N>
+    constexpr std::array<uint16_t, N> rp1_ramp_q16()
+    {
+        std::array<uint16_t, N> t = {};
+        for (size_t i = 0; i < N; ++i)
+            t[i] = rp1_q16(static_cast<double>(i) / static_cast<double>(N - 1));
+        return t;
+    }
+
+    constexpr uint32_t RP1_WAVETABLE_BITS = 10;
+    constexpr size_t RP1_WAVETABLE_SIZE = size_t(1) << RP1_WAVETABLE_BITS;
+    inline constexpr std::array<uint16_t, RP1_WAVETABLE_SIZE> RP1_SINE_Q16 = rp1_sine_q16<RP1_WAVETABLE_SIZE>();
+    inline constexpr std::array<uint16_t, RP1_WAVETABLE_SIZE> RP1_RAMP_Q16 = rp1_ramp_q16<RP1_WAVETABLE_SIZE>();
+
+    static_assert((RP1_SINE_Q16[0] == 32768) && (RP1_SINE_Q16[RP1_WAVETABLE_SIZE / 4] == 65535) &&
+                  (RP1_SINE_Q16[3 * RP1_WAVETABLE_SIZE / 4] == 0));
+    static_assert((RP1_RAMP_Q16[0] == 0) && (RP1_RAMP_Q16[RP1_WAVETABLE_SIZE - 1] == 65535));
+
+    // Phase accumulator over a power-of-two table: the top bits of a 32 bit
+    // phase index the table, so any frequency below sampleRate / 2 plays
+    // without a division per sample.
+    class RP1WavetableOsc
+    {
+        public:
+            constexpr RP1WavetableOsc(const uint16_t *table, uint32_t bits, double freq, uint32_t sampleRate) noexcept
+                : m_table(table)
+                , m_shift(32 - bits)
+                , m_step(static_cast<uint32_t>(freq / static_cast<double>(sampleRate) * 4294967296.0))
+            {
+            }
+
+            [[gnu::always_inline]] uint16_t next() noexcept
+            {
+                const uint16_t v = m_table[m_phase >> m_shift];
+                m_phase += m_step;
+                return v;
+            }
+            // Duty words for a channel with this range
+            void render(uint32_t *duty, size_t count, uint32_t range) noexcept
+            {
+                const uint64_t scale = static_cast<uint64_t>(range) + 1;
+                for (size_t i = 0; i < count; ++i)
+                    duty[i] = static_cast<uint32_t>((next() * scale) >> 16);
+            }
+
+        private:
+            const uint16_t *m_table;
+            uint32_t m_shift;
+            uint32_t m_step;
+            uint32_t m_phase = 0;
+    };
+}
@@ -0,0 +1,104 @@
+#include "SBDelay.h"
+#include <errno.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        // Bounds for the switch-over: below 5 us spinning is cheaper than any
+        // sleep, above 5 ms the machine is too loaded for the number to mean much.
+        constexpr uint64_t MIN_THRESHOLD_NS = 5000;
+        constexpr uint64_t MAX_THRESHOLD_NS = 5000000;
+        constexpr uint64_t MARGIN_NS = 10000;
+        constexpr uint64_t DEFAULT_THRESHOLD_NS = 100000;
+
+        std::atomic<uint64_t> s_thresholdNs { 0 };
+        std::atomic<bool> s_calibrating { false };
+
+        timespec ToTimespec(uint64_t ns)
+        {
+            timespec ts;
+            ts.tv_sec = static_cast<time_t>(ns / 1000000000ull);
+            ts.tv_nsec = static_cast<long>(ns % 1000000000ull);
+            return ts;
+        }
+    }
+
+    SBDelayCalibration_t SBDelay::calibrate(uint32_t samples) noexcept
+    {
+        SBDelayCalibration_t cal = { std::clamp<uint32_t>(samples, 10, MAX_SAMPLES), 0, 0, 0, DEFAULT_THRESHOLD_NS };
+        std::array<uint64_t, MAX_SAMPLES> wakeup;
+
+        // Sleep to an absolute time a bit ahead and see how late we come back
+        for (uint32_t i = 0; i < cal.samples; ++i)
+        {
+            uint64_t target = nowNs() + 200000;
+            timespec ts = ToTimespec(target);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+            {
+            }
+            uint64_t now = nowNs();
+            wakeup[i] = (now > target) ? now - target : 0;
+        }
+
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < cal.samples; ++i)
+            sum += wakeup[i];
+        std::sort(wakeup.begin(), wakeup.begin() + cal.samples);
+        cal.meanWakeupNs = sum / cal.samples;
+        cal.p99WakeupNs = wakeup[(cal.samples * 99) / 100];
+        cal.maxWakeupNs = wakeup[cal.samples - 1];
+        cal.thresholdNs = std::clamp(cal.p99WakeupNs + MARGIN_NS, MIN_THRESHOLD_NS, MAX_THRESHOLD_NS);
+
+        s_thresholdNs.store(cal.thresholdNs, std::memory_order_relaxed);
+        return cal;
+    }
+
+    uint64_t SBDelay::thresholdNs() noexcept
+    {
+        uint64_t threshold = s_thresholdNs.load(std::memory_order_relaxed);
+        if (threshold == 0) [[unlikely]]
+        {
+            // One thread calibrates, the others do not wait for it
+            if (!s_calibrating.exchange(true, std::memory_order_acquire))
+            {
+                if (s_thresholdNs.load(std::memory_order_relaxed) == 0)
+                    calibrate();
+                s_calibrating.store(false, std::memory_order_release);
+            }
+            threshold = s_thresholdNs.load(std::memory_order_relaxed);
+            if (threshold == 0)
+                threshold = DEFAULT_THRESHOLD_NS;
+        }
+        return threshold;
+    }
+
+    void SBDelay::setThresholdNs(uint64_t ns)
+    {
+        s_thresholdNs.store(std::max<uint64_t>(ns, 1), std::memory_order_relaxed);
+    }
+
+    void SBDelay::sleepBefore(uint64_t deadlineNs) noexcept
+    {
+        const uint64_t threshold = thresholdNs();
+        if (deadlineNs > nowNs() + threshold)
+        {
+            timespec ts = ToTimespec(deadlineNs - threshold);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+            {
+                // absolute time, just sleep again
+            }
+        }
+    }
+
+    void SBDelay::until(uint64_t deadlineNs) noexcept
+    {
+        sleepBefore(deadlineNs);
+        while (nowNs() < deadlineNs)
+        {
+        }
+    }
+}
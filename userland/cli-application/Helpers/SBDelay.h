@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+namespace SB::RPI5
+{
+    typedef struct
+    {
+        uint32_t samples;
+        uint64_t meanWakeupNs;  // mean overshoot of clock_nanosleep(TIMER_ABSTIME)
+        uint64_t p99WakeupNs;
+        uint64_t maxWakeupNs;
+        uint64_t thresholdNs;   // resulting sleep/spin switch-over
+    } SBDelayCalibration_t;
+
+    // Precision delays on CLOCK_MONOTONIC. The bulk of the interval is slept
+    // with clock_nanosleep(TIMER_ABSTIME); the last thresholdNs are spun on the
+    // clock, so the wakeup latency of the scheduler does not end up in the
+    // delay. The threshold comes from calibrate(), which measures that latency;
+    // the first delay calibrates when nobody did before. Calibration does not
+    // allocate (at most MAX_SAMPLES samples, kept on the stack), so the lazy
+    // path is safe from noexcept code; a thread that needs the threshold while
+    // another one is calibrating uses a conservative default meanwhile.
+    class SBDelay
+    {
+        public:
+            static constexpr uint32_t MAX_SAMPLES = 1000;
+
+            static SBDelayCalibration_t calibrate(uint32_t samples = 100) noexcept;
+            static uint64_t thresholdNs() noexcept;
+            static void setThresholdNs(uint64_t ns);
+
+            [[gnu::always_inline]] static uint64_t nowNs() noexcept
+            {
+                timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+            }
+
+            // Sleep part only: returns about thresholdNs before deadlineNs (at
+            // once when that is already past), for callers that spin on another clock
+            static void sleepBefore(uint64_t deadlineNs) noexcept;
+            // Return at (not before) the CLOCK_MONOTONIC time deadlineNs
+            static void until(uint64_t deadlineNs) noexcept;
+            static void ns(uint64_t delayNs) noexcept { until(nowNs() + delayNs); }
+            static void us(uint64_t delayUs) noexcept { until(nowNs() + delayUs * 1000ull); }
+            static void ms(uint64_t delayMs) noexcept { until(nowNs() + delayMs * 1000000ull); }
+    };
+}
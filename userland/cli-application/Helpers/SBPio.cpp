@@ -1,6 +1,7 @@
 #include <exception>
 #include "../Tracer/cfunctracer.h"
 #include "SBPio.h"
+#include "SBDelay.h"
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
@@ -403,14 +404,12 @@ bool SBPio::SetPulse(int pin, int widthus, int LeadPulseTimeUs, int PostPulseTim
 {
     CFuncTracer trace("SBPio::SetPulse", m_trace);
 
-    if (widthus <= 165)
+    if (widthus <= 0)
     {
-        trace.Error("SetPulse: widthus must be > 155µs (got %d)", widthus);
+        trace.Error("SetPulse: widthus must be > 0 (got %d)", widthus);
         return false;
     }
 
-    widthus -= 160; // your calibration
-
     try
     {
         if (!ensureOutputPin(pin, errors))
@@ -433,25 +432,29 @@ bool SBPio::SetPulse(int pin, int widthus, int LeadPulseTimeUs, int PostPulseTim
             return true;
         };
 
+        // The width is timed from the return of the first edge ioctl to the
+        // second one, so only the ioctl latency remains in the pulse (no more
+        // fixed correction for the sleep overshoot).
         switch (tp)
         {
         case PulseType::ePositive:
             // idle LOW -> HIGH pulse -> LOW
             if (!writeValue(0)) return false;
-            if (LeadPulseTimeUs > 0) std::this_thread::sleep_for(microseconds(LeadPulseTimeUs));
+            if (LeadPulseTimeUs > 0) SBDelay::us(LeadPulseTimeUs);
             if (!writeValue(1)) return false;
-            std::this_thread::sleep_for(microseconds(widthus));
+            SBDelay::us(widthus);
             if (!writeValue(0)) return false;
+            if (PostPulseTimeUs > 0) SBDelay::us(PostPulseTimeUs);
             return true;
 
         case PulseType::eNegative:
             // idle HIGH -> LOW pulse -> HIGH
             if (!writeValue(1)) return false;
-            if (LeadPulseTimeUs > 0) std::this_thread::sleep_for(microseconds(LeadPulseTimeUs));
+            if (LeadPulseTimeUs > 0) SBDelay::us(LeadPulseTimeUs);
             if (!writeValue(0)) return false;
-            std::this_thread::sleep_for(microseconds(widthus));
+            SBDelay::us(widthus);
             if (!writeValue(1)) return false;
-            if (PostPulseTimeUs > 0) std::this_thread::sleep_for(microseconds(PostPulseTimeUs));
+            if (PostPulseTimeUs > 0) SBDelay::us(PostPulseTimeUs);
             return true;
 
         default:
@@ -772,8 +775,8 @@ int SBPio::MeasRC(int pin, std::vector<std::string>& errors)
 
     // Config
     constexpr long long TIMEOUT_US = 500'000;           // 500 ms timeout
-    timespec dischargeDelay { 0, 50 * 1000 * 1000 };    // 50 ms discharge
-    timespec pollDelay      { 0,  1 * 1000 * 1000 };    // 1 ms between polls
+    constexpr uint64_t DISCHARGE_US = 50'000;           // 50 ms discharge
+    constexpr uint64_t POLL_US = 1'000;                 // 1 ms between polls
 
     try
     {
@@ -790,7 +793,7 @@ int SBPio::MeasRC(int pin, std::vector<std::string>& errors)
             return -1;
         }
 
-        nanosleep(&dischargeDelay, nullptr);
+        SBDelay::us(DISCHARGE_US);
 
         // 2) Measurement: pin as input, high impedance (no internal pulls)
         if (!ensureInputHighImpedance(pin, errors))
@@ -840,7 +843,12 @@ int SBPio::MeasRC(int pin, std::vector<std::string>& errors)
                 return -1;
             }
 
-            nanosleep(&pollDelay, nullptr);
+            // The poll interval needs no precision: a plain sleep, no spin
+            // through the end of it as SBDelay would
+            timespec poll{ 0, static_cast<long>(POLL_US * 1000) };
+            while (clock_nanosleep(CLOCK_MONOTONIC, 0, &poll, &poll) == EINTR)
+            {
+            }
         }
 
         if (timeout)
@@ -6,24 +6,31 @@
 #include <errno.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <thread>
 #include "../Tracer/cfunctracer.h"
 #include "SBRP1Pwm.h"
+#include "RP1Fields.h"
+#include "RP1Wait.h"
 
 namespace SB::RPI5
 {
-    constexpr uint32_t PAD_PWM_DEFAULT = PULL_NONE | OUTPUT_ENABLE | DRIVE_8mA | SLEW_FAST;
-     
+    namespace
+    {
+        constexpr uint32_t DIV_INT_MAX = 65535;
+        constexpr uint64_t STEPS_MAX = 1ull << 32;     // CHAN_RANGE + 1
+        constexpr double TIE_PPM = 0.01;                // errors closer than this are equal
+    }
 
-    RP1PWM::RP1PWM(std::shared_ptr<CTracer> tracer)
-        : RP1Base(tracer)
-        , PWMClock(50000000)
+    RP1PWM::RP1PWM(std::shared_ptr<CTracer> tracer, eRp1Backend backend)
+        : RP1Base(tracer, backend)
     {
         CFuncTracer trace("RP1PWM::RP1PWM", m_trace);
         try
         {
-            bool bOk = initClock();
+            bool bOk = initClock(0);
             if (!bOk)
                 trace.Error("Failed to init the clock");
         }
@@ -47,51 +54,62 @@ namespace SB::RPI5
     PWMRegs_t* RP1PWM::PwmRegs(int pwmbase)
     {
         CFuncTracer trace("RP1PWM::PwmRegs", m_trace, false);
+        if (PWMBase(pwmbase) == nullptr)
+            return nullptr;     // e.g. /dev/gpiomem0 fallback: PWM block not mapped
         uint32_t *PwmRegs = PWMBase(pwmbase) + 0x14 / 4;
         return (PWMRegs_t *)PwmRegs;
     }
-    PWMClockRegs_t* RP1PWM::PwmClk()
+    PWMClockRegs_t* RP1PWM::PwmClk(int pwmBase)
+    {
+        if ((PWMClockBase() == nullptr) || (pwmBase < 0) || (pwmBase >= static_cast<int>(RP1_PWM_BLOCKS)))
+            return nullptr;
+        return (PWMClockRegs_t*)PwmClock::Ctrl::at(PWMClockBase(), pwmBase);
+    }
+    void RP1PWM::applyUpdate(volatile uint32_t *pwmBase)
     {
-        return (PWMClockBase())? (PWMClockRegs_t*)(PWMClockBase() + 0x74 /4) : nullptr;
+        // channel registers must be visible before SET_UPDATE latches them
+        rp1_wmb();
+        rp1_modify(pwmBase, 0, PwmGlobal::SetUpdate::val(1));
     }
 
     uint32_t RP1PWM::getFunctionForPWM(uint32_t pin)
     {
         CFuncTracer trace("RP1PWM::getFunctionForPWM", m_trace);
-        try
+        int32_t func = rp1_pwm_func(pin);
+        if (func < 0)
         {
-            switch(pin)
-            {
-                case 12: return 0;
-                case 13: return 0;
-                case 18: return 3;
-                case 19: return 3;
-                default:
-                    trace.Error("Pin %ld cannot be mapped to PWM channel", pin);
-                    break;
-            }
-            /* code */
+            trace.Error("Pin %ld cannot be mapped to PWM channel", pin);
+            return 0xFFFFFFFFu;
         }
-        catch(const std::exception& e)
+        return static_cast<uint32_t>(func);
+    }
+    bool RP1PWM::pinChannel(uint32_t pin, uint32_t& block, uint32_t& channel)
+    {
+        CFuncTracer trace("RP1PWM::pinChannel", m_trace, false);
+        const RP1PwmRoute_t *route = rp1_pwm_route(pin);
+        if (route == nullptr)
         {
-            trace.Error("Exception occured : %s", e.what());
+            trace.Error("pwmChannel not found (pin: %ld)", pin);
+            return false;
         }
-        return 0xFFFFFFFFu;
+        block = route->block;
+        channel = route->channel;
+        return true;
     }
     
-    bool RP1PWM::initClock()
+    bool RP1PWM::initClock(uint32_t block)
     {
         CFuncTracer trace("RP1PWM::initClock", m_trace);
         try
         {
-            PWMClockRegs_t* PWMCLK = PwmClk();
+            PWMClockRegs_t* PWMCLK = PwmClk(block);
             if (PWMCLK == nullptr)
             {
                 trace.Error("PWM is not correctly initialized");
                 return false;
             }
-            PWMCLK->Pwm0_Cntrl = 0x11000840;
-            PWMCLK->Pwm0_Sel = 1;
+            rp1_write(&PWMCLK->Pwm0_Cntrl, PwmClock::CTRL_DEFAULT);
+            rp1_write(&PWMCLK->Pwm0_Sel, 1);
             return true;
         }
         catch(const std::exception& e)
@@ -103,77 +121,210 @@ namespace SB::RPI5
     }
     int RP1PWM::getPwmIndex(uint32_t pin)
     {
-        switch(pin)
-        {
-            case 12: return 0;
-            case 13: return 1;
-            case 14: return 2;
-            case 15: return 3;
-            case 18: return 2;
-            case 19: return 3;
-            default: break;
-        }
-        return -1;
+        return rp1_pwm_channel(pin);
+    }
+    int RP1PWM::getPwmBlock(uint32_t pin)
+    {
+        return rp1_pwm_block(pin);
     }
     bool RP1PWM::setMode(uint32_t pin, pwm_mode mode)
     {
         CFuncTracer trace("RP1PWM::setMode", m_trace);
+        uint32_t block, channel;
+        if (!pinChannel(pin, block, channel))
+            return false;
+        return setModeChannel(pin, getFunctionForPWM(pin), block, channel, mode);
+    }
+    bool RP1PWM::setInvert(uint32_t pin)
+    {
+        CFuncTracer trace("RP1PWM::setInvert", m_trace);
+        uint32_t block, channel;
+        if (!pinChannel(pin, block, channel))
+            return false;
+        return invertChannel(block, channel, true);
+    }
+    bool RP1PWM::clrInvert(uint32_t pin)
+    {
+        CFuncTracer trace("RP1PWM::clrInvert", m_trace);
+        uint32_t block, channel;
+        if (!pinChannel(pin, block, channel))
+            return false;
+        return invertChannel(block, channel, false);
+    }
+    bool RP1PWM::Enable(uint32_t pin)
+    {
+        CFuncTracer trace("RP1PWM::Enable", m_trace);
+        uint32_t block, channel;
+        if (!pinChannel(pin, block, channel))
+            return false;
+        return enableChannel(block, channel, true);
+    }
+    bool RP1PWM::Disable(uint32_t pin)
+    {
+        CFuncTracer trace("RP1PWM::Disable", m_trace);
+        uint32_t block, channel;
+        if (!pinChannel(pin, block, channel))
+            return false;
+        return enableChannel(block, channel, false);
+    }
+    bool RP1PWM::setRangeDutyPhase(uint32_t pin, uint32_t range, uint32_t duty, uint32_t phase)
+    {
+        CFuncTracer trace("RP1PWM::setRangeDutyPhase", m_trace);
+        uint32_t block, channel;
+        if (!pinChannel(pin, block, channel))
+            return false;
+        return rangeDutyPhaseChannel(block, channel, range, duty, phase);
+    }
+    bool RP1PWM::setFrequencyDuty(uint32_t pin, uint32_t freq, int dutyPrecent)
+    {
+        CFuncTracer trace("RP1PWM::setFrequencyDuty", m_trace);
+        uint32_t block, channel;
+        if (!pinChannel(pin, block, channel))
+            return false;
+        RP1PwmClockSolution_t achieved;
+        return frequencyDutyChannel(block, channel, freq, dutyPrecent, DEFAULT_DUTY_STEPS, achieved);
+    }
+    bool RP1PWM::setFrequencyDuty(uint32_t pin, double freq, double dutyPercent, uint32_t minSteps, RP1PwmClockSolution_t& achieved)
+    {
+        CFuncTracer trace("RP1PWM::setFrequencyDuty", m_trace);
+        uint32_t block, channel;
+        if (!pinChannel(pin, block, channel))
+            return false;
+        return frequencyDutyChannel(block, channel, freq, dutyPercent, minSteps, achieved);
+    }
+    bool RP1PWM::setClock(uint32_t div, uint32_t frac)
+    {
+        return setClock(0, div, frac);
+    }
+    bool RP1PWM::setClock(uint32_t block, uint32_t div, uint32_t frac)
+    {
+        CFuncTracer trace("RP1PWM::setClock", m_trace);
         try
         {
-            int pwmChannel = getPwmIndex(pin);
-            if (pwmChannel < 0)
+            PWMClockRegs_t* PWMCLK = PwmClk(block);
+            if ((PWMCLK == nullptr) || (div == 0) || (div > DIV_INT_MAX))
             {
-                trace.Error("pwmChannel not found (pin: %ld)", pin);
+                trace.Error("PWM%u is not correctly initialized or divider %u out of range", block, div);
                 return false;
             }
+            rp1_write(&PWMCLK->Pwm0_DivInt, PwmClock::Int::encode(div));
+            rp1_write(&PWMCLK->Pwm0_DivFrac, PwmClock::Frac::encode(frac));
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+    bool RP1PWM::mapPin(uint32_t pin)
+    {
+        CFuncTracer trace("RP1PWM::mapPin", m_trace);
+        try
+        {
+            uint32_t func = getFunctionForPWM(pin);
+            if (func == 0xFFFFFFFFu)
+            {
+                trace.Error("func cannot get for pin %ld", pin);
+                return false;
+            }
+            return setFunction(pin, func, PAD_PWM_DEFAULT);
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+        }
+        return false;
+    }
 
-            PWMRegs_t * PWM = PwmRegs();
-            if (PWM == nullptr)
+    bool RP1PWM::fifoAttach(uint32_t pin, uint32_t sampleRate, uint32_t& range)
+    {
+        CFuncTracer trace("RP1PWM::fifoAttach", m_trace);
+        try
+        {
+            uint32_t block, channel;
+            if (!pinChannel(pin, block, channel))
+                return false;
+            volatile uint32_t *pwmBase = PWMBase(block);
+            if ((pwmBase == nullptr) || (sampleRate == 0))
             {
-                trace.Error("PWM is not correctly initialized");
+                trace.Error("PWM is not correctly initialized or sample rate is 0");
                 return false;
             }
+            // Mode, pin function and a disabled channel first
+            if (!setModeChannel(pin, getFunctionForPWM(pin), block, channel, pwm_mode::TrailingEdge))
+                return false;
 
-            bool bok = initClock();
-            if (!bok)
+            RP1PwmClockSolution_t clock = {};
+            if (!readClock(block, clock))
+                return false;
+            const double pwmf = clockFrequency(clock.sourceHz, clock.divInt, clock.divFrac, 0);
+            if (sampleRate >= pwmf / 2)
             {
-                trace.Error("initClock failed");
+                trace.Error("sample rate %u Hz is too high for a %.0f Hz pwm clock", sampleRate, pwmf);
                 return false;
             }
-            setFunction(pin, getFunctionForPWM(pin), PAD_PWM_DEFAULT);
-            PWM[pwmChannel].cntrl = static_cast<uint32_t>(mode);
-            return Disable(pin);
+            range = static_cast<uint32_t>(pwmf / sampleRate) - 1;
+
+            // Empty the FIFO before the channel starts popping it
+            rp1_set_bits(PwmFifoCtrl::Reg::at(pwmBase), PwmFifoCtrl::Flush::mask);
+            RP1WaitResult_t flushed;
+            if (!RP1Wait::waitForBits(PwmFifoCtrl::Reg::at(pwmBase), PwmFifoCtrl::FlushDone::mask, PwmFifoCtrl::FlushDone::mask,
+                                      1000000, flushed))
+                trace.Warning("DUTY_FIFO flush not done after 1 ms (FIFO_CTRL 0x%08x)", flushed.value);
+
+            PwmChan::Range::write(pwmBase, channel, range);
+            PwmChan::Phase::write(pwmBase, channel, 0);
+            PwmChan::UseFifo::set(pwmBase, channel, 1);
+            trace.Info("GPIO%u on PWM%u channel %u from DUTY_FIFO, %u Hz, range %u", pin, block, channel, sampleRate, range);
+            return enableChannel(block, channel, true);
         }
         catch(const std::exception& e)
         {
-            trace.Error("Excception occurred : %s", e.what());
+            trace.Error("Exception occurred : %s", e.what());
         }
         return false;
     }
-   
-    bool RP1PWM::setInvert(uint32_t pin)
+    bool RP1PWM::fifoDetach(uint32_t pin)
     {
-        CFuncTracer trace("RP1PWM::setInvert", m_trace);
+        CFuncTracer trace("RP1PWM::fifoDetach", m_trace);
         try
         {
-            int pwmChannel = getPwmIndex(pin);
-            if (pwmChannel < 0)
+            uint32_t block, channel;
+            if (!pinChannel(pin, block, channel) || (PWMBase(block) == nullptr))
             {
-                trace.Error("pwmChannel not found (pin: %ld)", pin);
-                return false;
-            }
-            PWMRegs_t * PWM = PwmRegs();
-            if (PWM == nullptr)
-            {
-                trace.Error("PWM is not correctly initialized");
+                trace.Error("pwmChannel not found (pin: %ld) or PWM not initialized", pin);
                 return false;
             }
+            volatile uint32_t *pwmBase = PWMBase(block);
+            bool bOk = enableChannel(block, channel, false);
+            PwmChan::UseFifo::set(pwmBase, channel, 0);
+            applyUpdate(pwmBase);
+            return bOk;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+    volatile uint32_t *RP1PWM::fifoCtrlReg(int pwmBase)
+    {
+        return (PWMBase(pwmBase) != nullptr) ? PwmFifoCtrl::Reg::at(PWMBase(pwmBase)) : nullptr;
+    }
+    volatile uint32_t *RP1PWM::dutyFifoReg(int pwmBase)
+    {
+        return (PWMBase(pwmBase) != nullptr) ? PwmCommon::DutyFifo::at(PWMBase(pwmBase)) : nullptr;
+    }
 
-           
-            PWM[pwmChannel].cntrl = PWM[pwmChannel].cntrl | 0x8;
-            volatile uint32_t *pwmBase = PWMBase();
-            *pwmBase = *pwmBase | 0x80000000;
-            return true;
+    bool RP1PWM::setModeChannel(uint32_t pin, uint32_t func, uint32_t block, uint32_t channel, pwm_mode mode)
+    {
+        CFuncTracer trace("RP1PWM::setModeChannel", m_trace);
+        try
+        {
+            if (!modeChannel(block, channel, mode))
+                return false;
+            return setFunction(pin, func, PAD_PWM_DEFAULT);
         }
         catch(const std::exception& e)
         {
@@ -181,28 +332,26 @@ namespace SB::RPI5
         }
         return false;
     }
-    bool RP1PWM::clrInvert(uint32_t pin)
+    bool RP1PWM::modeChannel(uint32_t block, uint32_t channel, pwm_mode mode)
     {
-        CFuncTracer trace("RP1PWM::clrInvert", m_trace);
+        CFuncTracer trace("RP1PWM::modeChannel", m_trace);
         try
         {
-            int pwmChannel = getPwmIndex(pin);
-            if (pwmChannel < 0)
+            PWMRegs_t * PWM = PwmRegs(block);
+            if ((PWM == nullptr) || (channel >= RP1_PWM_CHANNELS))
             {
-                trace.Error("pwmChannel not found (pin: %ld)", pin);
+                trace.Error("PWM%u is not correctly initialized or channel %u out of range", block, channel);
                 return false;
             }
-            PWMRegs_t * PWM = PwmRegs();
-            if (PWM == nullptr)
+
+            bool bok = initClock(block);
+            if (!bok)
             {
-                trace.Error("PWM is not correctly initialized");
+                trace.Error("initClock failed");
                 return false;
             }
-
-            PWM[pwmChannel].cntrl = PWM[pwmChannel].cntrl & ~0x8ul;
-            volatile uint32_t *pwmBase = PWMBase();
-            *pwmBase = *pwmBase | 0x80000000;
-            return true;
+            rp1_write(&PWM[channel].cntrl, static_cast<uint32_t>(mode));
+            return enableChannel(block, channel, false);
         }
         catch(const std::exception& e)
         {
@@ -210,53 +359,48 @@ namespace SB::RPI5
         }
         return false;
     }
-    bool RP1PWM::setClock(uint32_t div, uint32_t frac)
+    bool RP1PWM::invertChannel(uint32_t block, uint32_t channel, bool bInvert)
     {
-        CFuncTracer trace("RP1PWM::setClock", m_trace);
+        CFuncTracer trace("RP1PWM::invertChannel", m_trace);
         try
         {
-            PWMClockRegs_t* PWMCLK = PwmClk();   
-            if (PWMCLK == nullptr)
+            volatile uint32_t *pwmBase = PWMBase(block);
+            if ((pwmBase == nullptr) || (channel >= RP1_PWM_CHANNELS))
             {
-                trace.Error("PWM is not correctly initialized");
+                trace.Error("PWM%u is not correctly initialized or channel %u out of range", block, channel);
                 return false;
             }
-
-            PWMCLK->Pwm0_DivInt = div;
-            PWMCLK->Pwm0_DivFrac = frac;
+            PwmChan::Invert::set(pwmBase, channel, bInvert ? 1 : 0);
+            applyUpdate(pwmBase);
             return true;
         }
         catch(const std::exception& e)
         {
-            trace.Error("Exception occurred : %s", e.what());
+            trace.Error("Excception occurred : %s", e.what());
         }
         return false;
     }
-    bool RP1PWM::Enable(uint32_t pin)
+    bool RP1PWM::enableChannel(uint32_t block, uint32_t channel, bool bEnable)
     {
-        CFuncTracer trace("RP1PWM::Enable", m_trace);
+        CFuncTracer trace("RP1PWM::enableChannel", m_trace);
         try
         {
-            int pwmChannel = getPwmIndex(pin);
-            if (pwmChannel < 0)
+            volatile uint32_t *pwmBase = PWMBase(block);
+            if ((pwmBase == nullptr) || (channel >= RP1_PWM_CHANNELS))
             {
-                trace.Error("pwmChannel not found (pin: %ld)", pin);
+                trace.Error("PWM%u is not correctly initialized or channel %u out of range", block, channel);
                 return false;
             }
-            uint32_t value = 1 << pwmChannel;
-            volatile uint32_t *pwmBase = PWMBase();
-            *pwmBase = *pwmBase | value | 0x80000000;
-
-            PWMRegs_t * PWM = PwmRegs();
-            if (PWM == nullptr)
-            {
-                trace.Error("PWM is not correctly initialized");
-                return false;
-            }
-            PWM[pwmChannel].cntrl |= 0x1u;
-
-            // optional: flush if RP1 uses "apply" bit (you’ve been ORing 0x80000000 elsewhere)
-            *pwmBase |= 0x80000000;
+            rp1_modify(pwmBase, 0, (bEnable ? PwmGlobal::ChanEnable::bitOn(channel) : PwmGlobal::ChanEnable::bitOff(channel)) |
+                                   PwmGlobal::SetUpdate::val(1));
+            // Enable() always switched between Zero and TrailingEdge; a channel
+            // given any other mode keeps it
+            const uint32_t mode = PwmChan::Mode::get(pwmBase, channel);
+            if (bEnable && (mode == static_cast<uint32_t>(pwm_mode::Zero)))
+                PwmChan::Mode::set(pwmBase, channel, static_cast<uint32_t>(pwm_mode::TrailingEdge));
+            else if (!bEnable && (mode == static_cast<uint32_t>(pwm_mode::TrailingEdge)))
+                PwmChan::Mode::set(pwmBase, channel, static_cast<uint32_t>(pwm_mode::Zero));
+            applyUpdate(pwmBase);
             return true;
         }
         catch(const std::exception& e)
@@ -264,34 +408,30 @@ namespace SB::RPI5
             trace.Error("Exception occurred : %s", e.what());
         }
         return false;
-        
     }
-    bool RP1PWM::Disable(uint32_t pin)
+    bool RP1PWM::rangeDutyPhaseChannel(uint32_t block, uint32_t channel, uint32_t range, uint32_t duty, uint32_t phase)
     {
-        CFuncTracer trace("RP1PWM::Disable", m_trace);
+        CFuncTracer trace("RP1PWM::rangeDutyPhaseChannel", m_trace);
         try
         {
-            int pwmChannel = getPwmIndex(pin);
-            if (pwmChannel < 0)
+            PWMRegs_t * PWM = PwmRegs(block);
+            if ((PWM == nullptr) || (channel >= RP1_PWM_CHANNELS))
             {
-                trace.Error("pwmChannel not found (pin: %ld)", pin);
+                trace.Error("PWM%u is not correctly initialized or channel %u out of range", block, channel);
                 return false;
             }
-            volatile uint32_t *pwmBase = PWMBase();
-            uint32_t value = 1 << pwmChannel;
-            value = ~value & 0x0F;
-            *pwmBase = (*pwmBase & value) | 0x80000000;
 
-             PWMRegs_t * PWM = PwmRegs();
-            if (PWM == nullptr)
-            {
-                trace.Error("PWM is not correctly initialized");
-                return false;
-            }
-            PWM[pwmChannel].cntrl &= ~0x1u;
+            trace.Info("PWM%u : %p", block, PWM);
+            trace.Info("pwm Channel : %ld", channel);
+            trace.Info("write range : %32x @address %p", range, &PWM[channel].range);
+            trace.Info("write duty : %32x @address %p", duty, &PWM[channel].duty);
+            trace.Info("phase : %32x @address %p ", phase, &PWM[channel].phase);
 
-            // optional: flush if RP1 uses "apply" bit (you’ve been ORing 0x80000000 elsewhere)
-            *pwmBase |= 0x80000000;
+            volatile uint32_t *pwmBase = PWMBase(block);
+            PwmChan::Range::write(pwmBase, channel, range);
+            PwmChan::Duty::write(pwmBase, channel, duty);
+            PwmChan::Phase::write(pwmBase, channel, phase);
+            applyUpdate(pwmBase);
             return true;
         }
         catch(const std::exception& e)
@@ -300,87 +440,211 @@ namespace SB::RPI5
         }
         return false;
     }
-    bool RP1PWM::setRangeDutyPhase(uint32_t pin, uint32_t range, uint32_t duty, uint32_t phase)
+    bool RP1PWM::frequencyDutyChannel(uint32_t block, uint32_t channel, double freq, double dutyPercent, uint32_t minSteps,
+                                      RP1PwmClockSolution_t& achieved)
     {
-        CFuncTracer trace("RP1PWM::setRangeDutyPhase", m_trace);
+        CFuncTracer trace("RP1PWM::frequencyDutyChannel", m_trace);
         try
         {
-            int pwmChannel = getPwmIndex(pin);
-            if (pwmChannel < 0)
+            achieved = {};
+            RP1PwmClockSolution_t solution;
+            if (!solveCached(freq, minSteps, solution))
             {
-                trace.Error("pwmChannel not found (pin: %ld)", pin);
+                trace.Error("no clock setting gives %.3f Hz with %u duty steps", freq, minSteps);
                 return false;
             }
-            PWMRegs_t * PWM = PwmRegs();
-            if (PWM == nullptr)
-            {
-                trace.Error("PWM is not correctly initialized");
+            if (!applyClock(block, solution))
                 return false;
-            }
-
-            trace.Info("PWM : %p", PWM);
-            trace.Info("pwm Channel : %ld", pwmChannel);
-            trace.Info("write range : %32x @address %p", range, &PWM[pwmChannel].range);
-            trace.Info("write duty : %32x @address %p", duty, &PWM[pwmChannel].duty);
-            trace.Info("phase : %32x @address %p ", phase, &PWM[pwmChannel].phase);
 
-            PWM[pwmChannel].range = range;
-            PWM[pwmChannel].duty = duty;
-            PWM[pwmChannel].phase = phase;
+            const uint64_t steps = static_cast<uint64_t>(solution.range) + 1;
+            const double percent = std::clamp(dutyPercent, 0.0, 100.0);
+            const uint32_t duty = static_cast<uint32_t>(std::llround(static_cast<double>(steps) * percent / 100.0));
+            if (!rangeDutyPhaseChannel(block, channel, solution.range, duty, 0))
+                return false;
 
-            volatile uint32_t *pwmBase = PWMBase();
-            *pwmBase = *pwmBase | 0x80000000;
+            // What the hardware runs at, not what was asked for
+            if (!readClock(block, achieved))
+                return false;
+            achieved.range = PwmChan::Range::read(PWMBase(block), channel);
+            achieved.requested = freq;
+            achieved.frequency = clockFrequency(achieved.sourceHz, achieved.divInt, achieved.divFrac, achieved.range);
+            achieved.errorPpm = (achieved.frequency - freq) / freq * 1e6;
+            achieved.cached = solution.cached;
+            trace.Info("PWM%u channel %u: %.3f Hz asked, %.6f Hz (%+.3f ppm), div %u + %u/65536, range %u", block,
+                       channel, freq, achieved.frequency, achieved.errorPpm, achieved.divInt, achieved.divFrac, achieved.range);
             return true;
         }
         catch(const std::exception& e)
         {
-            trace.Error("Exception occurred : %s", e.what());
+            trace.Error("Excception occurred : %s", e.what());
         }
-        return false;
+        return false;        
     }
-    bool RP1PWM::setFrequencyDuty(uint32_t pin, uint32_t freq, int dutyPrecent)
+
+    double RP1PWM::clockFrequency(uint32_t sourceHz, uint32_t divInt, uint32_t divFrac, uint32_t range)
     {
-        CFuncTracer trace("RP1PWM::setFrequencyDuty", m_trace);
+        // DIV_INT 0 divides by 65536
+        const double div = ((divInt == 0) ? 65536.0 : static_cast<double>(divInt)) + static_cast<double>(divFrac) / 65536.0;
+        return static_cast<double>(sourceHz) / div / (static_cast<double>(range) + 1.0);
+    }
+
+    bool RP1PWM::solveClock(double freq, uint32_t minSteps, bool bAllowFrac, RP1PwmClockSolution_t& solution,
+                            std::span<const RP1PwmClockSource_t> sources)
+    {
+        solution = {};
+        if (!(freq > 0.0))
+            return false;
+        minSteps = std::max(minSteps, 2u);
+
+        bool bFound = false;
+        auto consider = [&](const RP1PwmClockSource_t& source, uint32_t divInt, uint32_t divFrac, uint64_t steps)
+        {
+            if ((steps < minSteps) || (steps > STEPS_MAX))
+                return;
+            const uint32_t range = static_cast<uint32_t>(steps - 1);
+            const double f = clockFrequency(source.hz, divInt, divFrac, range);
+            const double err = (f - freq) / freq * 1e6;
+            if (bFound)
+            {
+                const double diff = std::fabs(err) - std::fabs(solution.errorPpm);
+                if (diff > TIE_PPM)
+                    return;
+                if (diff >= -TIE_PPM)
+                {
+                    const bool bInt = (divFrac == 0), bBestInt = (solution.divFrac == 0);
+                    if ((bInt != bBestInt) ? !bInt : (range <= solution.range))
+                        return;
+                }
+            }
+            solution = { source.auxSrc, source.hz, divInt, divFrac, range, freq, f, err, false };
+            bFound = true;
+        };
+
+        for (const auto& source : sources)
+        {
+            const double clocks = static_cast<double>(source.hz) / freq;   // source clocks per period
+            // One pass over the integer part of the divider, fewer steps as it
+            // grows: the nearest period with an integer divider, and the two
+            // periods around it with the fraction taking up the remainder (a
+            // larger divider has a finer fraction, so the best error is often
+            // not at the most steps)
+            for (uint32_t div = 1; div <= DIV_INT_MAX; ++div)
+            {
+                const double steps = clocks / div;
+                if (steps < static_cast<double>(minSteps) - 1.0)
+                    break;
+                if (steps >= static_cast<double>(STEPS_MAX))
+                    continue;
+                consider(source, div, 0, static_cast<uint64_t>(std::llround(steps)));
+                if (!bAllowFrac)
+                    continue;
+                for (uint64_t n = static_cast<uint64_t>(steps); n <= static_cast<uint64_t>(steps) + 1; ++n)
+                {
+                    const uint64_t q = (n == 0) ? 0 : static_cast<uint64_t>(std::llround(clocks / static_cast<double>(n) * 65536.0));
+                    if (((q >> 16) >= 1) && ((q >> 16) <= DIV_INT_MAX))
+                        consider(source, static_cast<uint32_t>(q >> 16), static_cast<uint32_t>(q & 0xffff), n);
+                }
+            }
+        }
+        return bFound;
+    }
+
+    bool RP1PWM::solveCached(double freq, uint32_t minSteps, RP1PwmClockSolution_t& solution)
+    {
+        CFuncTracer trace("RP1PWM::solveCached", m_trace, false);
+        auto it = m_clockCache.find({ freq, minSteps });
+        if (it != m_clockCache.end())
+        {
+            solution = it->second;
+            solution.cached = true;
+            return true;
+        }
+        if (!solveClock(freq, minSteps, true, solution))
+            return false;
+        m_clockCache.emplace(std::make_tuple(freq, minSteps), solution);
+        trace.Info("%.3f Hz / %u steps: aux source %u (%u Hz), div %u + %u/65536, range %u, %+.3f ppm", freq, minSteps,
+                   solution.auxSrc, solution.sourceHz, solution.divInt, solution.divFrac, solution.range, solution.errorPpm);
+        return true;
+    }
+
+    bool RP1PWM::applyClock(uint32_t block, const RP1PwmClockSolution_t& solution)
+    {
+        CFuncTracer trace("RP1PWM::applyClock", m_trace);
         try
         {
-            PWMClockRegs_t* PWMCLK = PwmClk();
+            PWMClockRegs_t* PWMCLK = PwmClk(block);
             if (PWMCLK == nullptr)
             {
                 trace.Error("PWM is not correctly initialized");
                 return false;
             }
-
-            uint32_t div = PWMCLK->Pwm0_DivInt;
-            uint32_t frac = PWMCLK->Pwm0_DivFrac;
-            uint32_t pwmf = PWMClock / div;
-            uint32_t range = pwmf / freq-1;
-            uint32_t duty = range * dutyPrecent / 100;
-            return setRangeDutyPhase(pin, range,  duty, 0);
+            const uint32_t ctrl = rp1_read(&PWMCLK->Pwm0_Cntrl);
+            if ((PwmClock::AuxSrc::decode(ctrl) != solution.auxSrc) || (PwmClock::Enable::decode(ctrl) == 0))
+            {
+                // the aux mux only switches cleanly with the clock stopped
+                rp1_write(&PWMCLK->Pwm0_Cntrl, ctrl & ~PwmClock::Enable::mask);
+                rp1_write(&PWMCLK->Pwm0_Cntrl, (ctrl & ~(PwmClock::AuxSrc::mask | PwmClock::Enable::mask)) |
+                                               PwmClock::AuxSrc::encode(solution.auxSrc) | PwmClock::Enable::encode(1));
+                rp1_write(&PWMCLK->Pwm0_Sel, 1);
+            }
+            // Unchanged dividers are not rewritten: a repeated request leaves
+            // the running clock alone
+            if ((PwmClock::Int::decode(rp1_read(&PWMCLK->Pwm0_DivInt)) != solution.divInt) ||
+                (PwmClock::Frac::decode(rp1_read(&PWMCLK->Pwm0_DivFrac)) != solution.divFrac))
+                return setClock(block, solution.divInt, solution.divFrac);
+            return true;
         }
         catch(const std::exception& e)
         {
-            trace.Error("Excception occurred : %s", e.what());
+            trace.Error("Exception occurred : %s", e.what());
         }
-        return false;        
+        return false;
     }
 
-    bool RP1PWM::mapPin(uint32_t pin)
+    bool RP1PWM::readClock(uint32_t block, RP1PwmClockSolution_t& actual)
     {
-        CFuncTracer trace("RP1PWM::mapPin", m_trace);
+        CFuncTracer trace("RP1PWM::readClock", m_trace, false);
+        PWMClockRegs_t* PWMCLK = PwmClk(block);
+        if (PWMCLK == nullptr)
+        {
+            trace.Error("PWM is not correctly initialized");
+            return false;
+        }
+        actual.auxSrc = PwmClock::AuxSrc::decode(rp1_read(&PWMCLK->Pwm0_Cntrl));
+        actual.divInt = PwmClock::Int::decode(rp1_read(&PWMCLK->Pwm0_DivInt));
+        actual.divFrac = PwmClock::Frac::decode(rp1_read(&PWMCLK->Pwm0_DivFrac));
+        actual.sourceHz = 0;
+        for (const auto& source : RP1_PWM_CLOCK_SOURCES)
+        {
+            if (source.auxSrc == actual.auxSrc)
+                actual.sourceHz = source.hz;
+        }
+        if (actual.sourceHz == 0)
+            trace.Warning("PWM%u clock runs from aux source %u, its rate is unknown", block, actual.auxSrc);
+        return true;
+    }
+
+    bool RP1PWM::readFrequency(uint32_t pin, RP1PwmClockSolution_t& actual)
+    {
+        CFuncTracer trace("RP1PWM::readFrequency", m_trace);
         try
         {
-            /* code */
-            uint32_t func = getFunctionForPWM(pin);
-            if (func == 0xFFFFFFFFu)
+            actual = {};
+            uint32_t block, channel;
+            if (!pinChannel(pin, block, channel) || (PWMBase(block) == nullptr))
             {
-                trace.Error("func cannot get for pin %ld", pin);
+                trace.Error("pwmChannel not found (pin: %ld) or PWM not initialized", pin);
                 return false;
             }
-            return setFunction(pin, func, PAD_PWM_DEFAULT);
+            if (!readClock(block, actual))
+                return false;
+            actual.range = PwmChan::Range::read(PWMBase(block), channel);
+            actual.frequency = clockFrequency(actual.sourceHz, actual.divInt, actual.divFrac, actual.range);
+            return true;
         }
         catch(const std::exception& e)
         {
-            std::cerr << e.what() << '\n';
+            trace.Error("Exception occurred : %s", e.what());
         }
         return false;
     }
@@ -396,8 +660,8 @@ namespace SB::RPI5
                 return static_cast<uint32_t>(-1);        
             }
             PWMRegs_t* PWM = (PWMRegs_t*)PwmRegs(pwmbase);
-            trace.Info("CHAN%ld_CNTRL pwm%ld: 0x%08x, %p", pwmChannel, pwmbase, PWM[pwmChannel].cntrl, &PWM[pwmChannel].cntrl);
-            return PWM[pwmChannel].cntrl;
+            trace.Info("CHAN%ld_CNTRL pwm%ld: 0x%08x, %p", pwmChannel, pwmbase, rp1_read(&PWM[pwmChannel].cntrl), &PWM[pwmChannel].cntrl);
+            return rp1_read(&PWM[pwmChannel].cntrl);
         }
         catch(const std::exception& e)
         {
@@ -417,8 +681,8 @@ namespace SB::RPI5
                 return static_cast<uint32_t>(-1);        
             }
             PWMRegs_t* PWM = (PWMRegs_t*)PwmRegs(pwmbase);
-            trace.Info("CHAN%ld_RANGE pwm%ld: 0x%08x, %p", pwmChannel, pwmbase, PWM[pwmChannel].range, &PWM[pwmChannel].range);
-            return PWM[pwmChannel].range;
+            trace.Info("CHAN%ld_RANGE pwm%ld: 0x%08x, %p", pwmChannel, pwmbase, rp1_read(&PWM[pwmChannel].range), &PWM[pwmChannel].range);
+            return rp1_read(&PWM[pwmChannel].range);
         }
         catch(const std::exception& e)
         {
@@ -438,8 +702,8 @@ namespace SB::RPI5
                 return static_cast<uint32_t>(-1);        
             }
             PWMRegs_t* PWM = (PWMRegs_t*)PwmRegs(pwmbase);
-            trace.Info("CHAN%ld_PHASE pwm%ld: 0x%08x, %p", pwmChannel, pwmbase, PWM[pwmChannel].phase, &PWM[pwmChannel].phase);
-            return PWM[pwmChannel].phase;
+            trace.Info("CHAN%ld_PHASE pwm%ld: 0x%08x, %p", pwmChannel, pwmbase, rp1_read(&PWM[pwmChannel].phase), &PWM[pwmChannel].phase);
+            return rp1_read(&PWM[pwmChannel].phase);
         }
         catch(const std::exception& e)
         {
@@ -459,8 +723,8 @@ namespace SB::RPI5
                 return static_cast<uint32_t>(-1); 
             }
             PWMRegs_t* PWM = (PWMRegs_t*)PwmRegs(pwmbase);
-            trace.Info("CHAN%ld_DUTY pwm%ld: 0x%08x, %p", pwmChannel, pwmbase, PWM[pwmChannel].duty, &PWM[pwmChannel].duty);
-            return PWM[pwmChannel].duty;
+            trace.Info("CHAN%ld_DUTY pwm%ld: 0x%08x, %p", pwmChannel, pwmbase, rp1_read(&PWM[pwmChannel].duty), &PWM[pwmChannel].duty);
+            return rp1_read(&PWM[pwmChannel].duty);
 
         }
         catch(const std::exception& e)
@@ -475,8 +739,8 @@ namespace SB::RPI5
         try
         {
             PWMGlobalRegs_t* GLOBAL = (PWMGlobalRegs_t*)PWMBase(pwmBase);
-            trace.Info("GLOBAL_CNTRL pwm%ld: 0x%08x, %p", pwmBase, GLOBAL->GlobalCntrl, &GLOBAL->GlobalCntrl);
-            return GLOBAL->GlobalCntrl;
+            trace.Info("GLOBAL_CNTRL pwm%ld: 0x%08x, %p", pwmBase, rp1_read(&GLOBAL->GlobalCntrl), &GLOBAL->GlobalCntrl);
+            return rp1_read(&GLOBAL->GlobalCntrl);
         }
         catch(const std::exception& e)
         {
@@ -491,8 +755,8 @@ namespace SB::RPI5
         try
         {
             PWMGlobalRegs_t* GLOBAL = (PWMGlobalRegs_t*)PWMBase(pwmBase);
-            trace.Info("FIFO_CNTRL pwm%ld: 0x%08x, %p", pwmBase, GLOBAL->FifoCntrl, &GLOBAL->FifoCntrl);
-            return GLOBAL->FifoCntrl;
+            trace.Info("FIFO_CNTRL pwm%ld: 0x%08x, %p", pwmBase, rp1_read(&GLOBAL->FifoCntrl), &GLOBAL->FifoCntrl);
+            return rp1_read(&GLOBAL->FifoCntrl);
         }
         catch(const std::exception& e)
         {
@@ -506,8 +770,8 @@ namespace SB::RPI5
         try
         {
             PWMGlobalRegs_t* GLOBAL = (PWMGlobalRegs_t*)PWMBase(pwmBase);
-            trace.Info("COMMON_RANGE pwm%ld: 0x%08x, %p", pwmBase, GLOBAL->CommonRange, &GLOBAL->CommonRange);
-            return GLOBAL->CommonRange;
+            trace.Info("COMMON_RANGE pwm%ld: 0x%08x, %p", pwmBase, rp1_read(&GLOBAL->CommonRange), &GLOBAL->CommonRange);
+            return rp1_read(&GLOBAL->CommonRange);
         }
         catch(const std::exception& e)
         {
@@ -521,8 +785,8 @@ namespace SB::RPI5
         try
         {
             PWMGlobalRegs_t* GLOBAL = (PWMGlobalRegs_t*)PWMBase(pwmBase);
-            trace.Info("COMMON_DUTY pwm%ld: 0x%08x, %p", pwmBase, GLOBAL->CommonDuty, &GLOBAL->CommonDuty);
-            return GLOBAL->CommonDuty;
+            trace.Info("COMMON_DUTY pwm%ld: 0x%08x, %p", pwmBase, rp1_read(&GLOBAL->CommonDuty), &GLOBAL->CommonDuty);
+            return rp1_read(&GLOBAL->CommonDuty);
         }
         catch(const std::exception& e)
         {
@@ -536,8 +800,8 @@ namespace SB::RPI5
         try
         {
             PWMGlobalRegs_t* GLOBAL = (PWMGlobalRegs_t*)PWMBase(pwmBase);
-            trace.Info("DUTY_FIFO pwm%ld: 0x%08x, %p", pwmBase, GLOBAL->DutyFifo, &GLOBAL->DutyFifo);
-            return GLOBAL->DutyFifo;
+            trace.Info("DUTY_FIFO pwm%ld: 0x%08x, %p", pwmBase, rp1_read(&GLOBAL->DutyFifo), &GLOBAL->DutyFifo);
+            return rp1_read(&GLOBAL->DutyFifo);
         }
         catch(const std::exception& e)
         {
@@ -546,13 +810,15 @@ namespace SB::RPI5
         return static_cast<uint32_t>(-1);
     }
 
-    uint32_t RP1PWM::getPwmClockReg_cntrl()
+    uint32_t RP1PWM::getPwmClockReg_cntrl(int pwmBase)
     {
         CFuncTracer trace("RP1PWM::getPwmClockReg_cntrl", m_trace);
         try
         {
-            PWMClockRegs_t* PWMCLK = (PWMClockRegs_t*)PWMClockBase();
-            return PWMCLK->Pwm0_Cntrl;
+            PWMClockRegs_t* PWMCLK = PwmClk(pwmBase);
+            if (PWMCLK == nullptr)
+                return static_cast<uint32_t>(-1);
+            return rp1_read(&PWMCLK->Pwm0_Cntrl);
         }
         catch(const std::exception& e)
         {
@@ -560,13 +826,15 @@ namespace SB::RPI5
         }
         return static_cast<uint32_t>(-1);        
     }
-    uint32_t RP1PWM::getPwmClockReg_divInt()
+    uint32_t RP1PWM::getPwmClockReg_divInt(int pwmBase)
     {
         CFuncTracer trace("RP1PWM::getPwmClockReg_divInt", m_trace);
         try
         {
-            PWMClockRegs_t* PWMCLK = (PWMClockRegs_t*)PWMClockBase();
-            return PWMCLK->Pwm0_DivInt;
+            PWMClockRegs_t* PWMCLK = PwmClk(pwmBase);
+            if (PWMCLK == nullptr)
+                return static_cast<uint32_t>(-1);
+            return rp1_read(&PWMCLK->Pwm0_DivInt);
         }
         catch(const std::exception& e)
         {
@@ -574,13 +842,15 @@ namespace SB::RPI5
         }
         return static_cast<uint32_t>(-1);        
     }
-    uint32_t RP1PWM::getPwmClockReg_divFrac()
+    uint32_t RP1PWM::getPwmClockReg_divFrac(int pwmBase)
     {
         CFuncTracer trace("RP1PWM::getPwmClockReg_divFrac", m_trace);
         try
         {
-            PWMClockRegs_t* PWMCLK = (PWMClockRegs_t*)PWMClockBase();
-            return PWMCLK->Pwm0_DivFrac;
+            PWMClockRegs_t* PWMCLK = PwmClk(pwmBase);
+            if (PWMCLK == nullptr)
+                return static_cast<uint32_t>(-1);
+            return rp1_read(&PWMCLK->Pwm0_DivFrac);
         }
         catch(const std::exception& e)
         {
@@ -588,13 +858,15 @@ namespace SB::RPI5
         }
         return static_cast<uint32_t>(-1);        
     }
-    uint32_t RP1PWM::getPwmClockReg_Sel()
+    uint32_t RP1PWM::getPwmClockReg_Sel(int pwmBase)
     {
         CFuncTracer trace("RP1PWM::getPwmClockReg_Sel", m_trace);
         try
         {
-            PWMClockRegs_t* PWMCLK = (PWMClockRegs_t*)PWMClockBase();
-            return PWMCLK->Pwm0_Sel;
+            PWMClockRegs_t* PWMCLK = PwmClk(pwmBase);
+            if (PWMCLK == nullptr)
+                return static_cast<uint32_t>(-1);
+            return rp1_read(&PWMCLK->Pwm0_Sel);
         }
         catch(const std::exception& e)
         {
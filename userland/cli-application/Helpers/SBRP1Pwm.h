@@ -1,15 +1,23 @@
 #pragma once
+#include <map>
 #include <memory>
+#include <span>
 #include <string>
+#include <tuple>
 #include <vector>
 #include <linux/gpio.h>
 #include <gpiod.h>
 #include "RP1Base.h"
+#include "RP1Pins.h"
 #include "../Tracer/ctracer.h"
 
 
 namespace SB::RPI5
 {
+    // 8 mA, fast slew, input on, no pulls; OD clear so the PWM drives the pad
+    constexpr uint32_t PAD_PWM_DEFAULT = Pad::Drive::encode(2) | Pad::SlewFast::encode(1) | Pad::InputEnable::encode(1);
+    static_assert((PAD_PWM_DEFAULT & Pad::OutputDisable::mask) == 0);
+
     enum class pwm_mode : uint32_t
     {
         Zero = 0x0,
@@ -40,6 +48,7 @@ namespace SB::RPI5
         uint32_t DutyFifo;
     } PWMGlobalRegs_t;
 
+    // CLK_PWM0 / CLK_PWM1, 0x10 apart in the clocks block
     typedef struct
     {
         uint32_t Pwm0_Cntrl;
@@ -47,11 +56,36 @@ namespace SB::RPI5
         uint32_t Pwm0_DivFrac;
         uint32_t Pwm0_Sel;
     } PWMClockRegs_t;
+
+    typedef struct
+    {
+        uint32_t auxSrc;        // CLK_PWM0_CTRL AUXSRC
+        uint32_t hz;
+        const char *name;
+    } RP1PwmClockSource_t;
+
+    // Inputs of the PWM0 clock mux with a known, fixed rate. Only the crystal
+    // derived 50 MHz input is fixed by the hardware; the PLL taps run at
+    // whatever the firmware set up, so they are not offered by default.
+    inline constexpr RP1PwmClockSource_t RP1_PWM_CLOCK_SOURCES[] = { { 2, 50000000, "xosc" } };
+
+    typedef struct
+    {
+        uint32_t auxSrc;
+        uint32_t sourceHz;      // 0: aux source not in the table
+        uint32_t divInt;        // 1 .. 65535
+        uint32_t divFrac;       // 1/65536
+        uint32_t range;         // CHAN_RANGE, the period is range + 1 pwm clocks
+        double requested;
+        double frequency;       // achieved (after apply: from the registers read back)
+        double errorPpm;        // (frequency - requested) / requested
+        bool cached;            // solveClock() result came from the cache
+    } RP1PwmClockSolution_t;
     
     class RP1PWM : public RP1Base
     {
         public:
-            RP1PWM(std::shared_ptr<CTracer> tracer);
+            RP1PWM(std::shared_ptr<CTracer> tracer, eRp1Backend backend = eRp1Backend::Auto);
             virtual ~RP1PWM();
 
             bool setMode(uint32_t pin, pwm_mode mode);
@@ -62,31 +96,104 @@ namespace SB::RPI5
             bool setClock(uint32_t div, uint32_t frac);
             bool setRangeDutyPhase(uint32_t pin, uint32_t range, uint32_t duty, uint32_t phase);
             bool setFrequencyDuty(uint32_t pin, uint32_t freq, int dutyPrecent);
+            // Solves the clock for freq with at least minSteps duty steps
+            // (range + 1), programs it and the channel, and reads back what
+            // the hardware ended up with. The clock is shared by the channels
+            // of the pin's block: the other channels change frequency with it.
+            bool setFrequencyDuty(uint32_t pin, double freq, double dutyPercent, uint32_t minSteps, RP1PwmClockSolution_t& achieved);
             bool mapPin(uint32_t pin);
 
+            // Duty FIFO: the channel of pin takes one duty word per PWM period
+            // from DUTY_FIFO. The period follows from sampleRate, range is the
+            // duty value for 100 %.
+            bool fifoAttach(uint32_t pin, uint32_t sampleRate, uint32_t& range);
+            bool fifoDetach(uint32_t pin);
+            volatile uint32_t *fifoCtrlReg(int pwmBase = 0);
+            volatile uint32_t *dutyFifoReg(int pwmBase = 0);
+
+            // Channel model: any of the four channels of PWM0 (block 0) and
+            // PWM1 (block 1), whether or not a pin is routed to it. Each block
+            // has its own clock generator, programmed when the block is first
+            // given a mode: PWM1 drives the Pi 5 fan, so it is not touched
+            // before that.
+            bool modeChannel(uint32_t block, uint32_t channel, pwm_mode mode);
+            bool invertChannel(uint32_t block, uint32_t channel, bool bInvert);
+            bool enableChannel(uint32_t block, uint32_t channel, bool bEnable);
+            bool rangeDutyPhaseChannel(uint32_t block, uint32_t channel, uint32_t range, uint32_t duty, uint32_t phase);
+            bool frequencyDutyChannel(uint32_t block, uint32_t channel, double freq, double dutyPercent, uint32_t minSteps,
+                                      RP1PwmClockSolution_t& achieved);
+            bool setClock(uint32_t block, uint32_t div, uint32_t frac);
+
+            // Compile-time pins: a pin without PWM does not compile, and the
+            // block, channel and FUNCSEL are immediates instead of table lookups.
+            template <uint32_t GPIO> bool setMode(RP1PwmPin<GPIO>, pwm_mode mode)
+            {
+                return setModeChannel(GPIO, RP1PwmPin<GPIO>::func, RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, mode);
+            }
+            template <uint32_t GPIO> bool setInvert(RP1PwmPin<GPIO>) { return invertChannel(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, true); }
+            template <uint32_t GPIO> bool clrInvert(RP1PwmPin<GPIO>) { return invertChannel(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, false); }
+            template <uint32_t GPIO> bool Enable(RP1PwmPin<GPIO>) { return enableChannel(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, true); }
+            template <uint32_t GPIO> bool Disable(RP1PwmPin<GPIO>) { return enableChannel(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, false); }
+            template <uint32_t GPIO> bool setRangeDutyPhase(RP1PwmPin<GPIO>, uint32_t range, uint32_t duty, uint32_t phase)
+            {
+                return rangeDutyPhaseChannel(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, range, duty, phase);
+            }
+            template <uint32_t GPIO> bool setFrequencyDuty(RP1PwmPin<GPIO>, uint32_t freq, int dutyPrecent)
+            {
+                RP1PwmClockSolution_t achieved;
+                return frequencyDutyChannel(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, freq, dutyPrecent, DEFAULT_DUTY_STEPS, achieved);
+            }
+            template <uint32_t GPIO> bool setFrequencyDuty(RP1PwmPin<GPIO>, double freq, double dutyPercent, uint32_t minSteps,
+                                                           RP1PwmClockSolution_t& achieved)
+            {
+                return frequencyDutyChannel(RP1PwmPin<GPIO>::pwmBlock, RP1PwmPin<GPIO>::channel, freq, dutyPercent, minSteps, achieved);
+            }
+            template <uint32_t GPIO> bool mapPin(RP1PwmPin<GPIO>) { return setFunction(GPIO, RP1PwmPin<GPIO>::func, PAD_PWM_DEFAULT); }
+
              
             uint32_t getPWMReg_cntrl(uint32_t pin, int pwmbase);
             uint32_t getPWMReg_range(uint32_t pin, int pwmbase);
             uint32_t getPWMReg_phase(uint32_t pin, int pwmbase);
             uint32_t getPWMReg_duty(uint32_t pin, int pwmbase);
-            uint32_t getPwmClockReg_cntrl();
-            uint32_t getPwmClockReg_divInt();
-            uint32_t getPwmClockReg_divFrac();
-            uint32_t getPwmClockReg_Sel();
+            uint32_t getPwmClockReg_cntrl(int pwmBase = 0);
+            uint32_t getPwmClockReg_divInt(int pwmBase = 0);
+            uint32_t getPwmClockReg_divFrac(int pwmBase = 0);
+            uint32_t getPwmClockReg_Sel(int pwmBase = 0);
             uint32_t getGlobalCntrl(int pwmBase);
             uint32_t getFifoCntrl(int pwmBase);
             uint32_t getCommonRange(int pwmBase);
             uint32_t getCommonDuty(int pwmBase);
             uint32_t getDutyFifo(int pwmBase);
             int getPwmIndex(uint32_t pin);
+            int getPwmBlock(uint32_t pin);
+
+            // Best clock source, divider and range for freq: smallest error,
+            // then an integer divider (a fractional one jitters by a source
+            // clock), then the most duty steps. Pure, no registers touched.
+            static bool solveClock(double freq, uint32_t minSteps, bool bAllowFrac, RP1PwmClockSolution_t& solution,
+                                   std::span<const RP1PwmClockSource_t> sources = RP1_PWM_CLOCK_SOURCES);
+            static double clockFrequency(uint32_t sourceHz, uint32_t divInt, uint32_t divFrac, uint32_t range);
+            // Clock registers and the channel range of pin as they are now
+            bool readFrequency(uint32_t pin, RP1PwmClockSolution_t& actual);
+
+            static constexpr uint32_t DEFAULT_DUTY_STEPS = 100;     // whole percents
 
             
         private:
             PWMRegs_t* PwmRegs(int pwmbase = 0);
-            PWMClockRegs_t* PwmClk();
-            const int PWMClock;
+            PWMClockRegs_t* PwmClk(int pwmBase = 0);
+            void applyUpdate(volatile uint32_t *pwmBase);
  
-            bool initClock();
+            bool initClock(uint32_t block);
             uint32_t getFunctionForPWM(uint32_t pin);
+            bool pinChannel(uint32_t pin, uint32_t& block, uint32_t& channel);
+
+            bool setModeChannel(uint32_t pin, uint32_t func, uint32_t block, uint32_t channel, pwm_mode mode);
+            bool solveCached(double freq, uint32_t minSteps, RP1PwmClockSolution_t& solution);
+            bool applyClock(uint32_t block, const RP1PwmClockSolution_t& solution);
+            bool readClock(uint32_t block, RP1PwmClockSolution_t& actual);
+
+            // (frequency, minimum steps): a repeated request skips the search
+            std::map<std::tuple<double, uint32_t>, RP1PwmClockSolution_t> m_clockCache;
     };
 }
\ No newline at end of file
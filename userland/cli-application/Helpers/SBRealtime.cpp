@@ -0,0 +1,236 @@
+#include "SBRealtime.h"
+#include "SBDelay.h"
+#include "../Tracer/cfunctracer.h"
+#include <alloca.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace SB::RPI5
+{
+    namespace
+    {
+        // Touch every page of the buffer with a write of its own value, so
+        // copy-on-write and zero pages are resolved before the section starts.
+        size_t Prefault(void* buffer, size_t size)
+        {
+            const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            volatile uint8_t *p = static_cast<volatile uint8_t*>(buffer);
+            for (size_t off = 0; off < size; off += page)
+                p[off] = p[off];
+            if (size > 0)
+                p[size - 1] = p[size - 1];
+            return size;
+        }
+
+        [[gnu::noinline]] size_t PrefaultStack(size_t size)
+        {
+            if (size == 0)
+                return 0;
+            void *stack = alloca(size);
+            memset(stack, 0, size);
+            asm volatile("" :: "r"(stack) : "memory");
+            return size;
+        }
+    }
+
+    SBRealtime::SBRealtime(std::shared_ptr<CTracer> tracer)
+        : m_trace(tracer)
+    {
+        CFuncTracer trace("SBRealtime::SBRealtime", m_trace);
+    }
+    SBRealtime::~SBRealtime()
+    {
+        CFuncTracer trace("SBRealtime::~SBRealtime", m_trace);
+    }
+
+    SBRealtimeConfig_t SBRealtime::defaultConfig()
+    {
+        return { -1, 80, true, 256 * 1024, true };
+    }
+
+    // First cpu of /sys/devices/system/cpu/isolated ("2", "2-3", "1,3"), -1 if none
+    int SBRealtime::isolatedCpu()
+    {
+        std::ifstream f("/sys/devices/system/cpu/isolated");
+        std::string line;
+        if (!f.is_open() || !std::getline(f, line) || line.empty())
+            return -1;
+        try
+        {
+            return std::stoi(line);
+        }
+        catch (const std::exception&)
+        {
+            return -1;
+        }
+    }
+
+    int SBRealtime::resolveCpu(const SBRealtimeConfig_t& config, SBRealtimeReport_t& report)
+    {
+        report.cpu = config.cpu;
+        report.cpuIsolated = false;
+        if (report.cpu < 0)
+        {
+            report.cpu = isolatedCpu();
+            report.cpuIsolated = (report.cpu >= 0);
+            if (report.cpu < 0)
+            {
+                report.cpu = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN)) - 1;
+                report.warnings.emplace_back(std::format("no isolated cpu (isolcpus=), using cpu {}", report.cpu));
+            }
+        }
+        return report.cpu;
+    }
+
+    bool SBRealtime::validate(const SBRealtimeConfig_t& config, std::string& error)
+    {
+        if ((config.priority < 1) || (config.priority > 99))
+        {
+            error = std::format("rtprio should be 1..99 ({})", config.priority);
+            return false;
+        }
+        const int cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+        if ((config.cpu < -1) || (config.cpu >= cpus) || (config.cpu >= CPU_SETSIZE))
+        {
+            error = std::format("rtcpu should be -1 (auto) or 0..{} ({})", cpus - 1, config.cpu);
+            return false;
+        }
+        return true;
+    }
+
+    void SBRealtime::applyToThisThread(const SBRealtimeConfig_t& config, SBRealtimeReport_t& report)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(report.cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc == 0)
+            report.pinned = true;
+        else
+            report.warnings.emplace_back(std::format("pinning to cpu {} failed: {}", report.cpu, strerror(rc)));
+
+        sched_param param {};
+        param.sched_priority = config.priority;
+        rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc == 0)
+        {
+            report.fifo = true;
+            report.priority = config.priority;
+        }
+        else
+            report.warnings.emplace_back(std::format("SCHED_FIFO {} refused: {} (needs CAP_SYS_NICE or RLIMIT_RTPRIO)",
+                                                     config.priority, strerror(rc)));
+    }
+
+    void SBRealtime::addPrefault(void* buffer, size_t size)
+    {
+        if ((buffer != nullptr) && (size > 0))
+            m_prefault.emplace_back(buffer, size);
+    }
+
+    bool SBRealtime::run(const SBRealtimeConfig_t& config, const std::function<bool()>& critical, SBRealtimeReport_t& report)
+    {
+        CFuncTracer trace("SBRealtime::run", m_trace);
+        try
+        {
+            report = {};
+            std::string error;
+            if (!validate(config, error))
+            {
+                trace.Error("%s", error.c_str());
+                report.warnings.emplace_back(error);
+                return false;
+            }
+            resolveCpu(config, report);
+
+            if (config.lockMemory)
+            {
+                if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+                    report.memoryLocked = true;
+                else
+                    report.warnings.emplace_back(std::format("mlockall failed: {} (needs CAP_IPC_LOCK or RLIMIT_MEMLOCK)", strerror(errno)));
+            }
+            for (const auto& [buffer, size] : m_prefault)
+                report.prefaultedBytes += Prefault(buffer, size);
+            // The RP1 windows are mapped with MAP_POPULATE; they are not touched
+            // here because reading registers can have side effects.
+
+            // Everything the critical thread needs before it starts
+            SBDelay::thresholdNs();
+
+            // Quiet before the worker exists, so not even its first trace line
+            // races the level change; the main thread just waits meanwhile.
+            TracerLevel savedLevel = m_trace ? m_trace->GetTraceLevel() : TracerLevel::TRACER_OFF_LEVEL;
+            if (m_trace && config.quietTracer)
+                m_trace->SetTraceLevel(TracerLevel::TRACER_OFF_LEVEL);
+            bool bResult = false;
+            // An exception of the critical section is carried over to this
+            // thread (it would terminate the worker) and rethrown once the
+            // tracer level and the memory lock are restored
+            std::exception_ptr failure;
+            try
+            {
+                std::thread worker([&]() {
+                    try
+                    {
+                        applyToThisThread(config, report);
+                        report.prefaultedBytes += PrefaultStack(config.stackPrefault);
+
+                        uint64_t t0 = SBDelay::nowNs();
+                        bResult = critical();
+                        report.runNs = SBDelay::nowNs() - t0;
+                    }
+                    catch(...)
+                    {
+                        failure = std::current_exception();
+                    }
+                });
+                worker.join();
+            }
+            catch(...)
+            {
+                failure = std::current_exception();
+            }
+            if (m_trace)
+                m_trace->SetTraceLevel(savedLevel);
+
+            if (report.memoryLocked)
+                munlockall();
+            if (failure)
+                std::rethrow_exception(failure);
+
+            for (const auto& w : report.warnings)
+                trace.Warning("%s", w.c_str());
+            trace.Info("cpu %d%s, pinned %d, fifo %d (prio %d), locked %d, prefault %ld bytes, %llu ns",
+                       report.cpu, report.cpuIsolated ? " (isolated)" : "", report.pinned, report.fifo, report.priority,
+                       report.memoryLocked, report.prefaultedBytes, static_cast<unsigned long long>(report.runNs));
+            return bResult;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+
+    std::string SBRealtime::formatReport(const SBRealtimeReport_t& report)
+    {
+        std::ostringstream os;
+        os << std::format("realtime: cpu {}{} pinned={} fifo={} prio={} mlock={} prefault={} KiB run={:.1f} us\n",
+                          report.cpu, report.cpuIsolated ? " (isolated)" : "", report.pinned ? "yes" : "no",
+                          report.fifo ? "yes" : "no", report.priority, report.memoryLocked ? "yes" : "no",
+                          report.prefaultedBytes / 1024, report.runNs / 1000.0);
+        for (const auto& w : report.warnings)
+            os << "  fallback: " << w << "\n";
+        return os.str();
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../Tracer/ctracer.h"
+
+namespace SB::RPI5
+{
+    typedef struct
+    {
+        int cpu;                    // -1: first isolated cpu (isolcpus), else the last cpu
+        int priority;               // SCHED_FIFO priority 1..99
+        bool lockMemory;            // mlockall(MCL_CURRENT | MCL_FUTURE)
+        size_t stackPrefault;       // bytes of the critical thread stack touched up front
+        bool quietTracer;           // tracer level OFF while the critical section runs
+    } SBRealtimeConfig_t;
+
+    // What was granted; the critical section runs either way.
+    typedef struct
+    {
+        int cpu;
+        bool cpuIsolated;
+        bool pinned;
+        bool fifo;
+        int priority;
+        bool memoryLocked;
+        size_t prefaultedBytes;
+        uint64_t runNs;
+        std::vector<std::string> warnings;
+    } SBRealtimeReport_t;
+
+    // Runs a timing critical section on its own thread: pinned to one cpu,
+    // SCHED_FIFO, memory locked and prefaulted, tracer quiet. Every step that
+    // needs privileges (CAP_SYS_NICE, CAP_IPC_LOCK / RLIMIT_MEMLOCK) is tried;
+    // a refused step is reported and the section runs without it.
+    class SBRealtime
+    {
+        public:
+            SBRealtime(std::shared_ptr<CTracer> tracer);
+            virtual ~SBRealtime();
+
+            static SBRealtimeConfig_t defaultConfig();
+            static int isolatedCpu();
+            // cpu pinning and SCHED_FIFO for the calling thread (report.cpu must
+            // be resolved); for threads that live longer than one run()
+            static void applyToThisThread(const SBRealtimeConfig_t& config, SBRealtimeReport_t& report);
+            static int resolveCpu(const SBRealtimeConfig_t& config, SBRealtimeReport_t& report);
+            // priority 1..99, cpu -1 or an online cpu; error says what is wrong
+            static bool validate(const SBRealtimeConfig_t& config, std::string& error);
+
+            // Buffers the section will touch (capture buffers etc.); they are
+            // locked and every page is written once before the section starts.
+            void addPrefault(void* buffer, size_t size);
+
+            // Returns false without changing any state for a config that fails validate()
+            bool run(const SBRealtimeConfig_t& config, const std::function<bool()>& critical, SBRealtimeReport_t& report);
+
+            static std::string formatReport(const SBRealtimeReport_t& report);
+
+        private:
+            std::shared_ptr<CTracer> m_trace;
+            std::vector<std::pair<void*, size_t>> m_prefault;
+    };
+}
@@ -8,14 +8,22 @@
 #include <stdint.h>
 #include <chrono>
 #include <thread>
+#include <algorithm>
+#include <format>
 #include "../Tracer/cfunctracer.h"
 #include "RP1Base.h"
 #include "SBRp1IO.h"
+#include "RP1Fields.h"
+#include "RP1Waveform.h"
+#include "RP1Port.h"
+#include "RP1Timer.h"
+#include "RP1Wait.h"
+#include "SBDelay.h"
 
 namespace SB::RPI5
 {
-    RP1IO::RP1IO(std::shared_ptr<CTracer> tracer)
-        : RP1Base(tracer)
+    RP1IO::RP1IO(std::shared_ptr<CTracer> tracer, eRp1Backend backend)
+        : RP1Base(tracer, backend)
     {
         CFuncTracer trace("RP1IO::RP1IO", m_trace);
         try
@@ -66,7 +74,9 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioClear = nullptr)");
                 return false;
             }
-            RioClear()->OE = mask;
+            rp1_write(&RioClear()->OE, mask);
+            m_shadow.oe &= ~mask;
+            shadowWritten();
             return true;
         }
         catch(const std::exception& e)
@@ -85,7 +95,9 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioSet = nullptr)");
                 return false;
             }
-            RioSet()->OE = mask;
+            rp1_write(&RioSet()->OE, mask);
+            m_shadow.oe |= mask;
+            shadowWritten();
             return true;
         }
         catch(const std::exception& e)
@@ -104,7 +116,11 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioXor = nullptr)");
                 return false;
             }
-            RioXor()->OE = (RioBase()->Out ^ value) & mask;
+            uint32_t oe = shadowCovers(mask) ? m_shadow.oe : rp1_read(&RioBase()->OE);
+            uint32_t diff = (oe ^ value) & mask;
+            rp1_write(&RioXor()->OE, diff);
+            m_shadow.oe = (m_shadow.oe & ~mask) | (value & mask);
+            shadowWritten();
             return true;
         }
         catch(const std::exception& e)
@@ -124,7 +140,9 @@ namespace SB::RPI5
                 return false;
             }
 
-            RioSet()->Out = mask;
+            rp1_write(&RioSet()->Out, mask);
+            m_shadow.out |= mask;
+            shadowWritten();
             return true;
         }
          catch(const std::exception& e)
@@ -143,7 +161,9 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioClear = nullptr)");
                 return false;
             }
-            RioClear()->Out = mask;
+            rp1_write(&RioClear()->Out, mask);
+            m_shadow.out &= ~mask;
+            shadowWritten();
             return true;
         }
          catch(const std::exception& e)
@@ -162,7 +182,9 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioXor = nullptr)");
                 return false;
             }
-            RioXor()->Out = mask;
+            rp1_write(&RioXor()->Out, mask);
+            m_shadow.out ^= mask;
+            shadowWritten();
             return true;
         }
          catch(const std::exception& e)
@@ -176,11 +198,22 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::SetGpioPin", m_trace);
         try
         {
-            uint32_t mask = 1ul << pin;
+            Pin p = this->pin(static_cast<uint32_t>(pin));
+            if (!p.valid())
+            {
+                trace.Error("GPIO%d is not an RP1 pin or RP1IO is not initialized", pin);
+                return false;
+            }
+            // Bank 0 goes through the masks, which keep the shadow up to date
+            if (p.bank() != 0)
+            {
+                p.write(value);
+                return true;
+            }
             if(value)
-                return setGpioMask(mask);
+                return setGpioMask(p.mask());
             else
-                return clearGpioMask(mask);
+                return clearGpioMask(p.mask());
         }
         catch(const std::exception& e)
         {
@@ -199,9 +232,12 @@ namespace SB::RPI5
                 return false;
             }
 
-
-            RioXor()->Out = (RioBase()->Out ^ value) & mask;
-            return true;            
+            uint32_t out = shadowCovers(mask) ? m_shadow.out : rp1_read(&RioBase()->Out);
+            uint32_t diff = (out ^ value) & mask;
+            rp1_write(&RioXor()->Out, diff);
+            m_shadow.out = (m_shadow.out & ~mask) | (value & mask);
+            shadowWritten();
+            return true;
         }
         catch(const std::exception& e)
         {
@@ -215,13 +251,13 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::GetGpioPin", m_trace);
         try
         {
-            if (RioBase() == nullptr)
+            Pin p = this->pin(static_cast<uint32_t>(pin));
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (RioXor = nullptr)");
+                trace.Error("GPIO%d is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
-
-            return RioBase()->In & (1u << pin);
+            return p.read();
         }
         catch(const std::exception& e)
         {
@@ -239,7 +275,7 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioClear = nullptr)");
                 return (uint32_t) -1;
             }
-            return RioBase()->In;            
+            return rp1_read(&RioBase()->In);            
         }
         catch(const std::exception& e)
         {
@@ -252,16 +288,14 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::setGpioPullUpPullDown", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
 
-            PAD[pin] &= ~0xC;
-            if (up) setGpioPullUp(pin);
-            if (down) setGpioPullDown(pin);
+            p.padApply(Pad::PullUp::val(up) | Pad::PullDown::val(down));
             return true;
         }
         catch(const std::exception& e)
@@ -275,14 +309,13 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::setGpioPullDown", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
-            PAD[pin] &= ~0xC;
-            PAD[pin] |= 0x4;
+            p.padApply(Pad::PullUp::val(0) | Pad::PullDown::val(1));
             return true;
         }
         catch(const std::exception& e)
@@ -296,15 +329,14 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::setGpioPullUp", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
 
-            PAD[pin] &= ~0xC;
-            PAD[pin] |= 0x8;
+            p.padApply(Pad::PullUp::val(1) | Pad::PullDown::val(0));
             return true;
         }
         catch(const std::exception& e)
@@ -318,14 +350,14 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::disabledGpioPulls", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
 
-            PAD[pin] &= ~0xC;
+            p.padApply(Pad::Pulls::val(0));
             return true;
         }
         catch(const std::exception& e)
@@ -339,15 +371,14 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::setGpioInputHysteris", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
 
-            PAD[pin] &= ~0x02;
-            if (enabled) PAD[pin] |= 0x02;
+            p.padApply(Pad::Schmitt::val(enabled));
             return true;
         }
         catch(const std::exception& e)
@@ -361,15 +392,13 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::setGpioSlewRate", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
-            PAD[pin] &= ~0x01;
-            if (slew == eGpioSlewRate::eFast)
-                PAD[pin] |= 0x01;
+            p.padApply(Pad::SlewFast::val(slew == eGpioSlewRate::eFast));
             return true;
         }
         catch(const std::exception& e)
@@ -383,19 +412,20 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::setGpioDriveStrength", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
-            PAD[pin] &= ~0x30;
             switch(drive)
             {
-                case eGpioDrive::eCurrent_2mA: break;
-                case eGpioDrive::eCurrent_4mA: PAD[pin] |= 0x10; break;
-                case eGpioDrive::eCurrent_8mA: PAD[pin] |= 0x20; break;
-                case eGpioDrive::eCurrent_12mA: PAD[pin] |= 0x30; break;
+                case eGpioDrive::eCurrent_2mA:
+                case eGpioDrive::eCurrent_4mA:
+                case eGpioDrive::eCurrent_8mA:
+                case eGpioDrive::eCurrent_12mA:
+                    p.padApply(Pad::Drive::val(static_cast<uint32_t>(drive)));
+                    break;
 
                 default:
                     trace.Error("Unknown drive : %ld", drive);
@@ -414,13 +444,13 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::isGpioPullUp", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
-            return PAD[pin] & 0x08 == 0x08;
+            return Pad::PullUp::decode(p.pad()) != 0;
         }
         catch(const std::exception& e)
         {
@@ -433,13 +463,13 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::isGpioPullDown", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
-            return PAD[pin] & 0x04 == 0x04;
+            return Pad::PullDown::decode(p.pad()) != 0;
         }
         catch(const std::exception& e)
         {
@@ -452,13 +482,13 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::isGpioHysterisEnabled", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return false;
             }
-            return PAD[pin] & 0x02 == 0x02;
+            return Pad::Schmitt::decode(p.pad()) != 0;
         }
         catch(const std::exception& e)
         {
@@ -471,14 +501,14 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::getGpioSlewRate", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return eGpioSlewRate::eUnknown;
             }
 
-            return (PAD[pin] & 0x01 == 0x1)? eGpioSlewRate::eFast : eGpioSlewRate::eSlow;
+            return Pad::SlewFast::decode(p.pad())? eGpioSlewRate::eFast : eGpioSlewRate::eSlow;
         }
         catch(const std::exception& e)
         {
@@ -491,18 +521,15 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::getGpioDrive", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return eGpioDrive::eUnknown;
             }
 
-            return (PAD[pin] & 0x30 == 0x00)? eGpioDrive::eCurrent_2mA :
-                   (PAD[pin] & 0x30 == 0x01)? eGpioDrive::eCurrent_4mA :
-                   (PAD[pin] & 0x30 == 0x02)? eGpioDrive::eCurrent_8mA :
-                   (PAD[pin] & 0x30 == 0x30)? eGpioDrive::eCurrent_12mA :
-                   eGpioDrive::eUnknown;
+            // eGpioDrive follows the DRIVE field encoding (0 = 2mA .. 3 = 12mA)
+            return static_cast<eGpioDrive>(Pad::Drive::decode(p.pad()));
         }
         catch(const std::exception& e)
         {
@@ -516,13 +543,13 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::getGpioStatus", m_trace);
         try
         {
-            volatile RP1_GPIO_Regs_t* pGpioBase = RP1Base::GPIOBase();
-            if (pGpioBase == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (GPIOBase = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return static_cast<uint32_t>(-1);
             }
-            uint32_t status = pGpioBase[pin].status;
+            uint32_t status = p.status();
             trace.Info("status : 0x%p", status);
             return status;
         }
@@ -537,13 +564,13 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::getGpioCntrl", m_trace);
         try
         {
-            volatile RP1_GPIO_Regs_t* pGpioBase = RP1Base::GPIOBase();
-            if (pGpioBase == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (GPIOBase = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return (uint32_t)-1;
             }
-            return pGpioBase[pin].ctrl;
+            return p.ctrl();
         }
         catch(const std::exception& e)
         {
@@ -562,7 +589,7 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioBase = nullptr)");
                 return static_cast<uint32_t>(-1);
             }
-            return pRioBase->Out;
+            return rp1_read(&pRioBase->Out);
         }
         catch(const std::exception& e)
         {
@@ -581,7 +608,7 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioBase = nullptr)");
                 return static_cast<uint32_t>(-1);
             }
-            return pRioBase->OE;
+            return rp1_read(&pRioBase->OE);
         }
         catch(const std::exception& e)
         {
@@ -600,7 +627,7 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioBase = nullptr)");
                 return static_cast<uint32_t>(-1);
             }
-            return pRioBase->In;
+            return rp1_read(&pRioBase->In);
         }
         catch(const std::exception& e)
         {
@@ -619,7 +646,7 @@ namespace SB::RPI5
                 trace.Error("RP1IO is not initialized (RioBase = nullptr)");
                 return static_cast<uint32_t>(-1);
             }
-            return pRioBase->InSync;
+            return rp1_read(&pRioBase->InSync);
         }
         catch(const std::exception& e)
         {
@@ -632,13 +659,13 @@ namespace SB::RPI5
         CFuncTracer trace("RP1IO::getPad", m_trace);
         try
         {
-            volatile uint32_t *PAD = pad();
-            if (PAD == nullptr)
+            Pin p = this->pin(pin);
+            if (!p.valid())
             {
-                trace.Error("RP1IO is not initialized (m_pad = nullptr)");
+                trace.Error("GPIO%u is not an RP1 pin or RP1IO is not initialized", pin);
                 return static_cast<uint32_t>(-1);
             }
-            uint32_t pad = PAD[pin];
+            uint32_t pad = p.pad();
             trace.Info("pad : 0x%p", pad);
             return pad;
         }
@@ -652,56 +679,51 @@ namespace SB::RPI5
     bool RP1IO::SetPulse(int pin, int widthus, int LeadPulseTimeUs, int PostPulseTimeUs, eRp1IoPulseType tp, bool bListen)
     {
         CFuncTracer trace("RP1IO::SetPulse", m_trace);
-        using namespace std::chrono;
         try
         {
+            // RP1Waveform steps are 32-bit nanoseconds: at most 4294967 us each
+            constexpr int MAX_STEP_US = static_cast<int>(UINT32_MAX / 1000u);
+            if ((pin < 0) || (pin >= static_cast<int>(RP1_BANK_PINS[0])))
+            {
+                trace.Error("GPIO%d is not a RIO bank 0 pin", pin);
+                return false;
+            }
+            if ((widthus < 0) || (widthus > MAX_STEP_US) || (LeadPulseTimeUs < 0) || (LeadPulseTimeUs > MAX_STEP_US) ||
+                (PostPulseTimeUs < 0) || (PostPulseTimeUs > MAX_STEP_US))
+            {
+                trace.Error("pulse times should be 0..%d us (width %d, lead %d, post %d)", MAX_STEP_US, widthus,
+                            LeadPulseTimeUs, PostPulseTimeUs);
+                return false;
+            }
             uint32_t mask = 1ul << pin;
             if (setDirOutMask(mask) == false)
             {
                 trace.Error("Failed to set the pin %ld to output", pin);
             }
-            if (tp == eRp1IoPulseType::ePositive)
+            Fast io = fast(mask);
+            if (!io.valid())
             {
-                if (setGpioPin(pin, 0) == false)
-                {
-                    trace.Error("failed to set positive pulse initial level (setGpioPin %ld low )", pin);
-                    return false;
-                } 
-                if (LeadPulseTimeUs > 0) std::this_thread::sleep_for(microseconds(LeadPulseTimeUs));
-                if (setGpioPin(pin, 1) == false)
-                {
-                    trace.Error("failed to set positive pulse level (setGpioPin %ld high )", pin);
-                    return false;
-                }
-                if (widthus > 0) std::this_thread::sleep_for(microseconds(widthus));
-                if (setGpioPin(pin, 0) == false)
-                {
-                    trace.Error("failed to set positive pulse post level (setGpioPin %ld low )", pin);
-                    return false;
-                }
-                if (PostPulseTimeUs > 0) std::this_thread::sleep_for(microseconds(PostPulseTimeUs));
+                trace.Error("no RIO access to pin %ld", pin);
+                return false;
             }
-            else
+
+            // lead level, pulse, post level; timed on the generic timer instead of sleep_for
+            uint32_t idle = (tp == eRp1IoPulseType::ePositive) ? 0 : mask;
+            RP1Waveform wave(m_trace);
+            wave.add(mask, idle, static_cast<uint32_t>(LeadPulseTimeUs) * 1000u)
+                .add(mask, ~idle, static_cast<uint32_t>(widthus) * 1000u)
+                .add(mask, idle, static_cast<uint32_t>(PostPulseTimeUs) * 1000u);
+            if (!wave.compile() || !wave.run(io))
             {
-                if (setGpioPin(pin, 1) == false)
-                {
-                    trace.Error("failed to set positive pulse initial level (setGpioPin %ld high )", pin);
-                    return false;
-                }
-                if (LeadPulseTimeUs > 0) std::this_thread::sleep_for(microseconds(LeadPulseTimeUs));
-                if (setGpioPin(pin, 0) == false)
-                {
-                    trace.Error("failed to set positive pulse level (setGpioPin %ld low )", pin);
-                    return false;
-                }
-                if (widthus > 0) std::this_thread::sleep_for(microseconds(widthus));
-                if (setGpioPin(pin, 1) == false)
-                {
-                    trace.Error("failed to set positive pulse post level (setGpioPin %ld high )", pin);
-                    return false;
-                }
-                if (PostPulseTimeUs > 0) std::this_thread::sleep_for(microseconds(PostPulseTimeUs));
+                trace.Error("failed to generate the pulse on pin %ld", pin);
+                return false;
             }
+            m_shadow.out = (m_shadow.out & ~mask) | idle;
+            shadowWritten();
+
+            auto results = wave.results();
+            trace.Info("pulse width requested %d us, achieved %llu ns", widthus,
+                       static_cast<unsigned long long>(results[2].achievedNs - results[1].achievedNs));
 
             if (bListen)
             {
@@ -727,8 +749,200 @@ namespace SB::RPI5
             uint32_t mask = 1ul << pin;
             for(int i=0; i < periods; i++)
             {
-                RioXor()->Out = mask;
+                rp1_write(&RioXor()->Out, mask);
+            }
+            if (periods & 1)
+                m_shadow.out ^= mask;
+            shadowWritten();
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+        }
+        return false;
+    }
+
+    bool RP1IO::enableShadow(uint32_t mask, uint32_t resyncEvery)
+    {
+        CFuncTracer trace("RP1IO::enableShadow", m_trace);
+        try
+        {
+            m_shadow.mask = mask;
+            m_shadow.resyncEvery = resyncEvery;
+            if (!resyncShadow())
+                return false;
+            m_shadow.enabled = true;
+            trace.Trace("shadow mask 0x%08x, resync every %u writes", mask, resyncEvery);
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+    void RP1IO::disableShadow()
+    {
+        CFuncTracer trace("RP1IO::disableShadow", m_trace);
+        m_shadow.enabled = false;
+    }
+    bool RP1IO::resyncShadow()
+    {
+        CFuncTracer trace("RP1IO::resyncShadow", m_trace);
+        try
+        {
+            if (RioBase() == nullptr)
+            {
+                trace.Error("RP1IO is not initialized (RioBase = nullptr)");
+                return false;
+            }
+            m_shadow.out = rp1_read(&RioBase()->Out);
+            m_shadow.oe = rp1_read(&RioBase()->OE);
+            m_shadow.writes = 0;
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return false;
+    }
+    // Bookkeeping after every RIO write; the periodic resync is two reads and
+    // is not traced.
+    void RP1IO::shadowWritten()
+    {
+        if (!m_shadow.enabled || (m_shadow.resyncEvery == 0))
+            return;
+        if (++m_shadow.writes >= m_shadow.resyncEvery)
+        {
+            m_shadow.out = rp1_read(&RioBase()->Out);
+            m_shadow.oe = rp1_read(&RioBase()->OE);
+            m_shadow.writes = 0;
+        }
+    }
+
+    RP1IO::Fast RP1IO::fast(uint32_t mask)
+    {
+        CFuncTracer trace("RP1IO::fast", m_trace);
+        try
+        {
+            if (RIOBase() == nullptr)
+            {
+                trace.Error("RP1IO is not initialized (RioBase = nullptr)");
+                return Fast();
+            }
+            const uint32_t bankMask = (1u << RP1_BANK_PINS[0]) - 1;
+            if ((mask == 0) || ((mask & ~bankMask) != 0))
+            {
+                trace.Error("mask 0x%08x is not a set of bank 0 pins (0x%08x)", mask, bankMask);
+                return Fast();
+            }
+            for (uint32_t pin = 0; pin < RP1_BANK_PINS[0]; ++pin)
+            {
+                if ((mask & (1u << pin)) && (getGpioCntrl(pin) & GpioCtrl::FuncSel::mask) != GPIO_FUNC_RIO)
+                    trace.Warning("GPIO%u is not routed to RIO, fast writes will not reach the pad", pin);
+            }
+            trace.Trace("fast handle for mask 0x%08x", mask);
+            return Fast(RIOBase(), mask);
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return Fast();
+    }
+
+    RP1IO::Pin RP1IO::pin(uint32_t gpio)
+    {
+        CFuncTracer trace("RP1IO::pin", m_trace, false);
+        try
+        {
+            if ((RIOBase() == nullptr) || (RP1Base::GPIOBase() == nullptr) || (PADBase() == nullptr))
+            {
+                trace.Error("RP1IO is not initialized");
+                return Pin();
+            }
+            uint32_t bank = 0, index = 0;
+            if (!rp1_pin_location(gpio, bank, index))
+            {
+                trace.Error("GPIO%u is not an RP1 pin (0..%u)", gpio, RP1_PIN_COUNT - 1);
+                return Pin();
+            }
+            const size_t block = bank * (RP1_BLOCK_SIZE / 4);
+            volatile uint32_t *rio = RIOBase() + block;
+            volatile uint32_t *gpioBlock = reinterpret_cast<uint32_t*>(RP1Base::GPIOBase()) + block;
+            volatile uint32_t *padBlock = PADBase() + block + 1;       // + 0 is VOLTAGE_SELECT
+
+            Pin p;
+            p.m_out = Rio::Out::at(rio);
+            p.m_outSet = rp1_alias(p.m_out, eRp1Alias::Set);
+            p.m_outClr = rp1_alias(p.m_out, eRp1Alias::Clr);
+            p.m_outXor = rp1_alias(p.m_out, eRp1Alias::Xor);
+            p.m_oeSet = rp1_alias(Rio::OE::at(rio), eRp1Alias::Set);
+            p.m_oeClr = rp1_alias(Rio::OE::at(rio), eRp1Alias::Clr);
+            p.m_in = Rio::In::at(rio);
+            p.m_inSync = Rio::InSync::at(rio);
+            p.m_status = GpioStatus::Reg::at(gpioBlock, index);
+            p.m_ctrl = GpioCtrl::Reg::at(gpioBlock, index);
+            p.m_pad = Pad::Reg::at(padBlock, index);
+            p.m_bit = 1u << index;
+            p.m_gpio = gpio;
+            p.m_bank = bank;
+            p.m_index = index;
+            return p;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return Pin();
+    }
+
+    RP1Port RP1IO::port(const std::vector<uint32_t>& pins)
+    {
+        CFuncTracer trace("RP1IO::port", m_trace);
+        try
+        {
+            uint32_t mask = 0;
+            for (uint32_t pin : pins)
+            {
+                if ((pin >= RP1_BANK_PINS[0]) || (mask & (1u << pin)))
+                {
+                    trace.Error("GPIO%u is outside bank 0 or used twice", pin);
+                    return RP1Port();
+                }
+                mask |= 1u << pin;
+            }
+            if (pins.empty() || (pins.size() > 32))
+            {
+                trace.Error("a port has 1..32 pins (%ld given)", pins.size());
+                return RP1Port();
             }
+            Fast io = fast(mask);
+            if (!io.valid())
+                return RP1Port();
+            trace.Trace("port of %ld pins, mask 0x%08x", pins.size(), mask);
+            return RP1Port(io, pins);
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+        }
+        return RP1Port();
+    }
+
+    bool RP1IO::snapshot(RP1Snapshot_t& snap)
+    {
+        CFuncTracer trace("RP1IO::snapshot", m_trace);
+        try
+        {
+            if ((mapping() == nullptr) || !RP1Snapshot::capture(*mapping(), snap))
+            {
+                trace.Error("RP1 registers are not mapped");
+                return false;
+            }
+            trace.Trace("captured %u pins in %llu ns", RP1_PIN_COUNT, static_cast<unsigned long long>(snap.durationNs));
             return true;
         }
         catch(const std::exception& e)
@@ -737,4 +951,89 @@ namespace SB::RPI5
         }
         return false;
     }
-}
\ No newline at end of file
+
+    bool RP1IO::applyProfile(const RP1PinProfile_t& profile, RP1ProfileResult_t& result, bool bWrite,
+                             std::vector<std::string>& errors)
+    {
+        CFuncTracer trace("RP1IO::applyProfile", m_trace);
+        try
+        {
+            result.writes = 0;
+            result.writeNs = 0;
+            result.mismatches.clear();
+            if ((RP1Base::GPIOBase() == nullptr) || (pad() == nullptr) || (RIOBase() == nullptr))
+            {
+                errors.emplace_back("RP1 registers are not mapped");
+                return false;
+            }
+            const uint64_t t0 = rp1_ticks();
+            if (!RP1PinProfile::validate(profile, errors) || !snapshot(result.before) ||
+                !RP1PinProfile::plan(profile, result.before, result.target, errors))
+            {
+                trace.Error("profile %s is not applied", profile.name.c_str());
+                return false;
+            }
+            const uint64_t t1 = rp1_ticks();
+            result.planNs = rp1_ticks_to_ns(t1 - t0);
+            if (!bWrite)
+                return true;
+
+            result.writes = RP1PinProfile::write(reinterpret_cast<volatile uint32_t*>(RP1Base::GPIOBase()), pad(), RIOBase(),
+                                                 result.before.bank[0], result.target.bank[0]);
+            rp1_mb();
+            result.writeNs = rp1_ticks_to_ns(rp1_ticks() - t1);
+
+            if (!snapshot(result.after))
+                return false;
+            result.mismatches = RP1PinProfile::verify(result.target, result.after);
+            trace.Info("profile %s: %ld pins, %u writes in %llu ns, %ld mismatches", profile.name.c_str(), profile.pins.size(),
+                       result.writes, static_cast<unsigned long long>(result.writeNs), result.mismatches.size());
+            return true;
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+            errors.emplace_back(std::format("exception occurred : {0}", e.what()));
+        }
+        return false;
+    }
+    int RP1IO::measRC(uint32_t pin, uint64_t dischargeUs, uint64_t timeoutUs, RP1WaitResult_t& result,
+                      std::vector<std::string>& errors)
+    {
+        CFuncTracer trace("RP1IO::measRC", m_trace);
+        try
+        {
+            Pin p = this->pin(pin);
+            if (!p.valid())
+            {
+                errors.emplace_back(std::format("measRC: GPIO{0} is not an RP1 pin or RP1IO is not initialized", pin));
+                return -1;
+            }
+
+            // 1) Discharge: RIO, output low
+            p.clear();
+            p.output();
+            p.setFunction(GPIO_FUNC_RIO);
+            p.padApply(Pad::Pulls::val(0) | Pad::InputEnable::val(1) | Pad::OutputDisable::val(0));
+            SBDelay::us(dischargeUs);
+
+            // 2) Release and wait for the charge to cross the input threshold
+            p.input();
+            if (!RP1Wait::waitForBits(p.inSync(), p.mask(), p.mask(), timeoutUs * 1000ull, result))
+            {
+                errors.emplace_back(std::format("measRC: timeout waiting for RC charge on pin {0}", pin));
+                return -1;
+            }
+            const uint64_t ns = rp1_ticks_to_ns(result.ticks - result.startTicks);
+            trace.Info("GPIO%u high after %llu ns, %llu reads, %llu back-offs", pin, static_cast<unsigned long long>(ns),
+                       static_cast<unsigned long long>(result.reads), static_cast<unsigned long long>(result.backoffs));
+            return static_cast<int>(ns / 1000);
+        }
+        catch(const std::exception& e)
+        {
+            trace.Error("Exception occurred : %s", e.what());
+            errors.emplace_back(std::format("exception occurred : {0}", e.what()));
+        }
+        return -1;
+    }
+}
@@ -5,10 +5,16 @@
 #include <linux/gpio.h>
 #include <gpiod.h>
 #include "RP1Base.h"
+#include "RP1Snapshot.h"
+#include "RP1PinProfile.h"
+#include "RP1Pins.h"
+#include "RP1Wait.h"
+#include "RP1Fields.h"
 #include "../Tracer/ctracer.h"
 
 namespace SB::RPI5
 {
+    class RP1Port;
 
     typedef struct 
     {
@@ -18,6 +24,17 @@ namespace SB::RPI5
         uint32_t InSync;
     } RP1_Regs_t;
 
+    // Process-local copy of RIO Out/OE for the pins an RP1IO owns
+    typedef struct
+    {
+        bool enabled;
+        uint32_t mask;          // owned pins, only these bits of out/oe are trusted
+        uint32_t out;
+        uint32_t oe;
+        uint32_t resyncEvery;   // re-read the hardware after this many writes (0 = never)
+        uint32_t writes;
+    } RP1RioShadow_t;
+
     enum class eGpioSlewRate
     {
         eFast,
@@ -44,7 +61,113 @@ namespace SB::RPI5
     class RP1IO: public RP1Base
     {
     public:
-        RP1IO(std::shared_ptr<CTracer> tracer);
+        // Untraced bank 0 RIO access for timing critical loops. Get one with
+        // RP1IO::fast(); the pins are checked there, the operations themselves
+        // are single register accesses without checks, tracing or exceptions.
+        // The handle is only valid while the RP1IO that created it exists.
+        class Fast
+        {
+        public:
+            Fast() noexcept = default;
+
+            bool valid() const noexcept { return m_rio != nullptr; }
+            uint32_t mask() const noexcept { return m_mask; }
+
+            [[gnu::always_inline]] void set(uint32_t mask) const noexcept { rp1_set_bits(Rio::Out::at(m_rio), mask); }
+            [[gnu::always_inline]] void clear(uint32_t mask) const noexcept { rp1_clr_bits(Rio::Out::at(m_rio), mask); }
+            [[gnu::always_inline]] void toggle(uint32_t mask) const noexcept { rp1_xor_bits(Rio::Out::at(m_rio), mask); }
+            // Pins of mask to value: SET then CLR alias, no read. Pins going
+            // high change one write before pins going low.
+            [[gnu::always_inline]] void write(uint32_t mask, uint32_t value) const noexcept
+            {
+                set(value & mask);
+                clear(~value & mask);
+            }
+            [[gnu::always_inline]] void setPin(uint32_t pin, bool value) const noexcept
+            {
+                rp1_write(rp1_alias(Rio::Out::at(m_rio), value ? eRp1Alias::Set : eRp1Alias::Clr), 1u << pin);
+            }
+
+            [[gnu::always_inline]] uint32_t read() const noexcept { return Rio::In::read(m_rio); }
+            [[gnu::always_inline]] uint32_t readSync() const noexcept { return Rio::InSync::read(m_rio); }
+            [[gnu::always_inline]] uint32_t readOut() const noexcept { return Rio::Out::read(m_rio); }
+            [[gnu::always_inline]] bool getPin(uint32_t pin) const noexcept { return (read() >> pin) & 1u; }
+
+            [[gnu::always_inline]] void output(uint32_t mask) const noexcept { rp1_set_bits(Rio::OE::at(m_rio), mask); }
+            [[gnu::always_inline]] void input(uint32_t mask) const noexcept { rp1_clr_bits(Rio::OE::at(m_rio), mask); }
+
+        private:
+            friend class RP1IO;
+            Fast(volatile uint32_t *rio, uint32_t mask) noexcept : m_rio(rio), m_mask(mask) {}
+
+            volatile uint32_t *m_rio = nullptr;
+            uint32_t m_mask = 0;
+        };
+
+        // One RP1 pin on any bank (GPIO0..53). RP1IO::pin() resolves the bank,
+        // its RIO / GPIO / PAD blocks and the bit once; every operation is
+        // then one load or store through a pointer kept in the handle. Like
+        // Fast, the handle is only valid while the RP1IO that created it exists.
+        class Pin
+        {
+        public:
+            Pin() noexcept = default;
+
+            bool valid() const noexcept { return m_outSet != nullptr; }
+            uint32_t gpio() const noexcept { return m_gpio; }
+            uint32_t bank() const noexcept { return m_bank; }
+            uint32_t index() const noexcept { return m_index; }     // pin inside the bank
+            uint32_t mask() const noexcept { return m_bit; }        // bit in the bank's RIO words
+
+            [[gnu::always_inline]] void set() const noexcept { rp1_write(m_outSet, m_bit); }
+            [[gnu::always_inline]] void clear() const noexcept { rp1_write(m_outClr, m_bit); }
+            [[gnu::always_inline]] void toggle() const noexcept { rp1_write(m_outXor, m_bit); }
+            [[gnu::always_inline]] void write(bool value) const noexcept { rp1_write(value ? m_outSet : m_outClr, m_bit); }
+            [[gnu::always_inline]] bool read() const noexcept { return (rp1_read(m_in) & m_bit) != 0; }
+            [[gnu::always_inline]] bool readSync() const noexcept { return (rp1_read(m_inSync) & m_bit) != 0; }
+            [[gnu::always_inline]] bool readOut() const noexcept { return (rp1_read(m_out) & m_bit) != 0; }
+            [[gnu::always_inline]] void output() const noexcept { rp1_write(m_oeSet, m_bit); }
+            [[gnu::always_inline]] void input() const noexcept { rp1_write(m_oeClr, m_bit); }
+            // For register waits (RP1Wait::waitForBits(in(), mask(), ...))
+            const volatile uint32_t *in() const noexcept { return m_in; }
+            const volatile uint32_t *inSync() const noexcept { return m_inSync; }
+
+            uint32_t status() const noexcept { return rp1_read(m_status); }
+            uint32_t ctrl() const noexcept { return rp1_read(m_ctrl); }
+            uint32_t pad() const noexcept { return rp1_read(m_pad); }
+            uint32_t function() const noexcept { return GpioCtrl::FuncSel::decode(ctrl()); }
+            // Write-only PAD update through the SET/CLR aliases (see rp1_apply)
+            void padApply(RP1FieldSet<Pad::Reg> fields) const noexcept { rp1_apply(m_pad, 0, fields); }
+            // FUNCSEL through NULL (all ones) and down, as RP1Base::setFunction
+            void setFunction(uint32_t func) const noexcept
+            {
+                rp1_set_bits(m_ctrl, GpioCtrl::FuncSel::mask);
+                const uint32_t clear = GpioCtrl::FuncSel::mask & ~GpioCtrl::FuncSel::encode(func);
+                if (clear != 0)
+                    rp1_clr_bits(m_ctrl, clear);
+            }
+
+        private:
+            friend class RP1IO;
+
+            volatile uint32_t *m_outSet = nullptr;
+            volatile uint32_t *m_outClr = nullptr;
+            volatile uint32_t *m_outXor = nullptr;
+            volatile uint32_t *m_oeSet = nullptr;
+            volatile uint32_t *m_oeClr = nullptr;
+            volatile uint32_t *m_out = nullptr;
+            volatile uint32_t *m_in = nullptr;
+            volatile uint32_t *m_inSync = nullptr;
+            volatile uint32_t *m_status = nullptr;
+            volatile uint32_t *m_ctrl = nullptr;
+            volatile uint32_t *m_pad = nullptr;
+            uint32_t m_bit = 0;
+            uint32_t m_gpio = 0;
+            uint32_t m_bank = 0;
+            uint32_t m_index = 0;
+        };
+
+        RP1IO(std::shared_ptr<CTracer> tracer, eRp1Backend backend = eRp1Backend::Auto);
         virtual ~RP1IO();
 
         uint32_t getGpioStatus(uint32_t pin);
@@ -83,12 +206,50 @@ namespace SB::RPI5
         bool SetPulse(int pin, int widthus, int LeadPulseTimeUs, int PostPulseTimeUs, eRp1IoPulseType tp, bool bListen);
         bool FastClock(int pin, int periods);
 
+        // Shadow of RIO Out/OE for the pins in mask. While enabled the masked
+        // writes (setGpioPinMasked, setDirMaskValue) on those pins are a single
+        // XOR alias write without reading the RP1 first. Writes by others to
+        // these pins (other processes, Fast handles) are only seen after
+        // resyncShadow() or the periodic resync every resyncEvery writes.
+        bool enableShadow(uint32_t mask, uint32_t resyncEvery = 0);
+        void disableShadow();
+        bool resyncShadow();
+        bool isShadowEnabled() const { return m_shadow.enabled; }
+
+        // Fast handle for the bank 0 pins in mask; invalid (valid() == false)
+        // when the registers are not mapped or mask has pins outside bank 0.
+        Fast fast(uint32_t mask);
+        // Handle for GPIO0..53 on any bank; invalid when the registers are not
+        // mapped or gpio is not an RP1 pin.
+        Pin pin(uint32_t gpio);
+        // Logical port over bank 0 pins, bit i = pins[i] (include RP1Port.h);
+        // invalid for pins outside bank 0, duplicates or more than 32 pins.
+        RP1Port port(const std::vector<uint32_t>& pins);
+
+        // GPIO/PAD/RIO state of all banks in one pass
+        bool snapshot(RP1Snapshot_t& snap);
+        // Validate the profile, plan it on a snapshot and, with bWrite, program
+        // the bank 0 registers that change in one pass. Validation and plan
+        // problems end up in errors and nothing is written.
+        bool applyProfile(const RP1PinProfile_t& profile, RP1ProfileResult_t& result, bool bWrite,
+                          std::vector<std::string>& errors);
+
+        // RC charge time through RIO: discharge with the pin driven low, then
+        // release it (input, no pulls) and wait for InSync to read high with
+        // RP1Wait. us from the release to the first high read, -1 on timeout.
+        int measRC(uint32_t pin, uint64_t dischargeUs, uint64_t timeoutUs, RP1WaitResult_t& result,
+                   std::vector<std::string>& errors);
+
     private:
         RP1_GPIO_Regs_t* GPIOBase();
         RP1_Regs_t* RioBase();
         RP1_Regs_t* RioXor();
         RP1_Regs_t* RioSet();
        RP1_Regs_t* RioClear();
+
+        RP1RioShadow_t m_shadow = {};
+        bool shadowCovers(uint32_t mask) const { return m_shadow.enabled && ((mask & ~m_shadow.mask) == 0); }
+        void shadowWritten();
     };
 
 